@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Minimal in-tree benchmark harness. A benchmark body runs state.iterations()
+// operations; the driver grows the iteration count until a run takes
+// min_time, then repeats it and reports the median.
+namespace elf::bench {
+  class State {
+  public:
+    explicit State(size_t iterations) : _iterations(iterations) {}
+
+    size_t iterations() const { return _iterations; }
+    // items processed per iteration, for bulk kernels; reported as ns/item
+    void set_items_per_iteration(size_t items) { _items = items; }
+    size_t items_per_iteration() const { return _items; }
+
+  private:
+    size_t _iterations;
+    size_t _items = 1;
+  };
+
+  using BenchmarkFn = void (*)(State&);
+  int register_benchmark(const char* name, BenchmarkFn fn);
+
+  template <typename T>
+  inline void
+  do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+}
+
+#define ELF_BENCHMARK(name)                                             \
+  static void bench_##name(elf::bench::State& state);                   \
+  static int bench_##name##_registered =                                \
+    elf::bench::register_benchmark(#name, bench_##name);                \
+  static void bench_##name(elf::bench::State& state)
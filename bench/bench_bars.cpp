@@ -0,0 +1,109 @@
+#include "bench.h"
+#include "elf_bars.h"
+
+#include <random>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 14;
+
+  const std::vector<timestamp_t>&
+  tick_times() {
+    static const std::vector<timestamp_t> rows = [] {
+      std::mt19937_64 rng(17);
+      std::vector<timestamp_t> out;
+      timestamp_t t = Date(20220304).to_days() * TimeConstants::ticks_per_day + Timestamp("09:30:00").get();
+      for(size_t i = 0; i < n_rows; ++i) {
+        t += rng() % 20000;
+        out.push_back(t);
+      }
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<double>&
+  prices() {
+    static const std::vector<double> rows = [] {
+      std::mt19937 rng(17);
+      std::vector<double> out;
+      for(size_t i = 0; i < n_rows; ++i)
+        out.push_back(100.0 + (rng() % 5000) / 100.0);
+      return out;
+    }();
+    return rows;
+  }
+
+  // the divisor is only known at run time, as with a user-chosen bar width
+  Timedelta
+  bar_width() {
+    static volatile timedelta_t width = TimeConstants::ticks_per_minute;
+    return Timedelta(width);
+  }
+}
+
+ELF_BENCHMARK(bucket_ids) {
+  auto& ts = tick_times();
+  std::vector<uint64_t> ids(n_rows);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    bucket_ids(ts.data(), n_rows, bar_width(), ids.data());
+    do_not_optimize(ids);
+  }
+}
+
+ELF_BENCHMARK(bucket_ids_divide) {
+  auto& ts = tick_times();
+  std::vector<uint64_t> ids(n_rows);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const uint64_t width = bar_width()._td;
+    for(size_t j = 0; j < n_rows; ++j)
+      ids[j] = static_cast<uint64_t>(ts[j]) / width;
+    do_not_optimize(ids);
+  }
+}
+
+ELF_BENCHMARK(bucket_runs_ohlcv) {
+  auto& ts = tick_times();
+  auto& price = prices();
+  std::vector<BucketRun> runs;
+  std::vector<OhlcvBar<double>> bars(n_rows);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    runs.clear();
+    const size_t n_runs = bucket_runs(ts.data(), n_rows, bar_width(), runs);
+    aggregate_ohlcv(runs.data(), n_runs, price.data(), price.data(), bars.data());
+    do_not_optimize(bars);
+  }
+}
+
+// per-row division and a group-by on the bucket id
+ELF_BENCHMARK(bucket_ohlcv_divide) {
+  auto& ts = tick_times();
+  auto& price = prices();
+  std::vector<OhlcvBar<double>> bars(n_rows);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const uint64_t width = bar_width()._td;
+    size_t n_bars = 0;
+    uint64_t current = ~uint64_t(0);
+    for(size_t j = 0; j < n_rows; ++j) {
+      const uint64_t id = static_cast<uint64_t>(ts[j]) / width;
+      if(id != current) {
+        current = id;
+        bars[n_bars++] = { static_cast<timestamp_t>(id * width), price[j], price[j], price[j], price[j], 0, 0 };
+      }
+      OhlcvBar<double>& bar = bars[n_bars - 1];
+      bar.high = std::max(bar.high, price[j]);
+      bar.low = std::min(bar.low, price[j]);
+      bar.close = price[j];
+      bar.volume += price[j];
+      ++bar.count;
+    }
+    do_not_optimize(bars);
+  }
+}
@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "elf_calendar.h"
+
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 12;
+
+  const TradingCalendar&
+  calendar() {
+    static const TradingCalendar cal = [] {
+      std::vector<date_t> holidays;
+      for(int32_t year = 1990; year < 2090; ++year)
+        for(int32_t md: { 101, 704, 1225 })
+          holidays.push_back(year * 10000 + md);
+      return TradingCalendar(holidays);
+    }();
+    return cal;
+  }
+
+  const std::vector<Date>&
+  dates() {
+    static const std::vector<Date> rows = [] {
+      std::mt19937 rng(16);
+      std::vector<Date> out;
+      for(size_t i = 0; i < n_rows; ++i)
+        out.push_back(Date(20000101).add_days(rng() % 20000));
+      return out;
+    }();
+    return rows;
+  }
+
+  // what scripts do today: walk the days with a holiday set
+  bool
+  naive_trading_day(const std::set<date_t>& holidays, const Date& d) {
+    const int32_t wd = d.weekday();
+    return wd != 0 && wd != 6 && !holidays.count(d.to_int());
+  }
+
+  const std::set<date_t>&
+  naive_holidays() {
+    static const std::set<date_t> holidays = [] {
+      std::set<date_t> out;
+      for(int32_t year = 1990; year < 2090; ++year)
+        for(int32_t md: { 101, 704, 1225 })
+          out.insert(year * 10000 + md);
+      return out;
+    }();
+    return holidays;
+  }
+}
+
+ELF_BENCHMARK(calendar_next) {
+  auto& rows = dates();
+  auto& cal = calendar();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(cal.next(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(calendar_add_20) {
+  auto& rows = dates();
+  auto& cal = calendar();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(cal.add(rows[i % n_rows], -20));
+}
+
+ELF_BENCHMARK(calendar_add_20_naive) {
+  auto& rows = dates();
+  auto& holidays = naive_holidays();
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    Date d = rows[i % n_rows];
+    for(int k = 0; k < 20; ++k) {
+      do d = d.add_days(-1); while(!naive_trading_day(holidays, d));
+    }
+    do_not_optimize(d);
+  }
+}
+
+ELF_BENCHMARK(calendar_count_year) {
+  auto& rows = dates();
+  auto& cal = calendar();
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const Date& d = rows[i % n_rows];
+    do_not_optimize(cal.count(d, d.add_days(365)));
+  }
+}
+
+ELF_BENCHMARK(calendar_count_year_naive) {
+  auto& rows = dates();
+  auto& holidays = naive_holidays();
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const Date& from = rows[i % n_rows];
+    int32_t n = 0;
+    for(Date d = from; d.to_days() < from.to_days() + 365; d = d.add_days(1))
+      n += naive_trading_day(holidays, d);
+    do_not_optimize(n);
+  }
+}
@@ -0,0 +1,43 @@
+#include "bench.h"
+#include "elf_clock.h"
+
+#include <ctime>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  // constructed once so tsc calibration stays out of the timed runs
+  void
+  bench_clock(State& state, ClockSource source) {
+    static Clock clocks[] = { Clock(ClockSource::realtime), Clock(ClockSource::monotonic_raw), Clock(ClockSource::tsc) };
+    Clock& clock = clocks[static_cast<int>(source)];
+    for(size_t i = 0; i < state.iterations(); ++i)
+      do_not_optimize(clock.now());
+  }
+}
+
+ELF_BENCHMARK(clock_gettime_realtime) {
+  struct timespec ts;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    do_not_optimize(ts);
+  }
+}
+
+ELF_BENCHMARK(get_rt_timestamp) {
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(get_rt_timestamp(0));
+}
+
+ELF_BENCHMARK(clock_realtime) {
+  bench_clock(state, ClockSource::realtime);
+}
+
+ELF_BENCHMARK(clock_monotonic_raw) {
+  bench_clock(state, ClockSource::monotonic_raw);
+}
+
+ELF_BENCHMARK(clock_tsc) {
+  bench_clock(state, ClockSource::tsc);
+}
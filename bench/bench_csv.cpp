@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "elf_csv.h"
+#include "elf_util.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 18;
+
+  // date,time,symbol,qty,price,exchange rows, removed at exit
+  struct QuoteFile {
+    std::string path = "/tmp/elf_bench_csv_" + std::to_string(::getpid()) + ".csv";
+
+    QuoteFile() {
+      std::mt19937 rng(24);
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      char ts[Timestamp::max_str_len];
+      for(size_t i = 0; i < n_rows; ++i) {
+        const size_t len = Timestamp(Timestamp("09:30:00").get() + i * 89000 + rng() % 1000).format_to(ts);
+        out << "20220203," << std::string(ts, len) << ",SYM" << rng() % 500 << ',' << rng() % 5000
+            << ',' << rng() % 100000 << '.' << rng() % 100 << ",NASDAQ\n";
+      }
+    }
+    ~QuoteFile() { std::remove(path.c_str()); }
+  };
+
+  const std::string&
+  quote_path() {
+    static const QuoteFile file;
+    return file.path;
+  }
+
+  const std::vector<CsvColumn> quote_columns = {
+    { 0, ColumnType::date }, { 1, ColumnType::timestamp }, { 3, ColumnType::int64 }, { 4, ColumnType::float64 },
+  };
+}
+
+ELF_BENCHMARK(csv_reader_columns) {
+  const std::string& path = quote_path();
+  state.set_items_per_iteration(n_rows);
+  CsvChunk chunk;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    CsvReader reader(path, quote_columns);
+    while(reader.next(chunk))
+      do_not_optimize(chunk.column<double>(3)[0]);
+  }
+}
+
+// what loaders do today: getline, split into strings, parse each field
+ELF_BENCHMARK(csv_getline_split) {
+  const std::string& path = quote_path();
+  state.set_items_per_iteration(n_rows);
+  std::vector<date_t> dates;
+  std::vector<timestamp_t> ts;
+  std::vector<int64_t> qty;
+  std::vector<double> price;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    dates.clear();
+    ts.clear();
+    qty.clear();
+    price.clear();
+    std::ifstream in(path);
+    std::string line;
+    std::vector<std::string> fields;
+    while(std::getline(in, line)) {
+      fields.clear();
+      size_t begin = 0;
+      for(size_t end; (end = line.find(',', begin)) != std::string::npos; begin = end + 1)
+        fields.push_back(line.substr(begin, end - begin));
+      fields.push_back(line.substr(begin));
+      dates.push_back(Date(fields[0]).to_int());
+      ts.push_back(Timestamp(fields[1]).get());
+      int64_t q;
+      substring_atoi(fields[3].data(), fields[3].size(), q);
+      qty.push_back(q);
+      double p;
+      substring_atod(fields[4].data(), fields[4].size(), p);
+      price.push_back(p);
+    }
+    do_not_optimize(price);
+  }
+}
+
+ELF_BENCHMARK(csv_reader_scan_only) {
+  const std::string& path = quote_path();
+  state.set_items_per_iteration(n_rows);
+  CsvChunk chunk;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    CsvReader reader(path, {});
+    while(reader.next(chunk))
+      do_not_optimize(chunk.rows());
+  }
+}
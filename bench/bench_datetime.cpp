@@ -0,0 +1,91 @@
+#include "bench.h"
+#include "elf_datetime.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 16;
+  constexpr timestamp_t tps = TimeConstants::ticks_per_second;
+
+  // instants spread over 2000-2040
+  const std::vector<timestamp_t>&
+  utc_instants() {
+    static const std::vector<timestamp_t> rows = [] {
+      std::mt19937_64 rng(15);
+      const timestamp_t begin = Date(20000101).to_days() * TimeConstants::ticks_per_day;
+      const timestamp_t span = 40 * 365 * TimeConstants::ticks_per_day;
+      std::vector<timestamp_t> out(n_rows);
+      for(auto& t: out)
+        t = begin + rng() % span;
+      return out;
+    }();
+    return rows;
+  }
+
+  const TimeZone&
+  new_york() {
+    static const TimeZone& zone = [] () -> const TimeZone& {
+      ::setenv("TZ", "America/New_York", 1);
+      ::tzset();
+      return TimeZone::get("America/New_York");
+    }();
+    return zone;
+  }
+}
+
+ELF_BENCHMARK(timezone_to_local) {
+  auto& rows = utc_instants();
+  const TimeZone& zone = new_york();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(zone.to_local(DateTime(rows[i % n_rows])));
+}
+
+ELF_BENCHMARK(timezone_to_local_localtime_r) {
+  auto& rows = utc_instants();
+  new_york();
+  struct tm tm;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const time_t t = rows[i % n_rows] / tps;
+    ::localtime_r(&t, &tm);
+    do_not_optimize(tm);
+  }
+}
+
+ELF_BENCHMARK(timezone_to_utc) {
+  auto& rows = utc_instants();
+  const TimeZone& zone = new_york();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(zone.to_utc(DateTime(rows[i % n_rows])));
+}
+
+ELF_BENCHMARK(timezone_to_utc_mktime) {
+  auto& rows = utc_instants();
+  new_york();
+  std::vector<struct tm> local(n_rows);
+  for(size_t i = 0; i < n_rows; ++i) {
+    const time_t t = rows[i] / tps;
+    ::gmtime_r(&t, &local[i]);
+    local[i].tm_isdst = -1;
+  }
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    struct tm tm = local[i % n_rows];
+    do_not_optimize(::mktime(&tm));
+  }
+}
+
+ELF_BENCHMARK(timezone_to_local_bulk) {
+  auto& rows = utc_instants();
+  const TimeZone& zone = new_york();
+  std::vector<timestamp_t> out(n_rows);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    zone.to_local(rows.data(), n_rows, out.data());
+    do_not_optimize(out);
+  }
+}
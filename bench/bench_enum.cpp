@@ -0,0 +1,157 @@
+#include "bench.h"
+#include "boost_enum.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace elf::bench;
+
+namespace {
+  BOOST_ENUM(Side, (Buy)(Sell)(SellShort)(SellShortExempt))
+
+  BOOST_ENUM_VALUES(Exchange, int,
+    (AMEX)(1)(ARCA)(2)(BATS)(3)(BATY)(4)(BOX)(5)(C2)(6)(CBOE)(7)(CHX)(8)
+    (EDGA)(9)(EDGX)(10)(EMLD)(11)(GEMX)(12)(IEX)(13)(ISE)(14)(LTSE)(15)(MCRY)(16)
+    (MEMX)(17)(MIAX)(18)(MPRL)(19)(NASDAQ)(20)(NQBX)(21)(NQPX)(22)(NSX)(23)(NYSE)(24)
+    (PHLX)(25)(PSX)(26)(SAPPHIRE)(27)(OTC)(28)(FINRA)(29)(CME)(30)(CBOT)(31)(NYMEX)(32))
+
+  BOOST_BITFIELD(Condition,
+    (Regular)(0x1)(Cash)(0x2)(NextDay)(0x4)(Seller)(0x8)(Intermarket)(0x10)(Opening)(0x20)
+    (Closing)(0x40)(Reopening)(0x80)(Derivative)(0x100)(OddLot)(0x200)(Corrected)(0x400)
+    (Extended)(0x800)(OutOfSequence)(0x1000)(Qualified)(0x2000)(Contingent)(0x4000))
+
+  constexpr size_t n_rows = 1 << 12;
+
+  // up to four conditions per print
+  const std::vector<uint64_t>&
+  condition_bits() {
+    static std::vector<uint64_t> rows;
+    if(rows.empty()) {
+      std::mt19937 rng(8);
+      for(size_t i = 0; i < n_rows; ++i) {
+        uint64_t bits = 0;
+        for(unsigned k = rng() % 5; k > 0; --k)
+          bits |= uint64_t(1) << (rng() % Condition::size);
+        rows.push_back(bits);
+      }
+    }
+    return rows;
+  }
+
+  const std::vector<std::string>&
+  condition_strings() {
+    static std::vector<std::string> rows;
+    if(rows.empty())
+      for(uint64_t bits: condition_bits())
+        rows.push_back(Condition::get_by_value(bits)->str());
+    return rows;
+  }
+
+  template <typename E>
+  const std::vector<std::string>&
+  names(bool lower) {
+    static std::vector<std::string> rows[2];
+    auto& out = rows[lower];
+    if(out.empty()) {
+      std::mt19937 rng(8);
+      for(size_t i = 0; i < n_rows; ++i) {
+        std::string name = E(static_cast<typename E::domain>(rng() % E::size)).str();
+        if(lower)
+          for(auto& c: name)
+            c = std::tolower(c);
+        out.push_back(name);
+      }
+    }
+    return out;
+  }
+}
+
+ELF_BENCHMARK(enum_side_get_by_string) {
+  auto& rows = names<Side>(false);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Side::get_by_string(rows[i % n_rows].c_str()));
+}
+
+ELF_BENCHMARK(enum_exchange_get_by_string) {
+  auto& rows = names<Exchange>(false);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange::get_by_string(rows[i % n_rows].c_str()));
+}
+
+ELF_BENCHMARK(enum_exchange_get_by_istring) {
+  auto& rows = names<Exchange>(true);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange::get_by_istring(rows[i % n_rows].c_str()));
+}
+
+ELF_BENCHMARK(enum_exchange_get_by_name) {
+  auto& rows = names<Exchange>(false);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange::get_by_name(rows[i % n_rows].c_str()));
+}
+
+ELF_BENCHMARK(enum_exchange_get_by_value) {
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange::get_by_value(1 + i % Exchange::size));
+}
+
+ELF_BENCHMARK(enum_exchange_value_str) {
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    const Exchange e(static_cast<Exchange::domain>(i % Exchange::size));
+    do_not_optimize(e.value());
+    do_not_optimize(e.str());
+  }
+}
+
+ELF_BENCHMARK(enum_exchange_less) {
+  const Exchange a(Exchange::NYSE);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange(static_cast<Exchange::domain>(i % Exchange::size)) < a);
+}
+
+ELF_BENCHMARK(enum_exchange_get_by_string_view) {
+  auto& rows = names<Exchange>(false);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Exchange::get_by_string(std::string_view(rows[i % n_rows])));
+}
+
+ELF_BENCHMARK(enum_exchange_sort) {
+  std::vector<Exchange> rows;
+  std::mt19937 rng(8);
+  for(size_t i = 0; i < n_rows; ++i)
+    rows.push_back(Exchange(static_cast<Exchange::domain>(rng() % Exchange::size)));
+  std::vector<Exchange> sorted;
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    sorted = rows;
+    std::sort(sorted.begin(), sorted.end());
+    do_not_optimize(sorted);
+  }
+}
+
+ELF_BENCHMARK(bitfield_condition_parse) {
+  auto& rows = condition_strings();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Condition::parse(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(bitfield_condition_format) {
+  auto& rows = condition_bits();
+  char buf[256];
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    do_not_optimize(Condition::get_by_value(rows[i % n_rows])->format(buf, sizeof(buf)));
+    do_not_optimize(buf);
+  }
+}
+
+ELF_BENCHMARK(bitfield_condition_flags) {
+  auto& rows = condition_bits();
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    size_t sum = 0;
+    for(const Condition& c: Condition::get_by_value(rows[i % n_rows])->flags())
+      sum += c.value();
+    do_not_optimize(sum);
+  }
+}
@@ -0,0 +1,176 @@
+#include "bench.h"
+#include "elf_util.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fmt/format.h>
+#include <fmt/os.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  struct Benchmark {
+    const char* name;
+    bench::BenchmarkFn fn;
+  };
+
+  struct Result {
+    string name;
+    size_t iterations;
+    size_t items;
+    double ns_per_op;
+    double min_ns_per_op;
+  };
+
+  vector<Benchmark>&
+  registry() {
+    static vector<Benchmark> benchmarks;
+    return benchmarks;
+  }
+
+  double
+  run_once(const Benchmark& b, size_t iterations, size_t& items) {
+    bench::State state(iterations);
+    const auto start = chrono::steady_clock::now();
+    b.fn(state);
+    const auto end = chrono::steady_clock::now();
+    items = state.items_per_iteration();
+    return chrono::duration<double, nano>(end - start).count();
+  }
+
+  Result
+  run(const Benchmark& b, double min_time_ns, int repetitions) {
+    size_t items = 1;
+    size_t iterations = 1;
+    double elapsed = run_once(b, iterations, items);
+    while(elapsed < min_time_ns) {
+      const double scale = elapsed > 0 ? std::min(10.0, 1.4 * min_time_ns / elapsed) : 10.0;
+      iterations = std::max(iterations + 1, static_cast<size_t>(iterations * scale));
+      elapsed = run_once(b, iterations, items);
+    }
+
+    vector<double> samples{elapsed / iterations};
+    for(int i = 1; i < repetitions; ++i)
+      samples.push_back(run_once(b, iterations, items) / iterations);
+    sort(samples.begin(), samples.end());
+    return Result{b.name, iterations, items, samples[samples.size() / 2], samples.front()};
+  }
+
+  const char*
+  simd_level_name() {
+    switch(simd_level()) {
+    case SimdLevel::avx2: return "avx2";
+    case SimdLevel::sse42: return "sse4.2";
+    default: return "scalar";
+    }
+  }
+
+  void
+  write_json(const string& path, const vector<Result>& results) {
+    auto out = fmt::output_file(path);
+    const time_t now = ::time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    out.print("{{\n  \"context\": {{\"date\": \"{}\", \"buildmode\": \"{}\", \"version\": \"{}\", \"simd_level\": \"{}\"}},\n",
+              date, BUILDMODE, VERSION, simd_level_name());
+    out.print("  \"benchmarks\": [\n");
+    for(size_t i = 0; i < results.size(); ++i) {
+      const Result& r = results[i];
+      out.print("    {{\"name\": \"{}\", \"iterations\": {}, \"items_per_iteration\": {}, "
+                "\"ns_per_op\": {:.3f}, \"min_ns_per_op\": {:.3f}, \"ns_per_item\": {:.4f}}}{}\n",
+                r.name, r.iterations, r.items, r.ns_per_op, r.min_ns_per_op, r.ns_per_op / r.items,
+                i + 1 < results.size() ? "," : "");
+    }
+    out.print("  ]\n}}\n");
+  }
+
+  // returns the number of benchmarks slower than baseline by more than max_regression
+  int
+  compare(const string& path, const vector<Result>& results, double max_regression) {
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(path, tree);
+    map<string, double> baseline;
+    for(auto& b: tree.get_child("benchmarks"))
+      baseline[b.second.get<string>("name")] = b.second.get<double>("ns_per_op");
+
+    int regressions = 0;
+    fmt::print("\n{:<40} {:>12} {:>12} {:>8}\n", "benchmark", "baseline ns", "current ns", "change");
+    for(auto& r: results) {
+      auto it = baseline.find(r.name);
+      if(it == baseline.end())
+        continue;
+      const double change = (r.ns_per_op - it->second) / it->second;
+      const bool regressed = change > max_regression;
+      regressions += regressed;
+      fmt::print("{:<40} {:>12.2f} {:>12.2f} {:>+7.1f}%{}\n", r.name, it->second, r.ns_per_op, 100 * change,
+                 regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+  }
+
+  void
+  usage(const char* prog) {
+    fmt::print(stderr,
+               "usage: {} [--filter SUBSTR] [--min-time SEC] [--repetitions N]\n"
+               "          [--json FILE] [--baseline FILE] [--max-regression PCT]\n", prog);
+  }
+}
+
+int
+bench::register_benchmark(const char* name, BenchmarkFn fn) {
+  registry().push_back(Benchmark{name, fn});
+  return 0;
+}
+
+int
+main(int argc, char** argv) {
+  string filter, json, baseline;
+  double min_time = 0.2;
+  int repetitions = 5;
+  double max_regression = 0.10;
+
+  for(int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if(!strcmp(argv[i], "--filter") && has_value) filter = argv[++i];
+    else if(!strcmp(argv[i], "--min-time") && has_value) min_time = atof(argv[++i]);
+    else if(!strcmp(argv[i], "--repetitions") && has_value) repetitions = std::max(1, atoi(argv[++i]));
+    else if(!strcmp(argv[i], "--json") && has_value) json = argv[++i];
+    else if(!strcmp(argv[i], "--baseline") && has_value) baseline = argv[++i];
+    else if(!strcmp(argv[i], "--max-regression") && has_value) max_regression = atof(argv[++i]) / 100;
+    else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  auto& benchmarks = registry();
+  sort(benchmarks.begin(), benchmarks.end(),
+       [](const Benchmark& a, const Benchmark& b) { return strcmp(a.name, b.name) < 0; });
+
+  fmt::print("{:<40} {:>12} {:>12} {:>12}\n", "benchmark", "ns/op", "ns/item", "iterations");
+  vector<Result> results;
+  for(auto& b: benchmarks) {
+    if(!filter.empty() && !strstr(b.name, filter.c_str()))
+      continue;
+    results.push_back(run(b, min_time * 1e9, repetitions));
+    const Result& r = results.back();
+    fmt::print("{:<40} {:>12.2f} {:>12.3f} {:>12}\n", r.name, r.ns_per_op, r.ns_per_op / r.items, r.iterations);
+    fflush(stdout);
+  }
+
+  if(!json.empty())
+    write_json(json, results);
+  if(!baseline.empty())
+    return compare(baseline, results, max_regression) ? 1 : 0;
+  return 0;
+}
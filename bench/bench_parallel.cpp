@@ -0,0 +1,95 @@
+#include "bench.h"
+#include "elf_parallel.h"
+#include "elf_util.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 20;
+
+  // offset-indexed timestamps and prices as a loader would hand them over
+  struct Fields {
+    std::string ts_buf, price_buf;
+    std::vector<uint32_t> ts_offsets{0}, price_offsets{0};
+
+    Fields() {
+      std::mt19937 rng(25);
+      char ts[Timestamp::max_str_len];
+      for(size_t i = 0; i < n_rows; ++i) {
+        ts_buf.append(ts, Timestamp(rng() % TimeConstants::ticks_per_day).format_to(ts));
+        ts_offsets.push_back(ts_buf.size());
+        price_buf += std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100);
+        price_offsets.push_back(price_buf.size());
+      }
+    }
+  };
+
+  const Fields&
+  fields() {
+    static const Fields f;
+    return f;
+  }
+
+  template <typename T, typename Convert>
+  void
+  run_bench(State& state, Convert convert) {
+    state.set_items_per_iteration(n_rows);
+    std::vector<T> out(n_rows);
+    std::vector<uint64_t> bad((n_rows + 63) / 64);
+    for(size_t i = 0; i < state.iterations(); ++i)
+      do_not_optimize(convert(out.data(), bad.data()));
+  }
+
+  // one executor per thread count, built like fields() on the first,
+  // calibrating run and reused by the measured ones, so pool start-up and
+  // thread teardown stay out of the timings
+  template <unsigned threads>
+  Executor&
+  executor() {
+    static Executor e(threads);
+    return e;
+  }
+
+  // no executor is the single-threaded call
+  void
+  timestamps(State& state, Executor* executor) {
+    const Fields& f = fields();
+    if(!executor)
+      return run_bench<timestamp_t>(state, [&](timestamp_t* out, uint64_t* bad) {
+        return convert_timestamps(f.ts_buf.data(), f.ts_offsets.data(), n_rows, out, bad);
+      });
+    run_bench<timestamp_t>(state, [&](timestamp_t* out, uint64_t* bad) {
+      return convert_timestamps(f.ts_buf.data(), f.ts_offsets.data(), n_rows, out, bad, *executor);
+    });
+  }
+
+  void
+  doubles(State& state, Executor* executor) {
+    const Fields& f = fields();
+    if(!executor)
+      return run_bench<double>(state, [&](double* out, uint64_t* bad) {
+        return convert_doubles(f.price_buf.data(), f.price_offsets.data(), n_rows, out, bad);
+      });
+    run_bench<double>(state, [&](double* out, uint64_t* bad) {
+      return convert_doubles(f.price_buf.data(), f.price_offsets.data(), n_rows, out, bad, *executor);
+    });
+  }
+}
+
+// serial is the single-threaded call, for the executor's overhead at 1
+ELF_BENCHMARK(parallel_timestamps_serial) { timestamps(state, nullptr); }
+ELF_BENCHMARK(parallel_timestamps_1) { timestamps(state, &executor<1>()); }
+ELF_BENCHMARK(parallel_timestamps_2) { timestamps(state, &executor<2>()); }
+ELF_BENCHMARK(parallel_timestamps_4) { timestamps(state, &executor<4>()); }
+ELF_BENCHMARK(parallel_timestamps_8) { timestamps(state, &executor<8>()); }
+
+ELF_BENCHMARK(parallel_doubles_serial) { doubles(state, nullptr); }
+ELF_BENCHMARK(parallel_doubles_1) { doubles(state, &executor<1>()); }
+ELF_BENCHMARK(parallel_doubles_2) { doubles(state, &executor<2>()); }
+ELF_BENCHMARK(parallel_doubles_4) { doubles(state, &executor<4>()); }
+ELF_BENCHMARK(parallel_doubles_8) { doubles(state, &executor<8>()); }
@@ -0,0 +1,315 @@
+#include "bench.h"
+#include "elf_exception.h"
+#include "elf_time.h"
+
+#include <fmt/format.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 16;
+
+  // intra-day tick times between 04:00 and 20:00, as a feed would carry them
+  const std::vector<timestamp_t>&
+  tick_times() {
+    static const std::vector<timestamp_t> rows = [] {
+      std::mt19937_64 rng(1);
+      std::uniform_int_distribution<timestamp_t> dist(4 * TimeConstants::ticks_per_hour, 20 * TimeConstants::ticks_per_hour);
+      std::vector<timestamp_t> out(n_rows);
+      for(auto& ts: out)
+        ts = dist(rng);
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<std::string>&
+  tick_strings() {
+    static const std::vector<std::string> rows = [] {
+      std::vector<std::string> out;
+      for(auto ts: tick_times())
+        out.push_back(Timestamp(ts).str());
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<std::string>&
+  go_strings() {
+    static const std::vector<std::string> rows = [] {
+      std::vector<std::string> out;
+      for(auto& s: tick_strings())
+        out.push_back("20220203-" + s.substr(0, 2) + s.substr(3, 2) + s.substr(6));
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<std::string>&
+  timedelta_strings() {
+    static const std::vector<std::string> rows = [] {
+      const char* units[] = { "usec", "msec", "sec", "min", "hour" };
+      std::mt19937 rng(2);
+      std::vector<std::string> out;
+      for(size_t i = 0; i < n_rows; ++i) {
+        if(i % 6 == 5)
+          out.push_back(Timestamp(tick_times()[i]).str());
+        else
+          out.push_back((rng() % 2 ? "-" : "") + std::to_string(rng() % 1000) + units[i % 5]);
+      }
+      return out;
+    }();
+    return rows;
+  }
+
+  // tick times with 5% malformed rows, as some vendor files carry
+  const std::vector<std::string>&
+  dirty_tick_strings() {
+    static const std::vector<std::string> rows = [] {
+      std::mt19937 rng(4);
+      std::vector<std::string> out = tick_strings();
+      for(auto& s: out) {
+        if(rng() % 20 == 0)
+          s[rng() % s.size()] = 'x';
+      }
+      return out;
+    }();
+    return rows;
+  }
+
+  // mostly valid dates over 50 years with some garbage mixed in
+  const std::vector<date_t>&
+  dates() {
+    static const std::vector<date_t> rows = [] {
+      std::mt19937 rng(3);
+      std::vector<date_t> out(n_rows);
+      for(auto& d: out)
+        d = rng() % 16 ? date_from_days(rng() % 18262) : rng() % 100000000;
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<std::string>&
+  file_names() {
+    static const std::vector<std::string> rows = [] {
+      std::vector<std::string> out;
+      for(auto d: dates())
+        if(validate_date(d))
+          out.push_back(fmt::format("/data/vendor/opra/quotes/opra.quotes.{}.v2.csv.gz", d));
+      return out;
+    }();
+    return rows;
+  }
+
+  const std::vector<timedelta_t>&
+  timedeltas() {
+    static const std::vector<timedelta_t> rows = [] {
+      std::mt19937_64 rng(4);
+      std::vector<timedelta_t> out(n_rows);
+      for(size_t i = 0; i < n_rows; ++i)
+        out[i] = static_cast<timedelta_t>(rng() % (2 * TimeConstants::ticks_per_hour)) >> (rng() % 30);
+      return out;
+    }();
+    return rows;
+  }
+}
+
+ELF_BENCHMARK(timestamp_convert) {
+  auto& rows = tick_strings();
+  Timestamp ts;
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(ts.convert(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(timestamp_convert_dirty) {
+  auto& rows = dirty_tick_strings();
+  Timestamp ts;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    try {
+      do_not_optimize(ts.convert(rows[i % n_rows]));
+    } catch(const elf_error&) {
+      do_not_optimize(i);
+    }
+  }
+}
+
+ELF_BENCHMARK(timestamp_try_parse_dirty) {
+  auto& rows = dirty_tick_strings();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timestamp::try_parse(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(timestamp_convert_days) {
+  const std::string row = "3D09:44:00.123456";
+  Timestamp ts;
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(ts.convert(row));
+}
+
+ELF_BENCHMARK(timestamp_from_go_ts) {
+  auto& rows = go_strings();
+  Timestamp ts;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    ts.from_go_ts(rows[i % n_rows]);
+    do_not_optimize(ts);
+  }
+}
+
+ELF_BENCHMARK(epoch_from_go_ts) {
+  auto& rows = go_strings();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(epoch_from_go_ts(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(convert_go_timestamps) {
+  static const std::string column = [] {
+    std::string out;
+    for(auto& s: go_strings())
+      out += s + ',';
+    return out;
+  }();
+  std::vector<timestamp_t> out(n_rows);
+  std::vector<uint64_t> bad((n_rows + 63) / 64);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    do_not_optimize(convert_go_timestamps(column.data(), go_ts_len + 1, n_rows, out.data(), bad.data()));
+    do_not_optimize(out);
+  }
+}
+
+ELF_BENCHMARK(convert_timestamps_fixed) {
+  static const std::string column = [] {
+    std::string out;
+    for(auto& s: tick_strings())
+      out += s + ',';
+    return out;
+  }();
+  std::vector<timestamp_t> out(n_rows);
+  std::vector<uint64_t> bad(n_rows / 64);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(convert_timestamps(column.data(), 15, 16, n_rows, out.data(), bad.data()));
+}
+
+ELF_BENCHMARK(timedelta_convert) {
+  auto& rows = timedelta_strings();
+  Timedelta td;
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(td.convert(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(validate_date) {
+  auto& rows = dates();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(validate_date(rows[i % n_rows]));
+}
+
+ELF_BENCHMARK(days_from_dates) {
+  auto& rows = dates();
+  std::vector<days_t> out(n_rows);
+  std::vector<uint64_t> bad(n_rows / 64);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(days_from_dates(rows.data(), n_rows, out.data(), bad.data()));
+}
+
+ELF_BENCHMARK(find_date_from_file) {
+  auto& rows = file_names();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(find_date_from_file(rows[i % rows.size()]).to_int());
+}
+
+ELF_BENCHMARK(timestamp_str) {
+  auto& rows = tick_times();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timestamp(rows[i % n_rows]).str());
+}
+
+ELF_BENCHMARK(timestamp_to_hms) {
+  auto& rows = tick_times();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timestamp(rows[i % n_rows]).to_hms());
+}
+
+ELF_BENCHMARK(timestamp_to_hms_msec) {
+  auto& rows = tick_times();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timestamp(rows[i % n_rows]).to_hms_msec());
+}
+
+ELF_BENCHMARK(timestamp_format_to) {
+  auto& rows = tick_times();
+  char buf[Timestamp::max_str_len];
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    do_not_optimize(Timestamp(rows[i % n_rows]).format_to(buf));
+    do_not_optimize(buf);
+  }
+}
+
+ELF_BENCHMARK(timestamp_fmt_format_to) {
+  auto& rows = tick_times();
+  fmt::memory_buffer out;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    out.clear();
+    fmt::format_to(std::back_inserter(out), "{}", Timestamp(rows[i % n_rows]));
+    do_not_optimize(out.data());
+  }
+}
+
+ELF_BENCHMARK(format_timestamps) {
+  auto& rows = tick_times();
+  std::vector<char> out(n_rows * (Timestamp::max_str_len + 1));
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(format_timestamps(rows.data(), n_rows, out.data()));
+}
+
+ELF_BENCHMARK(timedelta_str) {
+  auto& rows = timedeltas();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timedelta(rows[i % n_rows]).str());
+}
+
+ELF_BENCHMARK(timedelta_to_hms) {
+  auto& rows = timedeltas();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(Timedelta(rows[i % n_rows]).to_hms());
+}
+
+ELF_BENCHMARK(timedelta_format_to) {
+  auto& rows = timedeltas();
+  char buf[Timedelta::max_str_len];
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    do_not_optimize(Timedelta(rows[i % n_rows]).format_to(buf));
+    do_not_optimize(buf);
+  }
+}
+
+ELF_BENCHMARK(date_to_string) {
+  static const std::vector<Date> rows = [] {
+    std::vector<Date> out;
+    for(auto d: dates())
+      if(validate_date(d))
+        out.emplace_back(d);
+    return out;
+  }();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(rows[i % rows.size()].to_string());
+}
+
+ELF_BENCHMARK(date_format_to) {
+  auto& rows = dates();
+  char buf[Date::max_str_len];
+  Date d;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    d._d = rows[i % n_rows];
+    do_not_optimize(d.format_to(buf));
+    do_not_optimize(buf);
+  }
+}
@@ -0,0 +1,232 @@
+#include "bench.h"
+#include "elf_util.h"
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace elf;
+using namespace elf::bench;
+
+namespace {
+  constexpr size_t n_rows = 1 << 16;
+
+  // order quantities: mostly small, occasionally large or signed
+  const std::vector<std::string>&
+  int_fields() {
+    static const std::vector<std::string> rows = [] {
+      std::mt19937_64 rng(5);
+      std::vector<std::string> out;
+      for(size_t i = 0; i < n_rows; ++i) {
+        const int64_t v = rng() % 8 ? rng() % 10000 : static_cast<int64_t>(rng() >> 20);
+        out.push_back(std::to_string(i % 16 ? v : -v));
+      }
+      return out;
+    }();
+    return rows;
+  }
+
+  // prices with 2 to 6 decimals
+  const std::vector<std::string>&
+  price_fields() {
+    static const std::vector<std::string> rows = [] {
+      std::mt19937_64 rng(6);
+      std::vector<std::string> out;
+      for(size_t i = 0; i < n_rows; ++i)
+        out.push_back(fmt::format("{:.{}f}", (rng() % 5000000) / 1e4, 2 + rng() % 5));
+      return out;
+    }();
+    return rows;
+  }
+
+  // the pre-rounding substring_atod, kept as the baseline it replaced
+  bool
+  legacy_atod(const char* p, size_t len, double& out) {
+    const char* end = p + len;
+    for(; *p == ' ' && p != end && *p != '\0'; ++p)
+      ;
+    if(p == end || *p == '\0')
+      return false;
+    int sign = 1;
+    if(*p == '+') {
+      ++p;
+    } else if(*p == '-') {
+      sign = -1;
+      ++p;
+    }
+    if(p == end || *p == '\0')
+      return false;
+    uint64_t before = 0;
+    for(; p != end && *p != '\0'; ++p) {
+      if(*p == '.')
+        break;
+      const int digit = *p - '0';
+      if(digit < 0 || digit > 9)
+        return false;
+      before = before * 10 + digit;
+    }
+    if(*p == '.')
+      ++p;
+    uint32_t div = 1;
+    uint64_t after = 0;
+    for(; p != end && *p != '\0'; ++p) {
+      const int digit = *p - '0';
+      if(digit < 0 || digit > 9)
+        return false;
+      after = after * 10 + digit;
+      div *= 10;
+    }
+    out = (before + (after / static_cast<double>(div))) * sign;
+    return true;
+  }
+}
+
+ELF_BENCHMARK(substring_atoi) {
+  auto& rows = int_fields();
+  int64_t n;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    auto& row = rows[i % n_rows];
+    do_not_optimize(substring_atoi(row.data(), row.size(), n));
+    do_not_optimize(n);
+  }
+}
+
+// fixed-width fields, e.g. the hour, microseconds and date of a timestamp,
+// against the runtime-length loop on the same bytes
+template<size_t N>
+const std::vector<std::string>&
+digit_fields() {
+  static const std::vector<std::string> rows = [] {
+    std::mt19937_64 rng(N);
+    std::vector<std::string> out;
+    for(size_t i = 0; i < n_rows; ++i) {
+      std::string s;
+      for(size_t j = 0; j < N; ++j)
+        s += char('0' + rng() % 10);
+      out.push_back(s);
+    }
+    return out;
+  }();
+  return rows;
+}
+
+#define ELF_BENCHMARK_ATOI_FIXED(N)                                     \
+  ELF_BENCHMARK(substring_atoi_loop_##N) {                              \
+    auto& rows = digit_fields<N>();                                     \
+    int64_t n;                                                          \
+    for(size_t i = 0; i < state.iterations(); ++i) {                    \
+      do_not_optimize(substring_atoi(rows[i % n_rows].data(), N, n));   \
+      do_not_optimize(n);                                               \
+    }                                                                   \
+  }                                                                     \
+  ELF_BENCHMARK(substring_atoi_fixed_##N) {                             \
+    auto& rows = digit_fields<N>();                                     \
+    uint64_t n;                                                         \
+    for(size_t i = 0; i < state.iterations(); ++i) {                    \
+      do_not_optimize(substring_atoi<N>(rows[i % n_rows].data(), n));   \
+      do_not_optimize(n);                                               \
+    }                                                                   \
+  }
+
+ELF_BENCHMARK_ATOI_FIXED(2)
+ELF_BENCHMARK_ATOI_FIXED(6)
+ELF_BENCHMARK_ATOI_FIXED(8)
+ELF_BENCHMARK_ATOI_FIXED(16)
+
+ELF_BENCHMARK(substring_atod) {
+  auto& rows = price_fields();
+  double d = 0;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    auto& row = rows[i % n_rows];
+    do_not_optimize(substring_atod(row.data(), row.size(), d));
+    do_not_optimize(d);
+  }
+}
+
+ELF_BENCHMARK(substring_atod_legacy) {
+  auto& rows = price_fields();
+  double d = 0;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    auto& row = rows[i % n_rows];
+    do_not_optimize(legacy_atod(row.data(), row.size(), d));
+    do_not_optimize(d);
+  }
+}
+
+ELF_BENCHMARK(substring_atod_strtod) {
+  auto& rows = price_fields();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(std::strtod(rows[i % n_rows].c_str(), nullptr));
+}
+
+ELF_BENCHMARK(convert_doubles) {
+  static const std::vector<uint32_t> offsets = [] {
+    std::vector<uint32_t> out{0};
+    for(auto& s: price_fields())
+      out.push_back(out.back() + s.size());
+    return out;
+  }();
+  static const std::string column = [] {
+    std::string out;
+    for(auto& s: price_fields())
+      out += s;
+    return out;
+  }();
+  std::vector<double> out(n_rows);
+  std::vector<uint64_t> bad((n_rows + 63) / 64);
+  state.set_items_per_iteration(n_rows);
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    do_not_optimize(convert_doubles(column.data(), offsets.data(), n_rows, out.data(), bad.data()));
+    do_not_optimize(out);
+  }
+}
+
+// prices as 1e-6 ticks, parsed directly and through a double
+ELF_BENCHMARK(substring_atofixed) {
+  auto& rows = price_fields();
+  int64_t n = 0;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    auto& row = rows[i % n_rows];
+    do_not_optimize(substring_atofixed<6>(row.data(), row.size(), n));
+    do_not_optimize(n);
+  }
+}
+
+ELF_BENCHMARK(substring_atofixed_via_atod) {
+  auto& rows = price_fields();
+  double d = 0;
+  for(size_t i = 0; i < state.iterations(); ++i) {
+    auto& row = rows[i % n_rows];
+    do_not_optimize(substring_atod(row.data(), row.size(), d));
+    do_not_optimize(std::llround(d * 1e6));
+  }
+}
+
+const std::vector<uint64_t>&
+digit_count_values() {
+  static const std::vector<uint64_t> rows = [] {
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> out(n_rows);
+    for(auto& v: out)
+      v = rng() >> (rng() % 64);
+    return out;
+  }();
+  return rows;
+}
+
+ELF_BENCHMARK(num_digits) {
+  auto& rows = digit_count_values();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(num_digits(rows[i % n_rows] | 1));
+}
+
+// the log10 version num_digits replaced
+ELF_BENCHMARK(num_digits_log10) {
+  auto& rows = digit_count_values();
+  for(size_t i = 0; i < state.iterations(); ++i)
+    do_not_optimize(static_cast<size_t>(1 + std::floor(std::log10(static_cast<double>(rows[i % n_rows] | 1)))));
+}
@@ -1,14 +1,18 @@
 #pragma once
 
 #include <string.h>
+#include <stdint.h>
 
+#include <algorithm>
 #include <ostream>
 #include <istream>
+#include <string>
 #include <boost/operators.hpp>
 #include <boost/optional.hpp>
 
 #include <boost/iterator/iterator_facade.hpp>
 
+#include <string_view>
 #include <type_traits>
 
 namespace boost {
@@ -88,6 +92,233 @@ namespace detail {
 } // detail
 } // boost
 
+namespace boost {
+namespace detail {
+
+	// ASCII case folding, matching strcasecmp in the C locale
+	constexpr unsigned char enum_fold(char c)
+	{
+		return static_cast<unsigned char>(c - 'A') < 26 ? c + ('a' - 'A') : c;
+	}
+
+	// Rotate-xor over case-folded bytes, so one table serves both the exact
+	// and the case-insensitive lookups. Short names fit in 32 bits almost
+	// losslessly, and a step is two cycles where a multiply chain would
+	// dominate a short name; enum_name_index mixes the result once.
+	constexpr uint32_t enum_hash_basis = 5381;
+
+	constexpr uint32_t enum_hash_step(uint32_t h, char c)
+	{
+		return ((h << 5) | (h >> 27)) ^ enum_fold(c);
+	}
+
+	constexpr bool enum_iequal(std::string_view a, std::string_view b)
+	{
+		if(a.size() != b.size()) return false;
+		for(size_t i = 0; i < a.size(); ++i)
+			if(enum_fold(a[i]) != enum_fold(b[i])) return false;
+		return true;
+	}
+
+	// Open-addressed hash of an enum's names, built at compile time by the
+	// BOOST_ENUM macros. At most half the slots are used and each keeps the
+	// full hash, so a lookup hashes the input once and compares strings
+	// only on a hash match. Names equal up to case share a probe chain in
+	// index order, so the first match is the lowest index, as in a scan.
+	template <size_t N>
+	class enum_name_index
+	{
+	public:
+		static_assert(N < UINT16_MAX, "too many enum values");
+
+		constexpr explicit enum_name_index(const std::string_view (&names)[N])
+			: m_names(names), m_hash(), m_index()
+		{
+			for(size_t i = 0; i < N; ++i)
+			{
+				uint32_t h = enum_hash_basis;
+				for(char c : names[i])
+					h = enum_hash_step(h, c);
+				size_t slot = home(h);
+				while(m_index[slot])
+					slot = (slot + 1) & mask;
+				m_hash[slot] = h;
+				m_index[slot] = static_cast<uint16_t>(i + 1);
+			}
+		}
+
+		// index of the first name matching s, or N; hashes and measures a
+		// NUL-terminated s in one pass
+		template <bool ICase>
+		size_t find(const char* s) const
+		{
+			uint32_t h = enum_hash_basis;
+			const char* p = s;
+			for(; *p; ++p)
+				h = enum_hash_step(h, *p);
+			return probe<ICase>(h, std::string_view(s, p - s));
+		}
+
+		template <bool ICase>
+		size_t find(std::string_view s) const
+		{
+			uint32_t h = enum_hash_basis;
+			for(char c : s)
+				h = enum_hash_step(h, c);
+			return probe<ICase>(h, s);
+		}
+
+	private:
+		static constexpr unsigned bits_for(size_t n)
+		{
+			unsigned bits = 1;
+			while((size_t(1) << bits) < 2 * n)
+				++bits;
+			return bits;
+		}
+
+		static constexpr unsigned bits = bits_for(N);
+		static constexpr size_t slots = size_t(1) << bits;
+		static constexpr size_t mask = slots - 1;
+
+		// top bits of a Fibonacci multiply
+		static constexpr size_t home(uint32_t h)
+		{
+			return static_cast<uint32_t>(h * 2654435769u) >> (32 - bits);
+		}
+
+		template <bool ICase>
+		size_t probe(uint32_t h, std::string_view s) const
+		{
+			for(size_t slot = home(h); m_index[slot]; slot = (slot + 1) & mask)
+			{
+				if(m_hash[slot] != h)
+					continue;
+				const size_t i = m_index[slot] - 1;
+				if(ICase ? enum_iequal(m_names[i], s) : m_names[i] == s)
+					return i;
+			}
+			return N;
+		}
+
+		const std::string_view* m_names;
+		uint32_t m_hash[slots];
+		// index + 1, 0 for an empty slot
+		uint16_t m_index[slots];
+	};
+
+	// Width of the range of integral enum values when small enough to index
+	// directly (at most four slots per value, plus slack), else 0.
+	template <typename V, size_t N>
+	constexpr size_t enum_dense_span(const V (&values)[N])
+	{
+		if constexpr(std::is_integral<V>::value && !std::is_same<V, bool>::value)
+		{
+			typedef typename std::make_unsigned<V>::type unsigned_type;
+			V lo = values[0], hi = values[0];
+			for(size_t i = 1; i < N; ++i)
+			{
+				if(values[i] < lo) lo = values[i];
+				if(hi < values[i]) hi = values[i];
+			}
+			const uint64_t width = static_cast<unsigned_type>(static_cast<unsigned_type>(hi) - static_cast<unsigned_type>(lo));
+			return width < 4 * N + 64 ? width + 1 : 0;
+		}
+		return 0;
+	}
+
+	// Reverse of an enum's value table, built at compile time by the
+	// BOOST_ENUM macros: a direct table over [lo, lo + Span) for dense
+	// integral values, the values sorted with their indexes for a binary
+	// search when they are otherwise arithmetic, else a scan with ==. Other
+	// types (const char* included) need not order in a constant expression.
+	// Either way a repeated value finds its first index.
+	template <typename V, size_t N, size_t Span>
+	class enum_value_index
+	{
+	public:
+		static_assert(N < UINT16_MAX, "too many enum values");
+
+		constexpr explicit enum_value_index(const V (&values)[N])
+			: m_values(values), m_lo(), m_dense(), m_sorted()
+		{
+			if constexpr(Span != 0)
+			{
+				m_lo = values[0];
+				for(size_t i = 1; i < N; ++i)
+					if(values[i] < m_lo) m_lo = values[i];
+				for(size_t i = 0; i < Span; ++i)
+					m_dense[i] = N;
+				for(size_t i = N; i-- > 0;)
+					m_dense[offset(values[i])] = static_cast<uint16_t>(i);
+			}
+			else if constexpr(sorted)
+			{
+				// stable insertion sort, so equal values keep index order
+				for(size_t i = 0; i < N; ++i)
+				{
+					size_t j = i;
+					for(; j > 0 && values[i] < m_sorted[j - 1].value; --j)
+						m_sorted[j] = m_sorted[j - 1];
+					m_sorted[j] = entry{ values[i], static_cast<uint16_t>(i) };
+				}
+			}
+		}
+
+		// index of the first value equal to v, or N
+		constexpr size_t find(V v) const
+		{
+			if constexpr(Span != 0)
+			{
+				const size_t off = offset(v);
+				return off < Span ? m_dense[off] : N;
+			}
+			else if constexpr(sorted)
+			{
+				size_t lo = 0, hi = N;
+				while(lo < hi)
+				{
+					const size_t mid = (lo + hi) / 2;
+					if(m_sorted[mid].value < v) lo = mid + 1;
+					else hi = mid;
+				}
+				if(lo < N && !(v < m_sorted[lo].value)) return m_sorted[lo].index;
+				return N;
+			}
+			else
+			{
+				size_t i = 0;
+				while(i < N && !(m_values[i] == v))
+					++i;
+				return i;
+			}
+		}
+
+	private:
+		static constexpr bool sorted = Span == 0 && std::is_arithmetic<V>::value;
+
+		struct entry
+		{
+			V value;
+			uint16_t index;
+		};
+
+		// v - m_lo, wrapping so values below m_lo land past Span
+		constexpr size_t offset(V v) const
+		{
+			typedef typename std::make_unsigned<V>::type unsigned_type;
+			return static_cast<unsigned_type>(static_cast<unsigned_type>(v) - static_cast<unsigned_type>(m_lo));
+		}
+
+		const V* m_values;
+		V m_lo;
+		uint16_t m_dense[Span ? Span : 1];
+		entry m_sorted[sorted ? N : 1];
+	};
+
+} // detail
+} // boost
+
 namespace boost {
 namespace detail {
 
@@ -104,7 +335,7 @@ namespace detail {
 
 	public:
 		enum_base() {}
-		enum_base(index_type index) : m_index(index) {}
+		constexpr enum_base(index_type index) : m_index(index) {}
 
 		static const_iterator begin()
 		{
@@ -118,61 +349,50 @@ namespace detail {
 
 		static optional get_by_value(value_type value)
 		{
-			for(index_type i = 0; i < Derived::size; ++i)
-			{
-				typedef boost::optional<value_type> optional_value;
-				optional_value cur = Derived::values(enum_cast<Derived>(i));
-				if(value == *cur)
-					return Derived(enum_cast<Derived>(i));
-			}
-			return optional();
+			return get_by_index(Derived::value_index.find(value));
 		}
 
-	        static optional get_by_string(const char* s_enum)
+		// Name lookups go through Derived::name_index, the compile-time hash
+		// of the names: one pass over the input, no strlen, no scan.
+		static optional get_by_string(const char* s_enum)
 		{
-			for(index_type i = 0; i < Derived::size; ++i)
-			{
-			  const char* s_value = Derived::names(enum_cast<Derived>(i));
-			  if(!strcmp(s_enum, s_value))
-			    return Derived(enum_cast<Derived>(i));
-			}
-			return optional();
+			return get_by_index(Derived::name_index.template find<false>(s_enum));
 		}
 
-	        static optional get_by_istring(const char* s_enum)
+		static optional get_by_string(std::string_view s_enum)
 		{
-			for(index_type i = 0; i < Derived::size; ++i)
-			{
-			  const char* s_value = Derived::names(enum_cast<Derived>(i));
-			  if(!strcasecmp(s_enum, s_value))
-			    return Derived(enum_cast<Derived>(i));
-			}
-			return optional();
+			return get_by_index(Derived::name_index.template find<false>(s_enum));
+		}
+
+		static optional get_by_istring(const char* s_enum)
+		{
+			return get_by_index(Derived::name_index.template find<true>(s_enum));
 		}
 
+		static optional get_by_istring(std::string_view s_enum)
+		{
+			return get_by_index(Derived::name_index.template find<true>(s_enum));
+		}
 
-	        static Derived get_by_string_with_default(const char* s_enum, const Derived& def)
+		static Derived get_by_string_with_default(const char* s_enum, const Derived& def)
 		{
-			for(index_type i = 0; i < Derived::size; ++i)
-			{
-			  const char* s_value = Derived::names(enum_cast<Derived>(i));
-			  if(!strcmp(s_enum, s_value))
-			    return Derived(enum_cast<Derived>(i));
-			}
-			return def;
+			return found_or(Derived::name_index.template find<false>(s_enum), def);
 		}
 
-	        static Derived get_by_istring_with_default(const char* s_enum, const Derived& def)
+		static Derived get_by_string_with_default(std::string_view s_enum, const Derived& def)
 		{
-			for(index_type i = 0; i < Derived::size; ++i)
-			{
-			  const char* s_value = Derived::names(enum_cast<Derived>(i));
-			  if(!strcasecmp(s_enum, s_value))
-			    return Derived(enum_cast<Derived>(i));
-			}
-			return def;
+			return found_or(Derived::name_index.template find<false>(s_enum), def);
 		}
 
+		static Derived get_by_istring_with_default(const char* s_enum, const Derived& def)
+		{
+			return found_or(Derived::name_index.template find<true>(s_enum), def);
+		}
+
+		static Derived get_by_istring_with_default(std::string_view s_enum, const Derived& def)
+		{
+			return found_or(Derived::name_index.template find<true>(s_enum), def);
+		}
 
 		static optional get_by_index(index_type index)
 		{
@@ -180,35 +400,34 @@ namespace detail {
 			return optional(enum_cast<Derived>(index));
 		}
 
-		const char* str() const
+		// value(), str() and comparisons read Derived::value_table and
+		// Derived::name_table, so they fold for a constant enum
+		constexpr const char* str() const
 		{
-			const char* ret = Derived::names(enum_cast<Derived>(m_index));
-			BOOST_ASSERT(ret);
-			return ret;
+			BOOST_ASSERT(m_index < Derived::size);
+			return Derived::name_table[m_index].data();
 		}
 
-		value_type value() const
+		constexpr value_type value() const
 		{
-			typedef boost::optional<value_type> optional_value;
-			optional_value ret = Derived::values(enum_cast<Derived>(this->m_index));
-			BOOST_ASSERT(ret);
-			return *ret;
+			BOOST_ASSERT(m_index < Derived::size);
+			return Derived::value_table[m_index];
 		}
 
-		index_type index() const
+		constexpr index_type index() const
 		{
 			return m_index;
 		}
 
-		bool operator == (const this_type& rhs) const
+		constexpr bool operator == (const this_type& rhs) const
 		{
 			return m_index == rhs.m_index;
 		}
 
-		bool operator < (const this_type& rhs) const
+		constexpr bool operator < (const this_type& rhs) const
 		{
-			value_type lhs_value = value();
-			value_type rhs_value = rhs.value();
+			const value_type& lhs_value = Derived::value_table[m_index];
+			const value_type& rhs_value = Derived::value_table[rhs.m_index];
 			if(lhs_value == rhs_value)
 				return m_index < rhs.m_index;
 			return lhs_value < rhs_value;
@@ -217,6 +436,13 @@ namespace detail {
 	protected:
 		friend class enum_iterator<Derived>;
 		index_type m_index;
+
+	private:
+		static Derived found_or(index_type index, const Derived& def)
+		{
+			if(index >= Derived::size) return def;
+			return Derived(enum_cast<Derived>(index));
+		}
 	};
 
 	template <typename D, typename V>
@@ -230,7 +456,362 @@ namespace detail {
 	{
 		std::string str;
 		is >> str;
-		BOOST_DEDUCED_TYPENAME D::optional ret = D::get_by_name(str.c_str());
+		BOOST_DEDUCED_TYPENAME D::optional ret = D::get_by_name(str);
+		if(ret)
+			rhs = *ret;
+		else
+			is.setstate(std::ios::badbit);
+		return is;
+	}
+
+} // detail
+} // boost
+
+namespace boost {
+namespace detail {
+
+	// Per-bit view of a bitfield's flag masks, built at compile time by
+	// BOOST_BITFIELD: the index of the first flag that is exactly each bit.
+	template <size_t N>
+	class bitfield_bit_index
+	{
+	public:
+		static_assert(N < UINT8_MAX, "too many bitfield flags");
+
+		constexpr explicit bitfield_bit_index(const uint64_t (&masks)[N])
+			: m_index()
+		{
+			for(unsigned bit = 0; bit < 64; ++bit)
+				m_index[bit] = N;
+			for(size_t i = N; i-- > 0;)
+				if(masks[i] && !(masks[i] & (masks[i] - 1)))
+					m_index[__builtin_ctzll(masks[i])] = static_cast<uint8_t>(i);
+		}
+
+		constexpr size_t operator[](unsigned bit) const
+		{
+			return m_index[bit];
+		}
+
+		// whether every bit of mask has a flag of its own
+		constexpr bool covers(uint64_t mask) const
+		{
+			for(unsigned bit = 0; bit < 64; ++bit)
+				if(((mask >> bit) & 1) && m_index[bit] == N)
+					return false;
+			return true;
+		}
+
+	private:
+		uint8_t m_index[64];
+	};
+
+	// The one friend of a BOOST_BITFIELD class: raw construction and the
+	// generated tables, for bitfield_base and its iterator.
+	class bitfield_access
+	{
+	public:
+		template <typename T>
+		static T make(uint64_t raw)
+		{
+			return T(raw, 0);
+		}
+
+		template <typename T>
+		static constexpr uint64_t mask(size_t index)
+		{
+			return T::value_table[index];
+		}
+
+		template <typename T>
+		static constexpr uint64_t all_bits()
+		{
+			return T::all_bits;
+		}
+
+		template <typename T>
+		static constexpr std::string_view name(size_t index)
+		{
+			return T::name_table[index];
+		}
+
+		template <typename T, bool ICase>
+		static size_t find(std::string_view s)
+		{
+			return T::name_index.template find<ICase>(s);
+		}
+
+		template <typename T>
+		static constexpr size_t flag_at(unsigned bit)
+		{
+			return T::bit_index[bit];
+		}
+	};
+
+	// The flags set in a bitfield, one bit per step: tzcnt finds the next
+	// set bit and blsr clears it.
+	template <typename T>
+	class bitfield_iterator
+		: public boost::iterator_facade
+			< bitfield_iterator<T>
+			, const T
+			, boost::forward_traversal_tag
+			, T>
+	{
+	public:
+		explicit bitfield_iterator(uint64_t bits = 0) : m_bits(bits) {}
+
+	private:
+		friend class boost::iterator_core_access;
+
+		T dereference() const
+		{
+			return T(enum_cast<T>(bitfield_access::flag_at<T>(__builtin_ctzll(m_bits))));
+		}
+
+		void increment()
+		{
+			m_bits &= m_bits - 1;
+		}
+
+		bool equal(const bitfield_iterator& rhs) const
+		{
+			return m_bits == rhs.m_bits;
+		}
+
+		uint64_t m_bits;
+	};
+
+	// A set of BOOST_BITFIELD flags held as their OR. Flags may be composite
+	// masks, but every bit of a mask must also be a flag of its own, so a
+	// set always reads back as single-bit flags in bit order.
+	template <typename T>
+	class bitfield_base
+		: private boost::bitwise<T>
+		, private boost::totally_ordered<T>
+	{
+	public:
+		typedef bitfield_base<T> this_type;
+		typedef size_t index_type;
+		typedef uint64_t value_type;
+		typedef enum_iterator<T> const_iterator;
+		typedef bitfield_iterator<T> flag_iterator;
+		typedef boost::optional<T> optional;
+
+		// the set flags of a bitfield, for range-for
+		class flag_range
+		{
+		public:
+			explicit flag_range(value_type bits) : m_bits(bits) {}
+			flag_iterator begin() const { return flag_iterator(m_bits); }
+			flag_iterator end() const { return flag_iterator(); }
+
+		private:
+			value_type m_bits;
+		};
+
+	public:
+		bitfield_base() : m_value(0) {}
+
+		// a declared flag; all_mask is every flag, not_mask every other bit
+		bitfield_base(index_type index)
+		{
+			if(index < T::size)
+				m_value = bitfield_access::mask<T>(index);
+			else if(index == T::all_mask)
+				m_value = bitfield_access::all_bits<T>();
+			else
+				m_value = ~bitfield_access::all_bits<T>();
+		}
+
+		// every declared flag, in declaration order
+		static const_iterator begin()
+		{
+			return const_iterator(0);
+		}
+
+		static const_iterator end()
+		{
+			return const_iterator(T::size);
+		}
+
+		// value must not have bits outside all_mask
+		static optional get_by_value(value_type value)
+		{
+			if(value & ~bitfield_access::all_bits<T>())
+				return optional();
+			return bitfield_access::make<T>(value);
+		}
+
+		static optional get_by_index(index_type index)
+		{
+			if(index >= T::size) return optional();
+			return optional(enum_cast<T>(index));
+		}
+
+		// one flag by name, through the same hash as BOOST_ENUM
+		static optional get_by_string(std::string_view s)
+		{
+			return get_by_index(bitfield_access::find<T, false>(s));
+		}
+
+		static optional get_by_istring(std::string_view s)
+		{
+			return get_by_index(bitfield_access::find<T, true>(s));
+		}
+
+		// Flag names separated by delim, as written by format(), e.g.
+		// "IOC|POST_ONLY"; empty for no flags. Fails on any unknown name.
+		static optional parse(std::string_view s, char delim = '|')
+		{
+			return parse_names<false>(s, delim);
+		}
+
+		static optional iparse(std::string_view s, char delim = '|')
+		{
+			return parse_names<true>(s, delim);
+		}
+
+		value_type value() const
+		{
+			return m_value;
+		}
+
+		flag_range flags() const
+		{
+			return flag_range(m_value & bitfield_access::all_bits<T>());
+		}
+
+		size_t count() const
+		{
+			return __builtin_popcountll(m_value & bitfield_access::all_bits<T>());
+		}
+
+		// like count() and flags(), only declared flags count
+		bool any() const
+		{
+			return (m_value & bitfield_access::all_bits<T>()) != 0;
+		}
+
+		// whether every bit of rhs is set, on the raw bits, so that a
+		// not_mask value tests the undeclared ones
+		bool test(const this_type& rhs) const
+		{
+			return (m_value & rhs.m_value) == rhs.m_value;
+		}
+
+		// Names of the set flags in bit order, separated by delim, into
+		// buf with a terminating NUL, truncated to fit len. Returns the
+		// length of the whole text, as snprintf does; nothing is allocated.
+		size_t format(char* buf, size_t len, char delim = '|') const
+		{
+			size_t n = 0;
+			for(uint64_t bits = m_value & bitfield_access::all_bits<T>(); bits; bits &= bits - 1)
+			{
+				if(n)
+					put(buf, len, n, &delim, 1);
+				const std::string_view name = bitfield_access::name<T>(bitfield_access::flag_at<T>(__builtin_ctzll(bits)));
+				put(buf, len, n, name.data(), name.size());
+			}
+			if(len)
+				buf[n < len ? n : len - 1] = '\0';
+			return n;
+		}
+
+		std::string str() const
+		{
+			char buf[256];
+			const size_t n = format(buf, sizeof(buf));
+			if(n < sizeof(buf))
+				return std::string(buf, n);
+			std::string ret(n, '\0');
+			format(&ret[0], n + 1);
+			return ret;
+		}
+
+		bool operator == (const this_type& rhs) const
+		{
+			return m_value == rhs.m_value;
+		}
+
+		bool operator < (const this_type& rhs) const
+		{
+			return m_value < rhs.m_value;
+		}
+
+		T& operator |= (const this_type& rhs)
+		{
+			m_value |= rhs.m_value;
+			return static_cast<T&>(*this);
+		}
+
+		T& operator &= (const this_type& rhs)
+		{
+			m_value &= rhs.m_value;
+			return static_cast<T&>(*this);
+		}
+
+		T& operator ^= (const this_type& rhs)
+		{
+			m_value ^= rhs.m_value;
+			return static_cast<T&>(*this);
+		}
+
+		// the flags not set
+		T operator ~ () const
+		{
+			return bitfield_access::make<T>(~m_value & bitfield_access::all_bits<T>());
+		}
+
+	protected:
+		bitfield_base(value_type raw, int) : m_value(raw) {}
+
+		value_type m_value;
+
+	private:
+		static void put(char* buf, size_t len, size_t& n, const char* s, size_t size)
+		{
+			if(n + 1 < len)
+				memcpy(buf + n, s, std::min(size, len - 1 - n));
+			n += size;
+		}
+
+		template <bool ICase>
+		static optional parse_names(std::string_view s, char delim)
+		{
+			value_type bits = 0;
+			if(s.empty())
+				return bitfield_access::make<T>(bits);
+			for(;;)
+			{
+				const size_t end = s.find(delim);
+				const size_t i = bitfield_access::find<T, ICase>(s.substr(0, end));
+				if(i >= T::size)
+					return optional();
+				bits |= bitfield_access::mask<T>(i);
+				if(end == std::string_view::npos)
+					return bitfield_access::make<T>(bits);
+				s.remove_prefix(end + 1);
+			}
+		}
+	};
+
+	template <typename T>
+	std::ostream& operator << (std::ostream& os, const bitfield_base<T>& rhs)
+	{
+		char buf[256];
+		const size_t n = rhs.format(buf, sizeof(buf));
+		if(n < sizeof(buf))
+			return os.write(buf, n);
+		return os << rhs.str();
+	}
+
+	template <typename T>
+	std::istream& operator >> (std::istream& is, bitfield_base<T>& rhs)
+	{
+		std::string str;
+		is >> str;
+		BOOST_DEDUCED_TYPENAME T::optional ret = T::parse(str);
 		if(ret)
 			rhs = *ret;
 		else
@@ -274,75 +855,36 @@ namespace detail {
 #define BOOST_ENUM_size(_seq, _colsize) \
 	BOOST_PP_DIV(BOOST_PP_SEQ_SIZE(_seq), _colsize)
 
-#define BOOST_ENUM_PARSE_ITEM(r, data, elem) \
-	if(strcmp(str, BOOST_PP_STRINGIZE(elem)) == 0) return optional(elem);
-
 #define BOOST_ENUM_get_by_name(_name, _seq, _col, _colsize) \
 	static optional get_by_name(const char* str) \
 	{ \
-		BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
-			(_seq, BOOST_ENUM_PARSE_ITEM, _col) \
-		return optional(); \
-	}
-
-#define BOOST_ENUM_CASE_STRING(r, data, elem) \
-	case elem: return BOOST_PP_STRINGIZE(elem);
-
-#define BOOST_ENUM_names(_seq, _col, _colsize) \
-	static const char* names(domain index) \
+		return get_by_string(str); \
+	} \
+	static optional get_by_name(std::string_view str) \
 	{ \
-		BOOST_ASSERT(static_cast<index_type>(index) < size); \
-		switch(index) \
-		{ \
-		BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
-			(_seq, BOOST_ENUM_CASE_STRING, _col) \
-		default: return NULL; \
-		} \
+		return get_by_string(str); \
 	}
 
-#define BOOST_ENUM_CASE_PART(elem) \
-	case (elem):
-
-#define BOOST_ENUM_VALUE_PART(elem) \
-	return optional_value(elem);
-
-#define BOOST_ENUM_VALUE_LINE(r, data, i, elem) \
-	BOOST_PP_IF(BOOST_ENUM_IS_COLUMN_2(i, 0), \
-		BOOST_ENUM_CASE_PART(elem), \
-		BOOST_ENUM_VALUE_PART(elem) \
-	)
-
-#define BOOST_ENUM_values_identity() \
-	typedef boost::optional<value_type> optional_value; \
-	static optional_value values(domain index) \
-	{ \
-		if(static_cast<index_type>(index) < size) return optional_value(index); \
-		return optional_value(); \
-	}
+#define BOOST_ENUM_NAME_ITEM(r, data, elem) \
+	BOOST_PP_STRINGIZE(elem) BOOST_PP_COMMA()
 
-#define BOOST_ENUM_values(_seq, _name_col, _value_col, _colsize) \
-	typedef boost::optional<value_type> optional_value; \
-	static optional_value values(domain index) \
+#define BOOST_ENUM_name_index(_seq, _col, _colsize) \
+	static constexpr std::string_view name_table[size] = \
 	{ \
-		switch(index) \
-		{ \
-		BOOST_PP_SEQ_FOR_EACH_I(BOOST_ENUM_VALUE_LINE, _, _seq) \
-		default: return optional_value(); \
-		} \
-	}
+		BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
+			(_seq, BOOST_ENUM_NAME_ITEM, _col) \
+	}; \
+	static constexpr boost::detail::enum_name_index<size> name_index{name_table};
 
-#define BOOST_BITFIELD_names(_seq, _col, _colsize) \
-	static const char* names(domain index) \
+#define BOOST_ENUM_value_index(_seq, _col, _colsize) \
+	static constexpr value_type value_table[size] = \
 	{ \
-		BOOST_ASSERT(static_cast<index_type>(index) < size); \
-		switch(index) \
-		{ \
-		case all_mask: return "all_mask"; \
 		BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
-			(_seq, BOOST_ENUM_CASE_STRING, _col) \
-		default: return NULL; \
-		} \
-	}
+			(_seq, BOOST_ENUM_DOMAIN_ITEM, _col) \
+	}; \
+	static constexpr boost::detail::enum_value_index \
+		<value_type, size, boost::detail::enum_dense_span(value_table)> \
+		value_index{value_table};
 
 #define BOOST_BITFIELD_OR_ITEM(r, data, elem) \
 	| (elem)
@@ -361,28 +903,16 @@ namespace detail {
 	0 BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
 		(_seq, BOOST_BITFIELD_OR_ITEM, _col)
 
-#define BOOST_BITFIELD_get_by_name(_name, _seq, _col, _colsize) \
-	static optional get_by_name(const char* str) \
+#define BOOST_BITFIELD_tables(_seq, _name_col, _value_col, _colsize) \
+	BOOST_ENUM_name_index(_seq, _name_col, _colsize) \
+	static constexpr value_type value_table[size] = \
 	{ \
-		if(strcmp(str, "all_mask") == 0) return optional(all_mask); \
-		if(strcmp(str, "not_mask") == 0) return optional(not_mask); \
 		BOOST_PP_CAT(BOOST_ENUM_VISITOR, _colsize) \
-			(_seq, BOOST_ENUM_PARSE_ITEM, _col) \
-		return optional(); \
-	}
-
-#define BOOST_BITFIELD_values(_seq, _name_col, _value_col, _colsize) \
-	typedef boost::optional<value_type> optional_value; \
-	static optional_value values(domain index) \
-	{ \
-		switch(index) \
-		{ \
-		BOOST_PP_SEQ_FOR_EACH_I(BOOST_ENUM_VALUE_LINE, _, _seq) \
-		case all_mask: return optional_value(BOOST_BITFIELD_all_mask(_seq, _value_col, _colsize)); \
-		case not_mask: return optional_value(~(BOOST_BITFIELD_all_mask(_seq, _value_col, _colsize))); \
-		default: return optional_value(); \
-		} \
-	}
+			(_seq, BOOST_ENUM_DOMAIN_ITEM, _value_col) \
+	}; \
+	static constexpr value_type all_bits = BOOST_BITFIELD_all_mask(_seq, _value_col, _colsize); \
+	static constexpr boost::detail::bitfield_bit_index<size> bit_index{value_table}; \
+	static_assert(bit_index.covers(all_bits), "each bit of a BOOST_BITFIELD mask must also be a flag");
 
 #define BOOST_ENUM(_name, _seq) \
 	class _name : public boost::detail::enum_base<_name> \
@@ -390,12 +920,12 @@ namespace detail {
 	public: \
 		BOOST_ENUM_domain(_seq, 0, 1) \
 		_name() {} \
-		_name(domain index) : boost::detail::enum_base<_name>(index) {} \
+		constexpr _name(domain index) : boost::detail::enum_base<_name>(index) {} \
 		BOOST_ENUM_get_by_name(_name, _seq, 0, 1) \
 	private: \
 		friend class boost::detail::enum_base<_name>; \
-		BOOST_ENUM_names(_seq, 0, 1) \
-		BOOST_ENUM_values_identity() \
+		BOOST_ENUM_name_index(_seq, 0, 1) \
+		BOOST_ENUM_value_index(_seq, 0, 1) \
 	};
 
 #define BOOST_ENUM_VALUES(_name, _type, _seq) \
@@ -404,12 +934,12 @@ namespace detail {
 	public: \
 		BOOST_ENUM_domain(_seq, 0, 2) \
 		_name() {} \
-		_name(domain index) : boost::detail::enum_base<_name, _type>(index) {} \
+		constexpr _name(domain index) : boost::detail::enum_base<_name, _type>(index) {} \
 		BOOST_ENUM_get_by_name(_name, _seq, 0, 2) \
 	private: \
 		friend class boost::detail::enum_base<_name, _type>; \
-		BOOST_ENUM_names(_seq, 0, 2) \
-		BOOST_ENUM_values(_seq, 0, 1, 2) \
+		BOOST_ENUM_name_index(_seq, 0, 2) \
+		BOOST_ENUM_value_index(_seq, 1, 2) \
 	};
 
 #define BOOST_BITFIELD(_name, _seq) \
@@ -423,8 +953,7 @@ namespace detail {
 	private: \
 		friend class boost::detail::bitfield_access; \
 		_name(value_type raw, int) : boost::detail::bitfield_base<_name>(raw, 0) {} \
-		BOOST_BITFIELD_names(_seq, 0, 2) \
-		BOOST_BITFIELD_values(_seq, 0, 1, 2) \
+		BOOST_BITFIELD_tables(_seq, 0, 1, 2) \
 	};
 
 
@@ -0,0 +1,202 @@
+#include "elf_bars.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <boost/assert.hpp>
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  uint64_t
+  checked_interval(Timedelta interval) {
+    if(interval._td <= 0)
+      throw elf_error(ErrorCode::invalid_argument, "bucket: interval must be positive", "interval={}", interval);
+    return static_cast<uint64_t>(interval._td);
+  }
+
+#if defined(__x86_64__)
+  // high 64 bits of the 64x64 product per lane, from four 32x32 multiplies
+  __attribute__((target("avx2"))) inline __m256i
+  mulhi_epu64(__m256i a, __m256i b) {
+    const __m256i mask32 = _mm256_set1_epi64x(0xffffffff);
+    const __m256i a_hi = _mm256_srli_epi64(a, 32);
+    const __m256i b_hi = _mm256_srli_epi64(b, 32);
+    const __m256i lolo = _mm256_mul_epu32(a, b);
+    const __m256i lohi = _mm256_mul_epu32(a, b_hi);
+    const __m256i hilo = _mm256_mul_epu32(a_hi, b);
+    const __m256i hihi = _mm256_mul_epu32(a_hi, b_hi);
+    const __m256i t = _mm256_add_epi64(hilo, _mm256_srli_epi64(lolo, 32));
+    const __m256i u = _mm256_add_epi64(lohi, _mm256_and_si256(t, mask32));
+    return _mm256_add_epi64(_mm256_add_epi64(hihi, _mm256_srli_epi64(t, 32)), _mm256_srli_epi64(u, 32));
+  }
+
+  __attribute__((target("avx2"))) inline __m256i
+  divide_avx2(__m256i n, const Divider& div, __m256i magic, __m128i shift) {
+    if(!div.magic())
+      return _mm256_srl_epi64(n, shift);
+    const __m256i q = mulhi_epu64(n, magic);
+    if(div.add_marker()) {
+      const __m256i t = _mm256_add_epi64(_mm256_srli_epi64(_mm256_sub_epi64(n, q), 1), q);
+      return _mm256_srl_epi64(t, shift);
+    }
+    return _mm256_srl_epi64(q, shift);
+  }
+
+  // rows of (ts - origin) / divisor, four at a time; return the first row not done
+  __attribute__((target("avx2"))) size_t
+  bucket_ids_avx2(const timestamp_t* ts, size_t n, timestamp_t origin, const Divider& div, uint64_t* ids) {
+    const __m256i magic = _mm256_set1_epi64x(div.magic());
+    const __m128i shift = _mm_cvtsi32_si128(div.shift());
+    const __m256i base = _mm256_set1_epi64x(origin);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+      const __m256i v = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i)), base);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ids + i), divide_avx2(v, div, magic, shift));
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2"))) size_t
+  floor_timestamps_avx2(const timestamp_t* ts, size_t n, timestamp_t origin, const Divider& div, timestamp_t* out) {
+    const __m256i magic = _mm256_set1_epi64x(div.magic());
+    const __m128i shift = _mm_cvtsi32_si128(div.shift());
+    const __m256i base = _mm256_set1_epi64x(origin);
+    // q * width, low 64 bits: width may not fit the 32x32 multiply, so its
+    // halves are multiplied separately
+    const __m256i w_lo = _mm256_set1_epi64x(div.divisor() & 0xffffffff);
+    const __m256i w_hi = _mm256_set1_epi64x(div.divisor() >> 32);
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+      const __m256i v = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i)), base);
+      const __m256i q = divide_avx2(v, div, magic, shift);
+      const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(q, 32), w_lo), _mm256_mul_epu32(q, w_hi));
+      const __m256i prod = _mm256_add_epi64(_mm256_mul_epu32(q, w_lo), _mm256_slli_epi64(cross, 32));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi64(prod, base));
+    }
+    return i;
+  }
+
+  // first row in [i, n) at or past limit, comparing four rows at a time;
+  // timestamps stay below 2^63 so the signed compare is exact. Only given
+  // the few rows left after scan_below's gallop and binary search.
+  __attribute__((target("avx2"))) size_t
+  scan_below_avx2(const timestamp_t* ts, size_t i, size_t n, timestamp_t limit) {
+    const __m256i lim = _mm256_set1_epi64x(limit);
+    for(; i + 4 <= n; i += 4) {
+      const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i));
+      // lanes with ts >= limit
+      const int past = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_xor_si256(_mm256_cmpgt_epi64(lim, v), _mm256_set1_epi64x(-1))));
+      if(past)
+        return i + __builtin_ctz(past);
+    }
+    for(; i < n && ts[i] < limit; ++i)
+      ;
+    return i;
+  }
+#endif
+
+  // first row in [i, n) at or past limit. Short runs are the common case,
+  // but 1-minute bars over dense ticks are not: gallop to bracket the end,
+  // binary search the bracket down to a few vectors, then compare those.
+  size_t
+  scan_below(const timestamp_t* ts, size_t i, size_t n, timestamp_t limit) {
+    constexpr size_t window = 16;
+    // rows before i are below limit; the end is in [i, hi]
+    size_t hi = i;
+    for(size_t step = 1; hi < n && ts[hi] < limit; step *= 2) {
+      i = hi + 1;
+      hi += step;
+    }
+    hi = std::min(hi, n);
+    while(hi - i > window) {
+      const size_t mid = i + (hi - i) / 2;
+      if(ts[mid] < limit)
+        i = mid + 1;
+      else
+        hi = mid;
+    }
+#if defined(__x86_64__)
+    if(simd_level() >= SimdLevel::avx2)
+      return scan_below_avx2(ts, i, hi, limit);
+#endif
+    return lower_bound(ts + i, ts + hi, limit) - ts;
+  }
+}
+
+void
+elf::bucket_ids(const timestamp_t* ts, size_t n, Timedelta interval, uint64_t* ids, timestamp_t origin) {
+  const Divider div(checked_interval(interval));
+  size_t i = 0;
+#if defined(__x86_64__)
+  if(simd_level() >= SimdLevel::avx2)
+    i = bucket_ids_avx2(ts, n, origin, div, ids);
+#endif
+  for(; i < n; ++i)
+    ids[i] = div.divide(ts[i] - origin);
+}
+
+void
+elf::floor_timestamps(const timestamp_t* ts, size_t n, Timedelta interval, timestamp_t* out, timestamp_t origin) {
+  const uint64_t width = checked_interval(interval);
+  const Divider div(width);
+  size_t i = 0;
+#if defined(__x86_64__)
+  if(simd_level() >= SimdLevel::avx2)
+    i = floor_timestamps_avx2(ts, n, origin, div, out);
+#endif
+  for(; i < n; ++i)
+    out[i] = div.divide(ts[i] - origin) * width + origin;
+}
+
+size_t
+elf::bucket_runs(const timestamp_t* ts, size_t n, Timedelta interval, vector<BucketRun>& runs, timestamp_t origin) {
+  const uint64_t width = checked_interval(interval);
+  BOOST_ASSERT(std::is_sorted(ts, ts + n));
+  if(n > std::numeric_limits<uint32_t>::max())
+    throw elf_error(ErrorCode::out_of_bounds, "bucket_runs: too many rows", "n={}", n);
+
+  const size_t first_run = runs.size();
+  const Divider div(width);
+  size_t i = 0;
+  while(i < n) {
+    const timestamp_t start = div.divide(ts[i] - origin) * width + origin;
+    const size_t end = scan_below(ts, i + 1, n, start + width);
+    runs.push_back({ start, static_cast<uint32_t>(i), static_cast<uint32_t>(end) });
+    i = end;
+  }
+  return runs.size() - first_run;
+}
+
+template <typename T>
+void
+elf::aggregate_ohlcv(const BucketRun* runs, size_t n_runs, const T* price, const T* qty, OhlcvBar<T>* bars) {
+  for(size_t r = 0; r < n_runs; ++r) {
+    const BucketRun& run = runs[r];
+    OhlcvBar<T>& bar = bars[r];
+    bar.start = run.start;
+    bar.open = price[run.begin];
+    bar.close = price[run.end - 1];
+    T high = price[run.begin], low = price[run.begin], volume = 0;
+    for(uint32_t i = run.begin; i < run.end; ++i) {
+      high = std::max(high, price[i]);
+      low = std::min(low, price[i]);
+    }
+    if(qty) {
+      for(uint32_t i = run.begin; i < run.end; ++i)
+        volume += qty[i];
+    }
+    bar.high = high;
+    bar.low = low;
+    bar.volume = volume;
+    bar.count = run.end - run.begin;
+  }
+}
+
+template void elf::aggregate_ohlcv<double>(const BucketRun*, size_t, const double*, const double*, OhlcvBar<double>*);
+template void elf::aggregate_ohlcv<int64_t>(const BucketRun*, size_t, const int64_t*, const int64_t*, OhlcvBar<int64_t>*);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace elf {
+  // Time bucketing: bucket i of an interval covers
+  // [origin + i*interval, origin + (i+1)*interval). Timestamps must not be
+  // before origin. Division goes through a Divider, four rows at a time
+  // under AVX2.
+
+  // bucket index of every row
+  void bucket_ids(const timestamp_t* ts, size_t n, Timedelta interval, uint64_t* ids,
+                  timestamp_t origin=0);
+  // start of every row's bucket; ts and out may alias
+  void floor_timestamps(const timestamp_t* ts, size_t n, Timedelta interval, timestamp_t* out,
+                        timestamp_t origin=0);
+
+  // rows [begin, end) of a sorted array falling in the bucket starting at start
+  struct BucketRun {
+    timestamp_t start;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  // Runs of a sorted array, one per non-empty bucket in order; empty
+  // buckets produce no run. One division per run rather than per row: the
+  // rest is a scan for the first row past the bucket end. Returns the
+  // number of runs appended to runs.
+  size_t bucket_runs(const timestamp_t* ts, size_t n, Timedelta interval, std::vector<BucketRun>& runs,
+                     timestamp_t origin=0);
+
+  template <typename T>
+  struct OhlcvBar {
+    timestamp_t start;
+    T open;
+    T high;
+    T low;
+    T close;
+    T volume;
+    uint32_t count;
+  };
+
+  // One bar per run from the rows' prices and quantities; qty may be null,
+  // leaving volume 0. Instantiated for double and int64_t (fixed-point
+  // prices from substring_atofixed).
+  template <typename T>
+  void aggregate_ohlcv(const BucketRun* runs, size_t n_runs, const T* price, const T* qty,
+                       OhlcvBar<T>* bars);
+}
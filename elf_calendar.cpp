@@ -0,0 +1,307 @@
+#include "elf_calendar.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  constexpr char calendar_magic[8] = { 'E', 'L', 'F', 'C', 'A', 'L', '\0', '\0' };
+
+  // index of the set bit of rank k in bits, which has more than k set: the
+  // byte holding it from SWAR prefix popcounts, then at most 7 steps in it
+  inline uint32_t
+  select_in_word(uint64_t bits, uint32_t k) {
+    constexpr uint64_t ones = 0x0101010101010101;
+    uint64_t c = bits - ((bits >> 1) & 0x5555555555555555);
+    c = (c & 0x3333333333333333) + ((c >> 2) & 0x3333333333333333);
+    c = (c + (c >> 4)) & 0x0f0f0f0f0f0f0f0f;
+    // byte i is the number of set bits in bytes 0..i; bytes at or below k
+    // come before the one holding the bit
+    const uint64_t prefix = c * ones;
+    const uint64_t above = ((prefix | ones << 7) - (k + 1) * ones) & ones << 7;
+    const uint32_t byte = 8 - __builtin_popcountll(above);
+    const uint32_t shift = 8 * byte;
+    k -= byte ? (prefix >> (shift - 8)) & 0xff : 0;
+    uint32_t in_byte = (bits >> shift) & 0xff;
+    for(; k; --k)
+      in_byte &= in_byte - 1;
+    return shift + __builtin_ctz(in_byte);
+  }
+
+#if defined(__x86_64__)
+  __attribute__((target("bmi2"))) inline uint32_t
+  select_in_word_bmi2(uint64_t bits, uint32_t k) {
+    return __builtin_ctzll(_pdep_u64(uint64_t(1) << k, bits));
+  }
+
+  // pdep only with the AVX2 level, so that forcing a lower level exercises
+  // the fallback
+  bool
+  use_bmi2() {
+    static const bool bmi2 = (__builtin_cpu_init(), __builtin_cpu_supports("bmi2"));
+    return bmi2 && simd_level() == SimdLevel::avx2;
+  }
+#endif
+  constexpr uint32_t calendar_version = 1;
+
+  size_t
+  layout_size(size_t header_size, uint32_t n_words) {
+    return header_size + n_words * sizeof(uint64_t) + (n_words + 1) * sizeof(uint32_t);
+  }
+}
+
+TradingCalendar::TradingCalendar(const vector<date_t>& holidays, Date first, Date last, uint8_t weekend)
+  : TradingCalendar(build(holidays, first, last, weekend)) {}
+
+TradingCalendar::Storage
+TradingCalendar::build(const vector<date_t>& holidays, Date first, Date last, uint8_t weekend) {
+  const days_t first_day = first.to_days();
+  if(last.to_days() < first_day)
+    throw elf_error(ErrorCode::invalid_argument, "trading_calendar: empty range", "first={} last={}", first, last);
+  const uint32_t n_days = last.to_days() - first_day + 1;
+  const uint32_t n_words = (n_days + 63) / 64;
+  const size_t size = layout_size(sizeof(Header), n_words);
+
+  auto storage = make_shared<vector<uint64_t>>((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  char* base = reinterpret_cast<char*>(storage->data());
+  Header* header = reinterpret_cast<Header*>(base);
+  memcpy(header->magic, calendar_magic, sizeof(calendar_magic));
+  header->version = calendar_version;
+  header->first_day = first_day;
+  header->n_days = n_days;
+  header->n_words = n_words;
+
+  unordered_set<days_t> closed;
+  for(date_t holiday: holidays)
+    closed.insert(Date(holiday).to_days());
+
+  uint64_t* words = reinterpret_cast<uint64_t*>(base + sizeof(Header));
+  uint32_t* prefix = reinterpret_cast<uint32_t*>(words + n_words);
+  for(uint32_t i = 0; i < n_days; ++i) {
+    const days_t day = first_day + i;
+    const int32_t weekday = ((day + 4) % 7 + 7) % 7;
+    if(!(weekend & (1 << weekday)) && !closed.count(day))
+      words[i / 64] |= uint64_t(1) << (i % 64);
+  }
+  prefix[0] = 0;
+  for(uint32_t w = 0; w < n_words; ++w)
+    prefix[w + 1] = prefix[w] + __builtin_popcountll(words[w]);
+
+  return { shared_ptr<const void>(storage, base), size };
+}
+
+TradingCalendar::TradingCalendar(Storage storage)
+  : _storage(std::move(storage.data)) {
+  const size_t size = storage.size;
+  const char* base = static_cast<const char*>(_storage.get());
+  _header = reinterpret_cast<const Header*>(base);
+  if(size < sizeof(Header) || memcmp(_header->magic, calendar_magic, sizeof(calendar_magic)))
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: bad layout magic");
+  if(_header->version != calendar_version)
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: unsupported layout", "version={}", _header->version);
+  if(_header->n_days == 0)
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: empty layout");
+  if(_header->n_words != (uint64_t(_header->n_days) + 63) / 64 || size < layout_size(sizeof(Header), _header->n_words))
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: truncated layout");
+  _words = reinterpret_cast<const uint64_t*>(base + sizeof(Header));
+  _prefix = reinterpret_cast<const uint32_t*>(_words + _header->n_words);
+
+  // select trusts the counts to match the bitmap, and the bitmap to end at
+  // n_days; one pass checks both for a mapped file
+  const uint32_t n_words = _header->n_words;
+  const uint32_t tail = _header->n_days % 64;
+  bool ok = _prefix[0] == 0 && (!tail || !(_words[n_words - 1] >> tail));
+  for(uint32_t w = 0; ok && w < n_words; ++w)
+    ok = _prefix[w + 1] == _prefix[w] + uint32_t(__builtin_popcountll(_words[w]));
+  if(!ok)
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: inconsistent layout");
+}
+
+TradingCalendar
+TradingCalendar::from_holiday_file(const string& path, Date first, Date last, uint8_t weekend) {
+  ifstream in(path);
+  if(!in)
+    throw elf_error(ErrorCode::io, "trading_calendar: cannot open", "path={}", path);
+
+  vector<date_t> holidays;
+  string line;
+  for(size_t line_no = 1; getline(in, line); ++line_no) {
+    const size_t begin = line.find_first_not_of(" \t\r");
+    if(begin == string::npos || line[begin] == '#')
+      continue;
+    uint32_t date;
+    const bool ok = line.size() - begin >= Date::required_len
+      && substring_atoi<Date::required_len>(line.data() + begin, date)
+      && (line.size() - begin == Date::required_len || !isdigit(static_cast<unsigned char>(line[begin + Date::required_len])))
+      && validate_date(date);
+    if(!ok)
+      throw elf_error(ErrorCode::bad_format, "trading_calendar: bad holiday", "path={} line={}", path, line_no);
+    if(date >= static_cast<uint32_t>(first.to_int()) && date <= static_cast<uint32_t>(last.to_int()))
+      holidays.push_back(date);
+  }
+  return TradingCalendar(holidays, first, last, weekend);
+}
+
+void
+TradingCalendar::write(const string& path) const {
+  // written beside the target and renamed over it, so processes that have
+  // the old file mapped keep their pages
+  string tmp = path + ".XXXXXX";
+  const int fd = ::mkstemp(tmp.data());
+  if(fd < 0)
+    throw elf_error(ErrorCode::io, "trading_calendar: cannot write", "path={}", path);
+  const char* p = static_cast<const char*>(_storage.get());
+  size_t left = layout_size(sizeof(Header), _header->n_words);
+  // mkstemp creates 0600; give the file the mode open() would. umask can
+  // only be read by setting it, so it is restored at once
+  const mode_t mask = ::umask(0);
+  ::umask(mask);
+  bool ok = !::fchmod(fd, 0666 & ~mask);
+  while(ok && left) {
+    const ssize_t n = ::write(fd, p, left);
+    ok = n > 0;
+    p += ok ? n : 0;
+    left -= ok ? n : 0;
+  }
+  ok &= !::close(fd);
+  if(!ok || ::rename(tmp.c_str(), path.c_str())) {
+    ::unlink(tmp.c_str());
+    throw elf_error(ErrorCode::io, "trading_calendar: cannot write", "path={}", path);
+  }
+}
+
+TradingCalendar
+TradingCalendar::map(const string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    throw elf_error(ErrorCode::io, "trading_calendar: cannot open", "path={}", path);
+  struct stat st;
+  if(::fstat(fd, &st) || st.st_size < static_cast<off_t>(sizeof(Header))) {
+    ::close(fd);
+    throw elf_error(ErrorCode::bad_format, "trading_calendar: bad layout", "path={}", path);
+  }
+  const size_t size = st.st_size;
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(addr == MAP_FAILED)
+    throw elf_error(ErrorCode::io, "trading_calendar: mmap failed", "path={}", path);
+  shared_ptr<const void> storage(addr, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+  return TradingCalendar(Storage{ std::move(storage), size });
+}
+
+Date
+TradingCalendar::first() const {
+  return date_at(0);
+}
+
+Date
+TradingCalendar::last() const {
+  return date_at(_header->n_days - 1);
+}
+
+uint32_t
+TradingCalendar::index(const Date& date) const {
+  const int64_t i = static_cast<int64_t>(date.to_days()) - _header->first_day;
+  if(i < 0 || i >= _header->n_days)
+    throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: date out of range", "date={}", date);
+  return static_cast<uint32_t>(i);
+}
+
+uint32_t
+TradingCalendar::end_index(const Date& date) const {
+  const int64_t i = static_cast<int64_t>(date.to_days()) - _header->first_day;
+  if(i < 0 || i > _header->n_days)
+    throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: date out of range", "date={}", date);
+  return static_cast<uint32_t>(i);
+}
+
+Date
+TradingCalendar::date_at(uint32_t i) const {
+  return Date::from_days(_header->first_day + static_cast<days_t>(i));
+}
+
+uint32_t
+TradingCalendar::rank(uint32_t i) const {
+  const uint32_t w = i / 64, b = i % 64;
+  return _prefix[w] + (b ? __builtin_popcountll(_words[w] & ((uint64_t(1) << b) - 1)) : 0);
+}
+
+uint32_t
+TradingCalendar::select(int64_t r) const {
+  const uint32_t n_words = _header->n_words;
+  if(r < 0 || r >= _prefix[n_words])
+    throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: result out of range");
+  const uint32_t w = upper_bound(_prefix, _prefix + n_words + 1, static_cast<uint32_t>(r)) - _prefix - 1;
+  const uint32_t k = static_cast<uint32_t>(r - _prefix[w]);
+#if defined(__x86_64__)
+  if(use_bmi2())
+    return w * 64 + select_in_word_bmi2(_words[w], k);
+#endif
+  return w * 64 + select_in_word(_words[w], k);
+}
+
+bool
+TradingCalendar::is_trading_day(const Date& date) const {
+  const uint32_t i = index(date);
+  return (_words[i / 64] >> (i % 64)) & 1;
+}
+
+Date
+TradingCalendar::next(const Date& date) const {
+  const uint32_t i = index(date) + 1;
+  if(i >= _header->n_days)
+    throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: no trading day after", "date={}", date);
+  uint32_t w = i / 64;
+  uint64_t bits = _words[w] & (~uint64_t(0) << (i % 64));
+  while(!bits) {
+    if(++w == _header->n_words)
+      throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: no trading day after", "date={}", date);
+    bits = _words[w];
+  }
+  return date_at(w * 64 + __builtin_ctzll(bits));
+}
+
+Date
+TradingCalendar::prev(const Date& date) const {
+  const uint32_t i = index(date);
+  if(i == 0)
+    throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: no trading day before", "date={}", date);
+  uint32_t w = (i - 1) / 64;
+  uint64_t bits = _words[w] & (~uint64_t(0) >> (63 - (i - 1) % 64));
+  while(!bits) {
+    if(w == 0)
+      throw elf_error(ErrorCode::out_of_bounds, "trading_calendar: no trading day before", "date={}", date);
+    bits = _words[--w];
+  }
+  return date_at(w * 64 + 63 - __builtin_clzll(bits));
+}
+
+Date
+TradingCalendar::add(const Date& date, int32_t n) const {
+  const uint32_t i = index(date);
+  if(n == 0)
+    return date;
+  const int64_t target = n > 0 ? int64_t(rank(i + 1)) + n - 1 : int64_t(rank(i)) + n;
+  return date_at(select(target));
+}
+
+int32_t
+TradingCalendar::count(const Date& from, const Date& to) const {
+  return static_cast<int32_t>(rank(end_index(to))) - static_cast<int32_t>(rank(end_index(from)));
+}
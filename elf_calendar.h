@@ -0,0 +1,87 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace elf {
+  // Business days over [first, last] as a bitmap indexed by day number, with
+  // a running count per 64-day word. next/prev scan with ctz/clz,
+  // count is two popcounts and two prefix lookups, add selects by rank
+  // (pdep where BMI2 is available, a byte search in the word otherwise).
+  //
+  // The bitmap lives in one flat, position-independent block that can be
+  // written to a file and mapped back read-only. Copies of a calendar share
+  // the block; each map() is its own mapping, so calendars mapped from the
+  // same file share only the OS page cache. Dates outside [first, last],
+  // and results that would leave it, throw elf_error.
+  class TradingCalendar {
+  public:
+    static constexpr date_t default_first = 19700101;
+    static constexpr date_t default_last = 21001231;
+    // bit per weekday, 0=Sunday as Date::weekday
+    static constexpr uint8_t saturday_sunday = (1 << 0) | (1 << 6);
+
+    explicit TradingCalendar(const std::vector<date_t>& holidays,
+                             Date first=Date(default_first), Date last=Date(default_last),
+                             uint8_t weekend=saturday_sunday);
+
+    // one YYYYMMDD per line, anything after it ignored; blank lines and #
+    // comments skipped
+    static TradingCalendar from_holiday_file(const std::string& path,
+                                             Date first=Date(default_first), Date last=Date(default_last),
+                                             uint8_t weekend=saturday_sunday);
+    // the flat layout, for map()
+    void write(const std::string& path) const;
+    static TradingCalendar map(const std::string& path);
+
+    Date first() const;
+    Date last() const;
+    bool is_trading_day(const Date& date) const;
+    // nearest trading day strictly after / before date
+    Date next(const Date& date) const;
+    Date prev(const Date& date) const;
+    // the n-th trading day after date for n > 0, before it for n < 0; date
+    // itself need not be a trading day, and n == 0 returns it unchanged
+    Date add(const Date& date, int32_t n) const;
+    // trading days in [from, to), negative when to < from; either end may
+    // be the day after last(), so that a range can include last()
+    int32_t count(const Date& from, const Date& to) const;
+
+  private:
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      days_t first_day;
+      uint32_t n_days;
+      uint32_t n_words;
+    };
+    static_assert(sizeof(Header) % sizeof(uint64_t) == 0);
+
+    struct Storage {
+      std::shared_ptr<const void> data;
+      size_t size;
+    };
+
+    explicit TradingCalendar(Storage storage);
+    static Storage build(const std::vector<date_t>& holidays, Date first, Date last, uint8_t weekend);
+
+    uint32_t index(const Date& date) const;
+    // as index, also accepting the day after last() as n_days
+    uint32_t end_index(const Date& date) const;
+    Date date_at(uint32_t i) const;
+    // trading days before index i
+    uint32_t rank(uint32_t i) const;
+    // index of the trading day with the given rank
+    uint32_t select(int64_t rank) const;
+
+    std::shared_ptr<const void> _storage;
+    const Header* _header;
+    // n_words bitmap words, then n_words+1 running counts
+    const uint64_t* _words;
+    const uint32_t* _prefix;
+  };
+}
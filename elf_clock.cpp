@@ -0,0 +1,203 @@
+#include "elf_clock.h"
+
+#include <ctime>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  constexpr int64_t nsec_per_sec = 1000000000;
+  constexpr int64_t nsec_per_tick = 1000 / TimeConstants::ticks_per_usec;
+  constexpr int64_t calibration_interval = nsec_per_sec;
+  constexpr int64_t offset_check_secs = 15 * 60;
+
+  inline int64_t
+  clock_nsec(clockid_t id) {
+    struct timespec ts;
+    ::clock_gettime(id, &ts);
+    return ts.tv_sec * nsec_per_sec + ts.tv_nsec;
+  }
+
+#if defined(__x86_64__)
+  // rdtsc bracketed around clock_gettime; keeps the narrowest of a few tries
+  void
+  sample_tsc(clockid_t id, uint64_t& tsc, int64_t& nsec) {
+    uint64_t best = UINT64_MAX;
+    for(int i = 0; i < 5; ++i) {
+      const uint64_t t0 = __rdtsc();
+      const int64_t n = clock_nsec(id);
+      const uint64_t t1 = __rdtsc();
+      if(t1 - t0 < best) {
+        best = t1 - t0;
+        tsc = t0 + (t1 - t0) / 2;
+        nsec = n;
+      }
+    }
+  }
+#endif
+}
+
+const char*
+elf::to_string(ClockSource source) {
+  switch(source) {
+  case ClockSource::realtime: return "realtime";
+  case ClockSource::monotonic_raw: return "monotonic_raw";
+  case ClockSource::tsc: return "tsc";
+  }
+  return "unknown";
+}
+
+bool
+Clock::tsc_invariant() {
+#if defined(__x86_64__)
+  unsigned eax, ebx, ecx, edx;
+  if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+    return false;
+  return edx & (1u << 8);
+#else
+  return false;
+#endif
+}
+
+Clock::Clock(ClockSource source)
+  : _source(source) {
+  if(_source == ClockSource::tsc && !tsc_invariant())
+    _source = ClockSource::realtime;
+
+#if defined(__x86_64__)
+  if(_source == ClockSource::tsc) {
+    // the rate is measured on CLOCK_MONOTONIC_RAW, which no wall clock
+    // step moves
+    sample_tsc(CLOCK_MONOTONIC_RAW, _first_tsc, _first_raw);
+    while(clock_nsec(CLOCK_MONOTONIC_RAW) < _first_raw + nsec_per_sec / 100)
+      ;
+  }
+#endif
+  calibrate();
+}
+
+void
+Clock::calibrate() {
+  switch(_source) {
+  case ClockSource::monotonic_raw: {
+    const int64_t raw = clock_nsec(CLOCK_MONOTONIC_RAW);
+    _raw_offset = clock_nsec(CLOCK_REALTIME) - raw;
+    _raw_next_calibration = raw + calibration_interval;
+    break;
+  }
+#if defined(__x86_64__)
+  case ClockSource::tsc: {
+    uint64_t raw_tsc, anchor_tsc;
+    int64_t raw_nsec, anchor_nsec;
+    sample_tsc(CLOCK_MONOTONIC_RAW, raw_tsc, raw_nsec);
+    sample_tsc(CLOCK_REALTIME, anchor_tsc, anchor_nsec);
+    calibrate(raw_tsc, raw_nsec, anchor_tsc, anchor_nsec);
+    break;
+  }
+#endif
+  default:
+    break;
+  }
+}
+
+void
+Clock::calibrate(uint64_t raw_tsc, int64_t raw_nsec, uint64_t anchor_tsc, int64_t anchor_nsec) {
+  if(_source != ClockSource::tsc)
+    return;
+  // rate over the whole span since construction; a span that doesn't
+  // advance keeps the last rate, and with none the clock reads realtime
+  if(raw_tsc > _first_tsc && raw_nsec > _first_raw) {
+    const uint64_t mult = (static_cast<unsigned __int128>(raw_nsec - _first_raw) << 32) / (raw_tsc - _first_tsc);
+    if(mult)
+      _mult = mult;
+  }
+  if(!_mult) {
+    _source = ClockSource::realtime;
+    return;
+  }
+  _calibration_cycles = (static_cast<unsigned __int128>(calibration_interval) << 32) / _mult;
+  // anchored at now on the wall clock, wherever it has stepped to
+  _base_tsc = anchor_tsc;
+  _base_nsec = anchor_nsec;
+}
+
+int64_t
+Clock::tsc_nsec() {
+#if defined(__x86_64__)
+  const uint64_t elapsed = __rdtsc() - _base_tsc;
+  if(elapsed > _calibration_cycles) {
+    calibrate();
+    return _base_nsec;
+  }
+  return _base_nsec + static_cast<int64_t>((static_cast<unsigned __int128>(elapsed) * _mult) >> 32);
+#else
+  return clock_nsec(CLOCK_REALTIME);
+#endif
+}
+
+int64_t
+Clock::epoch_nsec() {
+  switch(_source) {
+  case ClockSource::monotonic_raw: {
+    const int64_t raw = clock_nsec(CLOCK_MONOTONIC_RAW);
+    if(raw > _raw_next_calibration)
+      calibrate();
+    return raw + _raw_offset;
+  }
+  case ClockSource::tsc:
+    return tsc_nsec();
+  default:
+    return clock_nsec(CLOCK_REALTIME);
+  }
+}
+
+void
+Clock::update_offset(int64_t nsec) {
+  const time_t now = nsec / nsec_per_sec;
+  struct tm tm;
+  ::localtime_r(&now, &tm);
+  const int64_t tod = tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+  // midnight as read on the clock in force now, not the instant local
+  // midnight passed, which differs on a DST day; offsets change on a
+  // quarter hour, so the offset is re-read at the next one
+  _midnight = (static_cast<int64_t>(now) - tod) * nsec_per_sec;
+  _anchor = _midnight + (tod - tod % offset_check_secs) * nsec_per_sec;
+  _next_anchor = _anchor + offset_check_secs * nsec_per_sec;
+}
+
+Timestamp
+Clock::now() {
+  const int64_t nsec = epoch_nsec();
+  if(nsec >= _next_anchor || nsec < _anchor)
+    update_offset(nsec);
+  return Timestamp((nsec - _midnight) / nsec_per_tick);
+}
+
+Timestamp
+elf::rt_timestamp(ClockSource source) {
+  switch(source) {
+  case ClockSource::monotonic_raw: {
+    thread_local Clock clock(ClockSource::monotonic_raw);
+    return clock.now();
+  }
+  case ClockSource::tsc: {
+    thread_local Clock clock(ClockSource::tsc);
+    return clock.now();
+  }
+  default: {
+    thread_local Clock clock(ClockSource::realtime);
+    return clock.now();
+  }
+  }
+}
+
+timestamp_t
+get_rt_timestamp(timestamp_t midnight_offset_secs) {
+  const int64_t nsec = clock_nsec(CLOCK_REALTIME) - static_cast<int64_t>(midnight_offset_secs) * nsec_per_sec;
+  return nsec / nsec_per_tick;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <cstdint>
+
+namespace elf {
+  enum class ClockSource {
+    realtime,       // clock_gettime(CLOCK_REALTIME), served by the vDSO
+    monotonic_raw,  // CLOCK_MONOTONIC_RAW anchored to CLOCK_REALTIME
+    tsc             // rdtsc scaled by a calibrated, periodically refreshed rate
+  };
+
+  const char* to_string(ClockSource source);
+
+  // Wall clock returning the local time of day as a Timestamp, the time a
+  // local wall clock shows: it jumps with DST, back an hour when it ends.
+  // monotonic_raw and tsc are re-anchored to CLOCK_REALTIME about once a
+  // second, so they track NTP adjustments but can step, backwards too, by
+  // the sampling error (microseconds) when they do. No source is monotonic.
+  // tsc falls back to realtime unless the cpu has an invariant TSC, and
+  // spends ~10ms calibrating on construction. Instances cache calibration
+  // and the local UTC offset, re-read every quarter hour, and are not
+  // thread safe; use one per thread, or rt_timestamp().
+  class Clock {
+  public:
+    explicit Clock(ClockSource source=ClockSource::realtime);
+
+    ClockSource source() const { return _source; }
+    // nanoseconds since the unix epoch
+    int64_t epoch_nsec();
+    // local wall clock time of day in ticks
+    Timestamp now();
+    void calibrate();
+    // tsc: calibrate from given samples of the TSC against
+    // CLOCK_MONOTONIC_RAW, for the rate, and against CLOCK_REALTIME, for
+    // the anchor, rather than taking them; calibrate() uses it, tests too
+    void calibrate(uint64_t raw_tsc, int64_t raw_nsec, uint64_t anchor_tsc, int64_t anchor_nsec);
+
+    static bool tsc_invariant();
+
+  private:
+    int64_t tsc_nsec();
+    void update_offset(int64_t nsec);
+
+    ClockSource _source;
+    // monotonic_raw: realtime - raw at the last calibration
+    int64_t _raw_offset = 0;
+    int64_t _raw_next_calibration = 0;
+    // tsc: nsec = _base_nsec + ((tsc - _base_tsc) * _mult) >> 32, the
+    // base on CLOCK_REALTIME and the rate since _first_* on
+    // CLOCK_MONOTONIC_RAW
+    uint64_t _base_tsc = 0;
+    int64_t _base_nsec = 0;
+    uint64_t _mult = 0;
+    uint64_t _first_tsc = 0;
+    int64_t _first_raw = 0;
+    uint64_t _calibration_cycles = 0;
+
+    // local midnight under the cached offset; the offset is valid for
+    // [_anchor, _next_anchor)
+    int64_t _midnight = 0;
+    int64_t _anchor = 0;
+    int64_t _next_anchor = 0;
+  };
+
+  // per-thread Clock of the given source
+  Timestamp rt_timestamp(ClockSource source=ClockSource::realtime);
+}
+
+// legacy: ticks since the caller-supplied epoch second of midnight
+elf::timestamp_t get_rt_timestamp(elf::timestamp_t midnight_offset_secs);
@@ -0,0 +1,346 @@
+#include "elf_csv.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  // bit i of fields is set where p[i] ends a field (delim or \n), of lines
+  // where it ends a row
+  struct BlockMasks {
+    uint64_t fields;
+    uint64_t lines;
+  };
+
+#if defined(__SSE2__)
+  inline uint64_t
+  match_16(const char* p, __m128i c) {
+    return static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), c)));
+  }
+
+  BlockMasks
+  classify_block(const char* p, char delim) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i dl = _mm_set1_epi8(delim);
+    uint64_t lines = 0, fields = 0;
+    for(unsigned i = 0; i < 64; i += 16) {
+      lines |= match_16(p + i, nl) << i;
+      fields |= match_16(p + i, dl) << i;
+    }
+    return { fields | lines, lines };
+  }
+#else
+  BlockMasks
+  classify_block(const char* p, char delim) {
+    uint64_t lines = 0, fields = 0;
+    for(unsigned i = 0; i < 64; ++i) {
+      lines |= uint64_t(p[i] == '\n') << i;
+      fields |= uint64_t(p[i] == delim) << i;
+    }
+    return { fields | lines, lines };
+  }
+#endif
+
+#if defined(__x86_64__)
+  __attribute__((target("avx2"))) inline uint64_t
+  match_32(const char* p, __m256i c) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), c)));
+  }
+
+  __attribute__((target("avx2"))) BlockMasks
+  classify_block_avx2(const char* p, char delim) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i dl = _mm256_set1_epi8(delim);
+    const uint64_t lines = match_32(p, nl) | (match_32(p + 32, nl) << 32);
+    const uint64_t fields = match_32(p, dl) | (match_32(p + 32, dl) << 32);
+    return { fields | lines, lines };
+  }
+#endif
+
+  template <typename T, typename Values>
+  inline void
+  store(Values& values, size_t row, T v) {
+    std::get<vector<T>>(values)[row] = v;
+  }
+
+  template <typename Values>
+  inline void
+  store_zero(Values& values, size_t row) {
+    std::visit([row](auto& v) { v[row] = 0; }, values);
+  }
+
+  // fields in the first non-blank line, 0 if there is none
+  size_t
+  first_row_fields(const char* p, size_t size, char delim) {
+    const char* end = p + size;
+    while(p != end) {
+      const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+      const char* line_end = nl ? nl : end;
+      const char* text_end = line_end != p && line_end[-1] == '\r' ? line_end - 1 : line_end;
+      if(text_end != p)
+        return 1 + std::count(p, text_end, delim);
+      p = nl ? nl + 1 : end;
+    }
+    return 0;
+  }
+}
+
+void
+CsvChunk::Column::reset(ColumnType t, size_t rows) {
+  type = t;
+  if(values.index() != static_cast<size_t>(t)) {
+    switch(t) {
+    case ColumnType::timestamp: values.emplace<vector<timestamp_t>>(); break;
+    case ColumnType::date: values.emplace<vector<date_t>>(); break;
+    case ColumnType::int64: values.emplace<vector<int64_t>>(); break;
+    case ColumnType::float64: values.emplace<vector<double>>(); break;
+    }
+  }
+  std::visit([rows](auto& v) { v.resize(rows); }, values);
+  bad.assign((rows + 63) / 64, 0);
+  n_bad = 0;
+}
+
+template <typename T>
+const T*
+CsvChunk::column(size_t col) const {
+  const Column& c = _columns.at(col);
+  if(c.type != detail::column_type_of<T>::value)
+    throw elf_error(ErrorCode::invalid_argument, "csv: column type mismatch", "column={}", col);
+  return std::get<vector<T>>(c.values).data();
+}
+
+template const timestamp_t* CsvChunk::column<timestamp_t>(size_t) const;
+template const date_t* CsvChunk::column<date_t>(size_t) const;
+template const int64_t* CsvChunk::column<int64_t>(size_t) const;
+template const double* CsvChunk::column<double>(size_t) const;
+
+CsvReader::CsvReader(const string& path, vector<CsvColumn> columns, CsvOptions options)
+  : _columns(std::move(columns)), _options(options) {
+  if(_columns.size() > max_columns)
+    throw elf_error(ErrorCode::invalid_argument, "csv: too many columns", "n={}", _columns.size());
+  if(!_options.chunk_rows)
+    throw elf_error(ErrorCode::invalid_argument, "csv: chunk_rows must be positive");
+  if(_options.delim == '\n' || _options.delim == '\r' || _options.delim == '\0')
+    throw elf_error(ErrorCode::invalid_argument, "csv: bad delimiter", "delim={}", int(_options.delim));
+  for(size_t col = 0; col < _columns.size(); ++col) {
+    for(size_t prev = 0; prev < col; ++prev) {
+      if(_columns[prev].field == _columns[col].field)
+        throw elf_error(ErrorCode::invalid_argument, "csv: field requested twice", "field={}", _columns[col].field);
+    }
+  }
+
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    throw elf_error(ErrorCode::io, "csv: cannot open", "path={}", path);
+  struct stat st;
+  if(::fstat(fd, &st)) {
+    ::close(fd);
+    throw elf_error(ErrorCode::io, "csv: cannot stat", "path={}", path);
+  }
+  _size = st.st_size;
+  if(_size) {
+    void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED)
+      throw elf_error(ErrorCode::io, "csv: mmap failed", "path={}", path);
+    const size_t size = _size;
+    _map = shared_ptr<const void>(addr, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+    _base = static_cast<const char*>(addr);
+    // advice only; the reader is correct without it
+    ::madvise(addr, _size, MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+    if(_options.huge_pages)
+      ::madvise(addr, _size, MADV_HUGEPAGE);
+#endif
+  } else {
+    ::close(fd);
+  }
+
+  if(_options.header) {
+    const void* nl = _size ? memchr(_base, '\n', _size) : nullptr;
+    _pos = nl ? static_cast<const char*>(nl) - _base + 1 : _size;
+  }
+
+  // with no rows to read there is nothing to look fields up in
+  const size_t n_fields = first_row_fields(_base, _size, _options.delim);
+  if(!n_fields)
+    return;
+  for(size_t col = 0; col < _columns.size(); ++col) {
+    const uint32_t field = _columns[col].field;
+    if(field >= n_fields)
+      throw elf_error(ErrorCode::invalid_argument, "csv: field past the first row", "field={} fields={}", field, n_fields);
+    if(field >= _slot.size())
+      _slot.resize(field + 1, -1);
+    _slot[field] = static_cast<int8_t>(col);
+  }
+}
+
+bool
+CsvReader::next(CsvChunk& chunk) {
+  const size_t max_rows = _options.chunk_rows;
+  chunk._columns.resize(_columns.size());
+  for(size_t col = 0; col < _columns.size(); ++col)
+    chunk._columns[col].reset(_columns[col].type, max_rows);
+  chunk._first_row = _rows;
+
+  size_t rows = 0;
+#if defined(__x86_64__)
+  if(simd_level() >= SimdLevel::avx2)
+    rows = parse_rows(chunk, classify_block_avx2);
+  else
+#endif
+    rows = parse_rows(chunk, classify_block);
+
+  chunk._rows = rows;
+  _rows += rows;
+  release_consumed();
+  return rows > 0;
+}
+
+template <typename Classify>
+size_t
+CsvReader::parse_rows(CsvChunk& chunk, Classify classify) {
+  const size_t max_rows = _options.chunk_rows;
+  const size_t n_fields = _slot.size();
+  size_t row = 0, field = 0, field_begin = _pos;
+  uint64_t filled = 0;
+  // past the last requested field: only newlines matter
+  bool skipping = false;
+  char tail[64];
+
+  // ends the field at 'at', and the row too when eol; false for a blank line
+  const auto end_field = [&](size_t at, bool eol) {
+    size_t len = at - field_begin;
+    if(eol && len && _base[at - 1] == '\r')
+      --len;
+    if(eol && field == 0 && len == 0)
+      return false;
+    if(field < n_fields && _slot[field] >= 0) {
+      parse_field(chunk, _slot[field], row, _base + field_begin, len);
+      filled |= uint64_t(1) << _slot[field];
+    }
+    ++field;
+    return true;
+  };
+
+  for(size_t block = _pos; block < _size; block += 64) {
+    const char* p = _base + block;
+    if(_size - block < 64) {
+      // zero padding matches neither delim nor \n
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, p, _size - block);
+      p = tail;
+    }
+    const BlockMasks masks = classify(p, _options.delim);
+    uint64_t fields = masks.fields, lines = masks.lines;
+    for(;;) {
+      const uint64_t next = skipping ? lines : fields;
+      if(!next)
+        break;
+      const unsigned b = __builtin_ctzll(next);
+      const bool eol = (lines >> b) & 1;
+      const uint64_t rest = b == 63 ? 0 : ~uint64_t(0) << (b + 1);
+      fields &= rest;
+      lines &= rest;
+      const size_t at = block + b;
+
+      const bool counted = skipping || end_field(at, eol);
+      field_begin = at + 1;
+      if(!eol) {
+        skipping = field >= n_fields;
+        continue;
+      }
+      skipping = false;
+      if(counted) {
+        finish_row(chunk, row++, filled);
+        field = 0;
+        filled = 0;
+        if(row == max_rows) {
+          _pos = field_begin;
+          return row;
+        }
+      }
+    }
+  }
+
+  // a last row without a newline
+  if(skipping || field > 0 || field_begin < _size) {
+    if(skipping || end_field(_size, true))
+      finish_row(chunk, row++, filled);
+  }
+  _pos = _size;
+  return row;
+}
+
+void
+CsvReader::parse_field(CsvChunk& chunk, size_t col, size_t row, const char* p, size_t len) {
+  CsvChunk::Column& c = chunk._columns[col];
+  bool ok = false;
+  switch(c.type) {
+  case ColumnType::timestamp: {
+    const auto r = Timestamp::try_parse(string_view(p, len));
+    ok = r.ok();
+    store<timestamp_t>(c.values, row, ok ? r.value._ts : 0);
+    break;
+  }
+  case ColumnType::date: {
+    const auto r = Date::try_parse(string_view(p, len));
+    ok = r.ok();
+    store<date_t>(c.values, row, ok ? r.value._d : 0);
+    break;
+  }
+  case ColumnType::int64: {
+    int64_t v = 0;
+    ok = substring_atoi(p, len, v);
+    store<int64_t>(c.values, row, ok ? v : 0);
+    break;
+  }
+  case ColumnType::float64: {
+    double d = 0;
+    ok = substring_atod(p, len, d);
+    store<double>(c.values, row, ok ? d : 0);
+    break;
+  }
+  }
+  if(!ok) {
+    c.bad[row / 64] |= uint64_t(1) << (row % 64);
+    ++c.n_bad;
+  }
+}
+
+void
+CsvReader::finish_row(CsvChunk& chunk, size_t row, uint64_t filled) {
+  const uint64_t all = _columns.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << _columns.size()) - 1;
+  // columns whose field the row doesn't reach
+  for(uint64_t missing = all & ~filled; missing; missing &= missing - 1) {
+    CsvChunk::Column& c = chunk._columns[__builtin_ctzll(missing)];
+    store_zero(c.values, row);
+    c.bad[row / 64] |= uint64_t(1) << (row % 64);
+    ++c.n_bad;
+  }
+}
+
+void
+CsvReader::release_consumed() {
+  // whole pages behind the read position are not visited again
+  const size_t page = ::sysconf(_SC_PAGESIZE);
+  const size_t end = _pos / page * page;
+  if(end > _released) {
+    ::madvise(const_cast<char*>(_base) + _released, end - _released, MADV_DONTNEED);
+    _released = end;
+  }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace elf {
+  // column types and the parsers that fill them: Timestamp::try_parse,
+  // Date::try_parse, substring_atoi and substring_atod
+  enum class ColumnType : uint8_t { timestamp, date, int64, float64 };
+
+  // field is the zero-based position in the row, and must fall within the
+  // first row (the header, if there is one)
+  struct CsvColumn {
+    uint32_t field;
+    ColumnType type;
+  };
+
+  struct CsvOptions {
+    char delim = ',';
+    // skip the first line
+    bool header = false;
+    size_t chunk_rows = size_t(1) << 16;
+    // ask for transparent huge pages on the mapping; ignored where the
+    // kernel doesn't support them for files
+    bool huge_pages = false;
+  };
+
+  // One chunk of rows, one typed buffer per requested column, reused from
+  // chunk to chunk. Fields that don't parse, and fields missing from short
+  // rows, are written as 0 and flagged in bad(), one bit per row over
+  // (rows()+63)/64 words, as in the bulk converters.
+  class CsvChunk {
+  public:
+    size_t rows() const { return _rows; }
+    // data rows before this chunk, not counting the header or blank lines
+    size_t first_row() const { return _first_row; }
+    size_t columns() const { return _columns.size(); }
+    ColumnType type(size_t col) const { return _columns.at(col).type; }
+    // T must match the column type: timestamp_t, date_t, int64_t or double;
+    // instantiated for those in elf_csv.cpp
+    template <typename T>
+    const T* column(size_t col) const;
+    const uint64_t* bad(size_t col) const { return _columns.at(col).bad.data(); }
+    size_t bad_count(size_t col) const { return _columns.at(col).n_bad; }
+
+  private:
+    friend class CsvReader;
+
+    // one alternative per ColumnType, in the same order
+    using Values = std::variant<std::vector<timestamp_t>, std::vector<date_t>, std::vector<int64_t>, std::vector<double>>;
+
+    struct Column {
+      ColumnType type;
+      // chunk_rows values of the column type
+      Values values;
+      std::vector<uint64_t> bad;
+      size_t n_bad;
+
+      // sized for rows values of type, keeping the buffers of a column
+      // whose type is unchanged
+      void reset(ColumnType type, size_t rows);
+    };
+
+    size_t _rows = 0;
+    size_t _first_row = 0;
+    std::vector<Column> _columns;
+  };
+
+  // Streaming reader for delimited text: the file is mapped read-only and
+  // walked once, 64 bytes at a time, with delimiters and newlines found as
+  // bitmasks (AVX2 or SSE2 compares) and visited with ctz. Requested fields
+  // go straight from the mapping to the parsers; other fields are skipped,
+  // as is the rest of a row past the last requested field. Pages already
+  // read are released after each chunk, so memory use is bounded by the
+  // chunk size rather than the file size.
+  //
+  // Rows end at \n, with a trailing \r dropped; the last row may lack the
+  // newline. Blank lines are skipped. There is no quoting: a delimiter
+  // always ends a field.
+  class CsvReader {
+  public:
+    static constexpr size_t max_columns = 64;
+
+    CsvReader(const std::string& path, std::vector<CsvColumn> columns, CsvOptions options=CsvOptions());
+
+    // parses up to chunk_rows rows into chunk; false once the file is done
+    bool next(CsvChunk& chunk);
+
+  private:
+    template <typename Classify>
+    size_t parse_rows(CsvChunk& chunk, Classify classify);
+    void parse_field(CsvChunk& chunk, size_t col, size_t row, const char* p, size_t len);
+    void finish_row(CsvChunk& chunk, size_t row, uint64_t filled);
+    void release_consumed();
+
+    std::shared_ptr<const void> _map;
+    const char* _base = nullptr;
+    size_t _size = 0;
+    size_t _pos = 0;
+    size_t _released = 0;
+    size_t _rows = 0;
+    std::vector<CsvColumn> _columns;
+    // column index for each field up to the last requested one, -1 if unused
+    std::vector<int8_t> _slot;
+    CsvOptions _options;
+  };
+
+  namespace detail {
+    template <typename T> struct column_type_of;
+    template <> struct column_type_of<timestamp_t> { static constexpr ColumnType value = ColumnType::timestamp; };
+    template <> struct column_type_of<date_t> { static constexpr ColumnType value = ColumnType::date; };
+    template <> struct column_type_of<int64_t> { static constexpr ColumnType value = ColumnType::int64; };
+    template <> struct column_type_of<double> { static constexpr ColumnType value = ColumnType::float64; };
+  }
+}
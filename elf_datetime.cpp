@@ -0,0 +1,462 @@
+#include "elf_datetime.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+using namespace elf;
+
+namespace {
+  constexpr int64_t secs_per_day = 86400;
+  constexpr int32_t no_transition = 86400;
+  constexpr int32_t many_transitions = -1;
+  // the tables, and the transitions expanded from the rule, cover [1970, 2100)
+  constexpr int32_t table_end_year = 2100;
+  const int64_t table_days = days_from_civil(table_end_year, 1, 1);
+
+  // big-endian signed integer of n bytes
+  int64_t
+  read_be(const unsigned char* p, size_t n) {
+    uint64_t v = 0;
+    for(size_t i = 0; i < n; ++i)
+      v = v << 8 | p[i];
+    // sign-extend from the top bit of the first byte, in unsigned arithmetic
+    // so that a full 8-byte field cannot overflow
+    const uint64_t sign = uint64_t(1) << (8 * n - 1);
+    return int64_t((v ^ sign) - sign);
+  }
+
+  uint32_t
+  read_be32(const unsigned char* p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+  }
+
+  // header counts are unsigned 32-bit, so data_len cannot wrap a 64-bit size_t
+  struct TzifCounts {
+    uint32_t isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt;
+
+    size_t data_len(size_t time_size) const {
+      return size_t(timecnt) * time_size + timecnt + size_t(typecnt) * 6 + charcnt
+        + size_t(leapcnt) * (time_size + 4) + isstdcnt + isutcnt;
+    }
+  };
+
+  bool
+  read_tzif_header(const string& data, size_t at, TzifCounts& c) {
+    if(data.size() < at + 44 || data.compare(at, 4, "TZif"))
+      return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data()) + at + 20;
+    c.isutcnt = read_be32(p);
+    c.isstdcnt = read_be32(p + 4);
+    c.leapcnt = read_be32(p + 8);
+    c.timecnt = read_be32(p + 12);
+    c.typecnt = read_be32(p + 16);
+    c.charcnt = read_be32(p + 20);
+    // RFC 8536: one-byte type indices, and the indicator arrays are empty or one per type
+    return c.typecnt > 0 && c.typecnt <= 256
+      && (c.isstdcnt == 0 || c.isstdcnt == c.typecnt)
+      && (c.isutcnt == 0 || c.isutcnt == c.typecnt);
+  }
+
+  // POSIX TZ fields: a zone name, alphabetic or <quoted>
+  bool
+  parse_tz_name(string_view& s) {
+    size_t n = 0;
+    if(!s.empty() && s[0] == '<') {
+      n = s.find('>');
+      if(n == string_view::npos)
+        return false;
+      ++n;
+    } else {
+      while(n < s.size() && isalpha(static_cast<unsigned char>(s[n])))
+        ++n;
+      if(n < 3)
+        return false;
+    }
+    s.remove_prefix(n);
+    return true;
+  }
+
+  // [+-]hh[:mm[:ss]] in seconds; hours up to 167 for rule times
+  bool
+  parse_tz_time(string_view& s, int32_t& out) {
+    int32_t sign = 1;
+    if(!s.empty() && (s[0] == '+' || s[0] == '-')) {
+      sign = s[0] == '-' ? -1 : 1;
+      s.remove_prefix(1);
+    }
+    int32_t fields[3] = { 0, 0, 0 };
+    for(int f = 0; f < 3; ++f) {
+      if(f) {
+        if(s.empty() || s[0] != ':')
+          break;
+        s.remove_prefix(1);
+      }
+      size_t n = 0;
+      for(; n < s.size() && n < 3 && isdigit(static_cast<unsigned char>(s[n])); ++n)
+        fields[f] = fields[f] * 10 + (s[n] - '0');
+      if(!n)
+        return false;
+      s.remove_prefix(n);
+    }
+    out = sign * (fields[0] * 3600 + fields[1] * 60 + fields[2]);
+    return true;
+  }
+
+  bool
+  parse_tz_int(string_view& s, int32_t& out) {
+    size_t n = 0;
+    out = 0;
+    for(; n < s.size() && n < 3 && isdigit(static_cast<unsigned char>(s[n])); ++n)
+      out = out * 10 + (s[n] - '0');
+    s.remove_prefix(n);
+    return n > 0;
+  }
+}
+
+string
+DateTime::str() const {
+  char buf[max_str_len];
+  return string(buf, format_to(buf));
+}
+
+size_t
+DateTime::format_to(char* buf) const {
+  char* p = buf + date().format_to(buf);
+  const timestamp_t tod = _t % TimeConstants::ticks_per_day;
+  *p++ = '-';
+  p = detail::write_2d(p, tod / TimeConstants::ticks_per_hour);
+  p = detail::write_2d(p, tod / TimeConstants::ticks_per_minute % 60);
+  p = detail::write_2d(p, tod / TimeConstants::ticks_per_second % 60);
+  *p++ = '.';
+  p = detail::write_6d(p, tod % TimeConstants::ticks_per_second);
+  return p - buf;
+}
+
+TimeZone::TimeZone(const string& name)
+  : _name(name) {
+  if(name != "UTC") {
+    if(!name.empty() && name[0] == '/') {
+      load_tzif(name);
+    } else {
+      const char* tzdir = ::getenv("TZDIR");
+      const string path = string(tzdir && *tzdir ? tzdir : "/usr/share/zoneinfo") + "/" + name;
+      if(ifstream(path, ios::binary)) {
+        load_tzif(path);
+      } else {
+        // not a zone file; accept a bare POSIX rule such as EST5EDT,M3.2.0,M11.1.0
+        try {
+          parse_rule(name);
+        } catch(const elf_error&) {
+          throw elf_error(ErrorCode::io, "timezone: cannot open", "zone={}", name);
+        }
+        _initial_offset = _rule.std_offset;
+      }
+    }
+  }
+  extend_transitions();
+  build_tables();
+}
+
+const TimeZone&
+TimeZone::get(const string& name) {
+  static mutex lock;
+  static unordered_map<string, unique_ptr<TimeZone>> zones;
+  lock_guard<mutex> guard(lock);
+  auto& zone = zones[name];
+  if(!zone)
+    zone = make_unique<TimeZone>(name);
+  return *zone;
+}
+
+const TimeZone&
+TimeZone::local() {
+  const char* tz = ::getenv("TZ");
+  if(tz && *tz)
+    return get(tz[0] == ':' ? tz + 1 : tz);
+  return get("/etc/localtime");
+}
+
+void
+TimeZone::load_tzif(const string& path) {
+  ifstream in(path, ios::binary);
+  if(!in)
+    throw elf_error(ErrorCode::io, "timezone: cannot open", "path={}", path);
+  const string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+  TzifCounts c;
+  if(!read_tzif_header(data, 0, c))
+    throw elf_error(ErrorCode::bad_format, "timezone: not a tzif file", "path={}", path);
+
+  // version 2+ files repeat the data with 64-bit times, then a POSIX rule
+  size_t at = 44;
+  size_t time_size = 4;
+  if(data[4] >= '2') {
+    at += c.data_len(4);
+    if(!read_tzif_header(data, at, c))
+      throw elf_error(ErrorCode::bad_format, "timezone: bad tzif v2 header", "path={}", path);
+    at += 44;
+    time_size = 8;
+  }
+  if(data.size() < at + c.data_len(time_size))
+    throw elf_error(ErrorCode::bad_format, "timezone: truncated tzif file", "path={}", path);
+
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data()) + at;
+  const unsigned char* indices = p + c.timecnt * time_size;
+  const unsigned char* types = indices + c.timecnt;
+  auto type_offset = [&](size_t type) {
+    return static_cast<int32_t>(read_be(types + 6 * type, 4));
+  };
+
+  _initial_offset = type_offset(0);
+  int32_t current = _initial_offset;
+  for(size_t i = 0; i < c.timecnt; ++i) {
+    const int64_t when = read_be(p + i * time_size, time_size);
+    if(indices[i] >= c.typecnt || (!_utc_keys.empty() && when <= _utc_keys.back()))
+      throw elf_error(ErrorCode::bad_format, "timezone: bad tzif transition", "path={}", path);
+    const int32_t offset = type_offset(indices[i]);
+    // keep only transitions that move the clock
+    if(offset == current)
+      continue;
+    _utc_keys.push_back(when);
+    _offsets.push_back(offset);
+    current = offset;
+  }
+
+  if(time_size == 8) {
+    const size_t footer = at + c.data_len(time_size);
+    const size_t footer_end = data.find('\n', footer + 1);
+    if(footer < data.size() && data[footer] == '\n' && footer_end != string::npos && footer_end > footer + 1)
+      parse_rule(string_view(data).substr(footer + 1, footer_end - footer - 1));
+  }
+}
+
+void
+TimeZone::parse_rule(string_view tz) {
+  const string text(tz);
+  auto fail = [&] {
+    return elf_error(ErrorCode::bad_format, "timezone: bad tz", "rule={}", text);
+  };
+
+  Rule rule;
+  int32_t offset;
+  // POSIX offsets count hours west of UTC
+  if(!parse_tz_name(tz) || !parse_tz_time(tz, offset))
+    throw fail();
+  rule.std_offset = -offset;
+  rule.dst_offset = rule.std_offset;
+
+  if(!tz.empty()) {
+    if(!parse_tz_name(tz))
+      throw fail();
+    rule.has_dst = true;
+    rule.dst_offset = rule.std_offset + 3600;
+    if(!tz.empty() && tz[0] != ',') {
+      if(!parse_tz_time(tz, offset))
+        throw fail();
+      rule.dst_offset = -offset;
+    }
+
+    if(tz.empty())
+      tz = ",M3.2.0,M11.1.0";
+    for(Rule::When* when: { &rule.start, &rule.end }) {
+      if(tz.empty() || tz[0] != ',')
+        throw fail();
+      tz.remove_prefix(1);
+      if(!tz.empty() && tz[0] == 'M') {
+        tz.remove_prefix(1);
+        when->kind = Rule::When::Kind::month_week_day;
+        if(!parse_tz_int(tz, when->month) || tz.empty() || tz[0] != '.')
+          throw fail();
+        tz.remove_prefix(1);
+        if(!parse_tz_int(tz, when->week) || tz.empty() || tz[0] != '.')
+          throw fail();
+        tz.remove_prefix(1);
+        if(!parse_tz_int(tz, when->day))
+          throw fail();
+        if(when->month < 1 || when->month > 12 || when->week < 1 || when->week > 5 || when->day > 6)
+          throw fail();
+      } else {
+        when->kind = Rule::When::Kind::julian;
+        if(!tz.empty() && tz[0] == 'J') {
+          tz.remove_prefix(1);
+          when->kind = Rule::When::Kind::julian_no_leap;
+        }
+        if(!parse_tz_int(tz, when->day))
+          throw fail();
+      }
+      if(!tz.empty() && tz[0] == '/') {
+        tz.remove_prefix(1);
+        if(!parse_tz_time(tz, when->time))
+          throw fail();
+      }
+    }
+  }
+  if(!tz.empty())
+    throw fail();
+
+  _rule = rule;
+  _has_rule = true;
+}
+
+void
+TimeZone::rule_transitions(int32_t year, int64_t& start, int64_t& end) const {
+  auto day_of = [year](const Rule::When& when) -> int64_t {
+    const int64_t jan1 = days_from_civil(year, 1, 1);
+    switch(when.kind) {
+    case Rule::When::Kind::julian_no_leap:
+      return jan1 + when.day - 1 + (is_leap_year(year) && when.day >= 60);
+    case Rule::When::Kind::julian:
+      return jan1 + when.day;
+    default: {
+      const int64_t first = days_from_civil(year, when.month, 1);
+      const int64_t next = when.month == 12 ? days_from_civil(year + 1, 1, 1) : days_from_civil(year, when.month + 1, 1);
+      const int64_t first_weekday = ((first + 4) % 7 + 7) % 7;
+      int64_t day = first + (when.day - first_weekday + 7) % 7 + (when.week - 1) * 7;
+      while(day >= next)
+        day -= 7;
+      return day;
+    }
+    }
+  };
+  // start is read on standard time, end on daylight time
+  start = day_of(_rule.start) * secs_per_day + _rule.start.time - _rule.std_offset;
+  end = day_of(_rule.end) * secs_per_day + _rule.end.time - _rule.dst_offset;
+}
+
+void
+TimeZone::extend_transitions() {
+  if(_has_rule && _rule.has_dst) {
+    const int64_t last = _utc_keys.empty() ? INT64_MIN : _utc_keys.back();
+    const int32_t first_year = _utc_keys.empty() ? 1970 : date_from_days(static_cast<days_t>(last / secs_per_day)) / 10000;
+    for(int32_t year = std::max(first_year, 1970); year <= table_end_year; ++year) {
+      int64_t start, end;
+      rule_transitions(year, start, end);
+      const pair<int64_t, int32_t> ordered[2] = {
+        start < end ? make_pair(start, _rule.dst_offset) : make_pair(end, _rule.std_offset),
+        start < end ? make_pair(end, _rule.std_offset) : make_pair(start, _rule.dst_offset),
+      };
+      for(auto& [when, offset]: ordered) {
+        const int32_t current = _offsets.empty() ? _initial_offset : _offsets.back();
+        if(when <= last || offset == current)
+          continue;
+        _utc_keys.push_back(when);
+        _offsets.push_back(offset);
+      }
+    }
+  }
+
+  // a local key is where the later clock takes over: the end of a gap, or
+  // the end of an overlap on the earlier clock
+  _local_keys.resize(_utc_keys.size());
+  for(size_t i = 0; i < _utc_keys.size(); ++i)
+    _local_keys[i] = _utc_keys[i] + std::max(i ? _offsets[i - 1] : _initial_offset, _offsets[i]);
+}
+
+void
+TimeZone::build_tables() {
+  auto build = [this](const vector<int64_t>& keys, vector<DayOffsets>& days) {
+    days.resize(table_days);
+    size_t k = 0;
+    for(int64_t d = 0; d < table_days; ++d) {
+      const int64_t lo = d * secs_per_day, hi = lo + secs_per_day;
+      while(k < keys.size() && keys[k] <= lo)
+        ++k;
+      size_t j = k;
+      while(j < keys.size() && keys[j] < hi)
+        ++j;
+      const int32_t before = k ? _offsets[k - 1] : _initial_offset;
+      if(j == k)
+        days[d] = { before, before, no_transition };
+      else if(j == k + 1)
+        days[d] = { before, _offsets[k], static_cast<int32_t>(keys[k] - lo) };
+      else
+        days[d] = { before, _offsets[j - 1], many_transitions };
+    }
+  };
+  build(_utc_keys, _utc_days);
+  build(_local_keys, _local_days);
+}
+
+int32_t
+TimeZone::rule_offset(int64_t sec, bool local) const {
+  if(!_rule.has_dst)
+    return _rule.std_offset;
+  const int32_t year = date_from_days(static_cast<days_t>(sec / secs_per_day)) / 10000;
+  int64_t start, end;
+  rule_transitions(year, start, end);
+  if(local) {
+    // as the local keys: the later clock takes over past a gap or overlap
+    const int32_t later = std::max(_rule.std_offset, _rule.dst_offset);
+    start += later;
+    end += later;
+  }
+  const bool dst = start < end ? sec >= start && sec < end : sec < end || sec >= start;
+  return dst ? _rule.dst_offset : _rule.std_offset;
+}
+
+int32_t
+TimeZone::slow_offset(int64_t sec, bool local) const {
+  if(_has_rule && sec >= table_days * secs_per_day)
+    return rule_offset(sec, local);
+  const vector<int64_t>& keys = local ? _local_keys : _utc_keys;
+  const size_t i = upper_bound(keys.begin(), keys.end(), sec) - keys.begin();
+  return i ? _offsets[i - 1] : _initial_offset;
+}
+
+inline int32_t
+TimeZone::offset_of(timestamp_t t, bool local) const {
+  const timestamp_t day = t / TimeConstants::ticks_per_day;
+  const vector<DayOffsets>& days = local ? _local_days : _utc_days;
+  if(day < days.size()) {
+    const DayOffsets& e = days[day];
+    if(e.transition != many_transitions) {
+      const timestamp_t tod = t - day * TimeConstants::ticks_per_day;
+      return tod >= static_cast<timestamp_t>(e.transition) * TimeConstants::ticks_per_second ? e.after : e.before;
+    }
+  }
+  return slow_offset(static_cast<int64_t>(t / TimeConstants::ticks_per_second), local);
+}
+
+int32_t
+TimeZone::utc_offset(DateTime utc) const {
+  return offset_of(utc._t, false);
+}
+
+inline timestamp_t
+TimeZone::shift(timestamp_t t, int32_t offset) const {
+  const int64_t delta = int64_t(offset) * TimeConstants::ticks_per_second;
+  if(delta < 0 && t < static_cast<timestamp_t>(-delta))
+    throw elf_error(ErrorCode::out_of_bounds, "timezone: result before 1970", "zone={} input={}", _name, DateTime(t));
+  return t + static_cast<timestamp_t>(delta);
+}
+
+DateTime
+TimeZone::to_local(DateTime utc) const {
+  return DateTime(shift(utc._t, offset_of(utc._t, false)));
+}
+
+DateTime
+TimeZone::to_utc(DateTime local) const {
+  return DateTime(shift(local._t, -offset_of(local._t, true)));
+}
+
+void
+TimeZone::to_local(const timestamp_t* utc, size_t n, timestamp_t* local) const {
+  for(size_t i = 0; i < n; ++i)
+    local[i] = shift(utc[i], offset_of(utc[i], false));
+}
+
+void
+TimeZone::to_utc(const timestamp_t* local, size_t n, timestamp_t* utc) const {
+  for(size_t i = 0; i < n; ++i)
+    utc[i] = shift(local[i], -offset_of(local[i], true));
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace elf {
+  // Date and time of day as ticks since 1970-01-01 00:00 of some clock. A
+  // DateTime carries no zone: it is a UTC instant or a local wall-clock
+  // reading depending on where it came from, and TimeZone converts between
+  // the two.
+  struct DateTime {
+    constexpr DateTime()
+      : _t(0) {}
+    constexpr explicit DateTime(timestamp_t t)
+      : _t(t) {}
+    DateTime(const Date& date, const Timestamp& ts)
+      : _t(date.to_days() * TimeConstants::ticks_per_day + ts.get()) {}
+
+    static DateTime from_go_ts(std::string_view s) { return DateTime(epoch_from_go_ts(s)); }
+
+    days_t days() const { return static_cast<days_t>(_t / TimeConstants::ticks_per_day); }
+    Date date() const { return Date::from_days(days()); }
+    Timestamp time() const { return Timestamp(_t % TimeConstants::ticks_per_day); }
+    constexpr timestamp_t get() const { return _t; }
+
+    // 20220203-104528.093817, the from_go_ts form
+    std::string str() const;
+    size_t format_to(char* buf) const;
+
+    static constexpr size_t max_str_len = 32;
+    timestamp_t _t;
+  };
+
+  inline bool operator==(const DateTime& a, const DateTime& b) { return a._t == b._t; }
+  inline bool operator!=(const DateTime& a, const DateTime& b) { return a._t != b._t; }
+  inline bool operator<(const DateTime& a, const DateTime& b) { return a._t < b._t; }
+  inline bool operator<=(const DateTime& a, const DateTime& b) { return a._t <= b._t; }
+  inline bool operator>(const DateTime& a, const DateTime& b) { return a._t > b._t; }
+  inline bool operator>=(const DateTime& a, const DateTime& b) { return a._t >= b._t; }
+  inline DateTime operator+(const DateTime& t, const Timedelta& td) { return DateTime(t._t + td._td); }
+  inline DateTime operator-(const DateTime& t, const Timedelta& td) { return DateTime(t._t - td._td); }
+  inline Timedelta operator-(const DateTime& a, const DateTime& b) { return Timedelta(static_cast<timedelta_t>(a._t - b._t)); }
+
+  // UTC offsets of one zone, loaded once from a TZif file (the system
+  // tzdata) and expanded into a table per UTC day and per local day over
+  // [1970, 2100). Conversion inside that range is a table lookup and an
+  // add. Days with more than one transition, and instants outside the
+  // range, fall back to a binary search and the zone's POSIX rule.
+  //
+  // A local time inside a spring-forward gap or a fall-back overlap is
+  // read on the clock in force before the transition, so an ambiguous
+  // time maps to its first occurrence.
+  //
+  // Instances are immutable and safe to share between threads.
+  class TimeZone {
+  public:
+    // IANA name such as "America/New_York", resolved under $TZDIR or
+    // /usr/share/zoneinfo; an absolute path to a TZif file; or "UTC"
+    explicit TimeZone(const std::string& name);
+
+    // process-wide cache, loading each zone on first use
+    static const TimeZone& get(const std::string& name);
+    // $TZ if set, otherwise /etc/localtime
+    static const TimeZone& local();
+
+    const std::string& name() const { return _name; }
+    // seconds east of UTC at the given instant
+    int32_t utc_offset(DateTime utc) const;
+
+    // a result before the epoch, as west of UTC on 1970-01-01, throws
+    // elf_error
+    DateTime to_local(DateTime utc) const;
+    DateTime to_utc(DateTime local) const;
+    DateTime to_utc(const Date& date, const Timestamp& local) const { return to_utc(DateTime(date, local)); }
+
+    // bulk forms over epoch ticks; in and out may alias, and out is left
+    // partly written if a row throws
+    void to_local(const timestamp_t* utc, size_t n, timestamp_t* local) const;
+    void to_utc(const timestamp_t* local, size_t n, timestamp_t* utc) const;
+
+  private:
+    // one day of the table; transition is the second of the day at which
+    // after replaces before, on the clock the table is keyed by. 86400 means
+    // no transition and -1 more than one.
+    struct DayOffsets {
+      int32_t before;
+      int32_t after;
+      int32_t transition;
+    };
+
+    // POSIX TZ rule from the TZif footer, used past the last transition
+    struct Rule {
+      struct When {
+        enum class Kind { julian_no_leap, julian, month_week_day } kind = Kind::month_week_day;
+        int32_t day = 0;
+        int32_t week = 0;
+        int32_t month = 0;
+        int32_t time = 7200;
+      };
+      int32_t std_offset = 0;
+      int32_t dst_offset = 0;
+      bool has_dst = false;
+      When start;
+      When end;
+    };
+
+    void load_tzif(const std::string& path);
+    void parse_rule(std::string_view tz);
+    void extend_transitions();
+    void build_tables();
+    // utc seconds of the year's dst start and end
+    void rule_transitions(int32_t year, int64_t& start, int64_t& end) const;
+    int32_t rule_offset(int64_t sec, bool local) const;
+    int32_t slow_offset(int64_t sec, bool local) const;
+    int32_t offset_of(timestamp_t t, bool local) const;
+    // t moved by offset seconds, checked against the epoch
+    timestamp_t shift(timestamp_t t, int32_t offset) const;
+
+    std::string _name;
+    int32_t _initial_offset = 0;
+    // sorted transitions; _local_keys[i] is the transition in utc plus the
+    // later of the offsets either side of it, so local times in a gap read
+    // on the earlier clock and ones in an overlap resolve to their first
+    // occurrence
+    std::vector<int64_t> _utc_keys;
+    std::vector<int64_t> _local_keys;
+    std::vector<int32_t> _offsets;
+    Rule _rule;
+    bool _has_rule = false;
+    std::vector<DayOffsets> _utc_days;
+    std::vector<DayOffsets> _local_days;
+  };
+}
+
+template <> struct fmt::formatter<elf::DateTime> : elf::detail::elf_time_formatter<elf::DateTime> {};
@@ -1,17 +1,30 @@
 #include "elf_exception.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace std;
 using namespace elf;
 
-elf_error::elf_error(const string& msg) {
-  _msg = msg;
+elf_error::elf_error(const string& msg)
+  : _message(nullptr), _code(ErrorCode::unspecified) {
+  const size_t len = std::min(msg.size(), max_what_len);
+  memcpy(_what, msg.data(), len);
+  _what[len] = '\0';
 }
 
-elf_error::elf_error(const elf_error& other) {
-  _msg = other.what();
+elf_error::elf_error(ErrorCode code, const char* message)
+  : _message(message), _code(code) {
+  const size_t len = std::min(strlen(message), max_what_len);
+  memcpy(_what, message, len);
+  _what[len] = '\0';
 }
 
-const string&
-elf_error::what() const {
-  return _msg;
+char*
+elf_error::begin_context() {
+  // keep room for at least the separator
+  const size_t len = std::min(strlen(_message), max_what_len - 1);
+  memcpy(_what, _message, len);
+  _what[len] = ' ';
+  return _what + len + 1;
 }
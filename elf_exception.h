@@ -1,16 +1,47 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <string>
+#include <utility>
+
+#include <fmt/core.h>
 
 namespace elf {
-  class elf_error {
+  enum class ErrorCode : uint8_t { unspecified, bad_format, out_of_bounds, invalid_argument, io };
+
+  // what() is "<message> <context>": message is a string literal kept by
+  // pointer, context is formatted with fmt into an inline buffer, truncated
+  // to fit. Nothing is allocated on construction; copies are flat.
+  class elf_error : public std::exception {
   public:
+    static constexpr size_t max_what_len = 255;
+
     elf_error() = delete;
+    // the whole text as what(), for callers that already built a string
     elf_error(const std::string& msg);
-    elf_error(const elf_error& other);
-    virtual const std::string& what() const;
-    
+    elf_error(ErrorCode code, const char* message);
+
+    template <typename... Args>
+    elf_error(ErrorCode code, const char* message, fmt::format_string<Args...> context, Args&&... args)
+      : _message(message), _code(code) {
+      char* p = begin_context();
+      const auto r = fmt::format_to_n(p, _what + max_what_len - p, context, std::forward<Args>(args)...);
+      *r.out = '\0';
+    }
+
+    const char* what() const noexcept override { return _what; }
+    // the static part of what(); all of it for the std::string constructor
+    const char* message() const { return _message ? _message : _what; }
+    ErrorCode code() const { return _code; }
+
   private:
-    std::string _msg;
+    // copies message and a separating space, returns where context goes
+    char* begin_context();
+
+    const char* _message;
+    ErrorCode _code;
+    char _what[max_what_len + 1];
   };
 }
@@ -0,0 +1,219 @@
+#include "elf_parallel.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+using namespace std;
+using namespace elf;
+
+// chunk indexes [begin, end) as begin << 32 | end
+struct alignas(64) Executor::Range {
+  atomic<uint64_t> bounds{0};
+};
+
+namespace {
+  constexpr uint64_t
+  pack(uint64_t begin, uint64_t end) {
+    return begin << 32 | end;
+  }
+
+  // the owner takes from the front
+  bool
+  take_front(atomic<uint64_t>& bounds, size_t& chunk) {
+    uint64_t b = bounds.load(memory_order_relaxed);
+    for(;;) {
+      const uint64_t begin = b >> 32, end = b & 0xffffffff;
+      if(begin >= end)
+        return false;
+      if(bounds.compare_exchange_weak(b, pack(begin + 1, end), memory_order_acq_rel)) {
+        chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  // a thief takes the back half, at least one chunk
+  bool
+  steal_back(atomic<uint64_t>& bounds, uint64_t& stolen) {
+    uint64_t b = bounds.load(memory_order_relaxed);
+    for(;;) {
+      const uint64_t begin = b >> 32, end = b & 0xffffffff;
+      if(begin >= end)
+        return false;
+      const uint64_t split = end - (end - begin + 1) / 2;
+      if(bounds.compare_exchange_weak(b, pack(begin, split), memory_order_acq_rel)) {
+        stolen = pack(split, end);
+        return true;
+      }
+    }
+  }
+}
+
+Executor::Executor(unsigned n_threads)
+  : _n_threads(n_threads ? n_threads : max(1u, thread::hardware_concurrency())),
+    _ranges(new Range[_n_threads]) {
+  for(unsigned i = 1; i < _n_threads; ++i)
+    _workers.emplace_back(&Executor::worker_loop, this, i);
+}
+
+Executor::~Executor() {
+  {
+    lock_guard<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _start.notify_all();
+  for(auto& t: _workers)
+    t.join();
+}
+
+void
+Executor::run_chunks(size_t n_chunks, ChunkFn fn, void* ctx) {
+  if(n_chunks == 0)
+    return;
+  if(n_chunks == 1 || _n_threads == 1) {
+    for(size_t c = 0; c < n_chunks; ++c)
+      fn(ctx, c);
+    return;
+  }
+  if(n_chunks > 0xffffffff)
+    throw elf_error(ErrorCode::out_of_bounds, "executor: too many chunks", "n={}", n_chunks);
+
+  lock_guard<mutex> run_lock(_run_mutex);
+  for(unsigned i = 0; i < _n_threads; ++i)
+    _ranges[i].bounds.store(pack(n_chunks * i / _n_threads, n_chunks * (i + 1) / _n_threads), memory_order_relaxed);
+  {
+    lock_guard<mutex> lock(_mutex);
+    _fn = fn;
+    _ctx = ctx;
+    _busy = _n_threads - 1;
+    ++_generation;
+  }
+  _start.notify_all();
+  work(0);
+  unique_lock<mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _busy == 0; });
+}
+
+void
+Executor::work(unsigned self) {
+  atomic<uint64_t>& own = _ranges[self].bounds;
+  for(;;) {
+    size_t chunk;
+    while(take_front(own, chunk))
+      _fn(_ctx, chunk);
+    // own range is empty, so no thief touches it until it is refilled
+    uint64_t stolen = 0;
+    for(unsigned k = 1; k < _n_threads && !stolen; ++k)
+      steal_back(_ranges[(self + k) % _n_threads].bounds, stolen);
+    if(!stolen)
+      return;
+    own.store(stolen, memory_order_release);
+  }
+}
+
+void
+Executor::worker_loop(unsigned self) {
+  uint64_t seen = 0;
+  for(;;) {
+    {
+      unique_lock<mutex> lock(_mutex);
+      _start.wait(lock, [&] { return _stop || _generation != seen; });
+      if(_stop)
+        return;
+      seen = _generation;
+    }
+    work(self);
+    bool last;
+    {
+      lock_guard<mutex> lock(_mutex);
+      last = --_busy == 0;
+    }
+    if(last)
+      _done.notify_one();
+  }
+}
+
+namespace {
+  constexpr size_t chunk_bytes = size_t(1) << 15;
+
+  // rows per chunk: a multiple of 64 holding about chunk_bytes of input
+  size_t
+  chunk_rows(size_t n, size_t input_bytes) {
+    const size_t row_bytes = max<size_t>(1, input_bytes / max<size_t>(1, n));
+    return clamp<size_t>(chunk_bytes / row_bytes / 64 * 64, 64, size_t(1) << 16);
+  }
+
+  // convert(begin, count, bad words) on every chunk; each chunk writes its
+  // own rows, bad words and count slot
+  template <typename Convert>
+  size_t
+  convert_chunked(Executor& executor, size_t n, size_t rows, uint64_t* bad, Convert convert) {
+    const size_t n_chunks = (n + rows - 1) / rows;
+    vector<size_t> n_bad(n_chunks);
+    executor.run(n_chunks, [&](size_t c) {
+      const size_t begin = c * rows;
+      n_bad[c] = convert(begin, min(rows, n - begin), bad + begin / 64);
+    });
+    return accumulate(n_bad.begin(), n_bad.end(), size_t(0));
+  }
+
+  template <typename T, typename Serial>
+  size_t
+  convert_indexed_chunked(const char* buf, const uint32_t* offsets, size_t n, T* out, uint64_t* bad,
+                          Executor& executor, Serial serial) {
+    if(!n)
+      return 0;
+    const size_t rows = chunk_rows(n, offsets[n] - offsets[0]);
+    return convert_chunked(executor, n, rows, bad, [&](size_t begin, size_t count, uint64_t* chunk_bad) {
+      return serial(buf, offsets + begin, count, out + begin, chunk_bad);
+    });
+  }
+}
+
+size_t
+elf::convert_timestamps(const char* buf, size_t width, size_t stride, size_t n,
+                        timestamp_t* out, uint64_t* bad, Executor& executor) {
+  if(!n)
+    return 0;
+  return convert_chunked(executor, n, chunk_rows(n, n * stride), bad, [&](size_t begin, size_t count, uint64_t* chunk_bad) {
+    return convert_timestamps(buf + begin * stride, width, stride, count, out + begin, chunk_bad);
+  });
+}
+
+size_t
+elf::convert_timestamps(const char* buf, const uint32_t* offsets, size_t n,
+                        timestamp_t* out, uint64_t* bad, Executor& executor) {
+  using Serial = size_t (*)(const char*, const uint32_t*, size_t, timestamp_t*, uint64_t*);
+  return convert_indexed_chunked(buf, offsets, n, out, bad, executor, static_cast<Serial>(convert_timestamps));
+}
+
+size_t
+elf::convert_dates(const char* buf, const uint32_t* offsets, size_t n,
+                   date_t* out, uint64_t* bad, Executor& executor) {
+  using Serial = size_t (*)(const char*, const uint32_t*, size_t, date_t*, uint64_t*);
+  return convert_indexed_chunked(buf, offsets, n, out, bad, executor, static_cast<Serial>(convert_dates));
+}
+
+size_t
+elf::convert_timedeltas(const char* buf, const uint32_t* offsets, size_t n,
+                        timedelta_t* out, uint64_t* bad, Executor& executor) {
+  using Serial = size_t (*)(const char*, const uint32_t*, size_t, timedelta_t*, uint64_t*);
+  return convert_indexed_chunked(buf, offsets, n, out, bad, executor, static_cast<Serial>(convert_timedeltas));
+}
+
+size_t
+elf::convert_integers(const char* buf, const uint32_t* offsets, size_t n,
+                      int64_t* out, uint64_t* bad, Executor& executor) {
+  using Serial = size_t (*)(const char*, const uint32_t*, size_t, int64_t*, uint64_t*);
+  return convert_indexed_chunked(buf, offsets, n, out, bad, executor, static_cast<Serial>(convert_integers));
+}
+
+size_t
+elf::convert_doubles(const char* buf, const uint32_t* offsets, size_t n,
+                     double* out, uint64_t* bad, Executor& executor) {
+  using Serial = size_t (*)(const char*, const uint32_t*, size_t, double*, uint64_t*);
+  return convert_indexed_chunked(buf, offsets, n, out, bad, executor, static_cast<Serial>(convert_doubles));
+}
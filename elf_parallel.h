@@ -0,0 +1,85 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace elf {
+  // Fixed pool of worker threads for chunked bulk work. run() hands out
+  // chunk indexes [0, n_chunks) as one contiguous range per thread; a
+  // thread takes chunks from the front of its own range and, once that is
+  // empty, steals the back half of another's. Ranges are packed into one
+  // atomic word each, so neither taking nor stealing locks. The calling
+  // thread works too, so threads() includes it.
+  //
+  // One run() at a time per executor; concurrent callers queue. fn must
+  // not throw.
+  class Executor {
+  public:
+    // 0 means one per hardware thread
+    explicit Executor(unsigned n_threads=0);
+    ~Executor();
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    unsigned threads() const { return _n_threads; }
+
+    // fn(chunk) once for every chunk in [0, n_chunks), returning when all
+    // are done
+    template <typename Fn>
+    void
+    run(size_t n_chunks, Fn&& fn) {
+      using F = std::remove_reference_t<Fn>;
+      run_chunks(n_chunks, [](void* f, size_t chunk) { (*static_cast<F*>(f))(chunk); },
+                 const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+  private:
+    using ChunkFn = void (*)(void*, size_t);
+
+    struct alignas(64) Range;
+
+    void run_chunks(size_t n_chunks, ChunkFn fn, void* ctx);
+    void work(unsigned self);
+    void worker_loop(unsigned self);
+
+    unsigned _n_threads;
+    std::unique_ptr<Range[]> _ranges;
+    std::vector<std::thread> _workers;
+
+    std::mutex _run_mutex;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    uint64_t _generation = 0;
+    unsigned _busy = 0;
+    bool _stop = false;
+    ChunkFn _fn = nullptr;
+    void* _ctx = nullptr;
+  };
+
+  // The bulk converters split into chunks over an executor. Chunks are a
+  // multiple of 64 rows, so each owns whole words of bad and a per-chunk
+  // bad count; nothing is shared between threads while they run. Chunks
+  // are sized to keep about 32KB of input in flight per thread. out, bad
+  // and the return value are the same as for the single-threaded call.
+  size_t convert_timestamps(const char* buf, size_t width, size_t stride, size_t n,
+                            timestamp_t* out, uint64_t* bad, Executor& executor);
+  size_t convert_timestamps(const char* buf, const uint32_t* offsets, size_t n,
+                            timestamp_t* out, uint64_t* bad, Executor& executor);
+  size_t convert_dates(const char* buf, const uint32_t* offsets, size_t n,
+                       date_t* out, uint64_t* bad, Executor& executor);
+  size_t convert_timedeltas(const char* buf, const uint32_t* offsets, size_t n,
+                            timedelta_t* out, uint64_t* bad, Executor& executor);
+  size_t convert_integers(const char* buf, const uint32_t* offsets, size_t n,
+                          int64_t* out, uint64_t* bad, Executor& executor);
+  size_t convert_doubles(const char* buf, const uint32_t* offsets, size_t n,
+                         double* out, uint64_t* bad, Executor& executor);
+}
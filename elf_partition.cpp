@@ -0,0 +1,88 @@
+#include "elf_partition.h"
+#include "elf_exception.h"
+
+#include <algorithm>
+#include <system_error>
+
+using namespace std;
+using namespace elf;
+namespace fs = std::filesystem;
+
+DatePartitionIndex::DatePartitionIndex(const string& root)
+  : _root(root) {
+  error_code ec;
+  if(!fs::is_directory(_root, ec))
+    throw elf_error(ErrorCode::io, "date_partition_index: not a directory", "root={}", _root);
+  refresh();
+}
+
+bool
+DatePartitionIndex::scan_dir(const string& dir, DirMap& old_dirs, DirMap& new_dirs) {
+  error_code ec;
+  const fs::path dir_path = dir.empty() ? fs::path(_root) : fs::path(_root) / dir;
+  const auto mtime = fs::last_write_time(dir_path, ec);
+  if(ec)
+    return true;
+
+  bool changed = false;
+  auto old_it = old_dirs.find(dir);
+  DirState state;
+  if(old_it != old_dirs.end() && old_it->second.mtime == mtime) {
+    state = std::move(old_it->second);
+  } else {
+    changed = true;
+    state.mtime = mtime;
+    for(fs::directory_iterator it(dir_path, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+      const string name = it->path().filename().string();
+      const string rel = dir.empty() ? name : dir + '/' + name;
+      // an entry that cannot be stat'ed is skipped, as is a symlinked
+      // directory; ec is the listing's own
+      error_code entry_ec;
+      const bool is_link = it->is_symlink(entry_ec);
+      const bool is_dir = !entry_ec && it->is_directory(entry_ec);
+      if(entry_ec || (is_link && is_dir))
+        continue;
+      if(is_dir) {
+        state.subdirs.push_back(rel);
+      } else {
+        const date_t date = find_date_in_name(rel);
+        if(validate_date(date))
+          state.files.push_back(Entry{date, rel});
+      }
+    }
+  }
+
+  const vector<string> subdirs = state.subdirs;
+  new_dirs.emplace(dir, std::move(state));
+  for(auto& subdir: subdirs)
+    changed |= scan_dir(subdir, old_dirs, new_dirs);
+  return changed;
+}
+
+bool
+DatePartitionIndex::refresh() {
+  DirMap dirs;
+  bool changed = scan_dir("", _dirs, dirs);
+  // directories that disappeared were never visited
+  changed |= dirs.size() != _dirs.size();
+  _dirs = std::move(dirs);
+  if(!changed)
+    return false;
+
+  _entries.clear();
+  for(auto& dir: _dirs)
+    _entries.insert(_entries.end(), dir.second.files.begin(), dir.second.files.end());
+  std::sort(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) {
+    return a.date != b.date ? a.date < b.date : a.path < b.path;
+  });
+  return true;
+}
+
+DatePartitionIndex::Range
+DatePartitionIndex::files(date_t from, date_t to) const {
+  auto begin = std::lower_bound(_entries.begin(), _entries.end(), from,
+                                [](const Entry& e, date_t d) { return e.date < d; });
+  auto end = std::upper_bound(begin, _entries.end(), to,
+                              [](date_t d, const Entry& e) { return d < e.date; });
+  return Range{begin, std::max(begin, end)};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "elf_time.h"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace elf {
+  // Date -> files index over a directory tree. Each file is keyed by the
+  // last 8-digit date in its path relative to the root, so both dated file
+  // names and dated directories work; files without a valid date are
+  // skipped. Symlinked directories are skipped, neither followed nor
+  // indexed as files; symlinked files are indexed. refresh() only relists
+  // directories whose mtime changed.
+  class DatePartitionIndex {
+  public:
+    struct Entry {
+      date_t date;
+      std::string path;
+    };
+    using const_iterator = std::vector<Entry>::const_iterator;
+
+    // A view into the index, like a container's iterators: valid until a
+    // refresh() that returns true, which rebuilds the entries. Copy what
+    // must outlive it.
+    struct Range {
+      const_iterator begin() const { return _begin; }
+      const_iterator end() const { return _end; }
+      size_t size() const { return _end - _begin; }
+      bool empty() const { return _begin == _end; }
+
+      const_iterator _begin;
+      const_iterator _end;
+    };
+
+    DatePartitionIndex() = delete;
+    explicit DatePartitionIndex(const std::string& root);
+
+    // rescans changed directories; returns true if the index changed, and
+    // then invalidates every Range from files()
+    bool refresh();
+
+    // files dated in [from, to], sorted by date then path
+    Range files(date_t from, date_t to) const;
+    Range files(date_t date) const { return files(date, date); }
+    Range files() const { return Range{_entries.begin(), _entries.end()}; }
+
+    date_t first_date() const { return _entries.empty() ? INVALID_DATE : _entries.front().date; }
+    date_t last_date() const { return _entries.empty() ? INVALID_DATE : _entries.back().date; }
+    size_t size() const { return _entries.size(); }
+    const std::string& root() const { return _root; }
+
+  private:
+    struct DirState {
+      std::filesystem::file_time_type mtime;
+      std::vector<Entry> files;
+      std::vector<std::string> subdirs;
+    };
+    using DirMap = std::unordered_map<std::string, DirState>;
+
+    bool scan_dir(const std::string& dir, DirMap& old_dirs, DirMap& new_dirs);
+
+    std::string _root;
+    DirMap _dirs;
+    std::vector<Entry> _entries;
+  };
+}
@@ -2,25 +2,94 @@
 #include "elf_exception.h"
 #include "elf_util.h"
 
-#include <boost/lexical_cast.hpp>
 #include <fmt/format.h>
-#include <regex>
-#include <sys/time.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 using namespace elf;
+using elf::detail::write_2d;
+using elf::detail::write_uint;
+using elf::detail::write_6d;
+using elf::detail::write_9d;
+
+namespace {
+  inline bool
+  is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+  }
+
+  // at least two digits, like %02d
+  inline char*
+  write_2d_min(char* p, uint64_t v) {
+    return v < 100 ? write_2d(p, v) : write_uint(p, v);
+  }
+
+  // HH:MM:SS[.fff|.<Res::frac_digits>] of an intra-day or absolute tick count
+  template <typename Res>
+  inline char*
+  write_hms(char* p, timestamp_t ts, int frac_digits) {
+    const timestamp_t h = ts / Res::ticks_per_hour;
+    ts -= h * Res::ticks_per_hour;
+    const unsigned m = ts / Res::ticks_per_minute;
+    ts -= m * Res::ticks_per_minute;
+    const unsigned s = ts / Res::ticks_per_second;
+    ts -= s * Res::ticks_per_second;
+
+    p = write_2d_min(p, h);
+    *p++ = ':';
+    p = write_2d(p, m);
+    *p++ = ':';
+    p = write_2d(p, s);
+    if(frac_digits == Res::frac_digits) {
+      *p++ = '.';
+      static_assert(Res::frac_digits == 6 || Res::frac_digits == 9);
+      p = Res::frac_digits == 6 ? write_6d(p, ts) : write_9d(p, ts);
+    } else if(frac_digits == 3) {
+      const unsigned msec = ts / (Res::ticks_per_second / 1000);
+      *p++ = '.';
+      *p++ = '0' + msec / 100;
+      p = write_2d(p, msec % 100);
+    }
+    return p;
+  }
+}
 
 void
 Date::from_string(const string& s_date) {
-  if(s_date.size() != Date::required_len)
-    throw elf_error("date::from_string: invalid format input="+s_date);
-  from_int(std::strtol(s_date.c_str(), nullptr, 10));
+  const ParseResult<Date> r = try_parse(s_date);
+  switch(r.status) {
+  case ParseStatus::ok:
+    _d = r.value._d;
+    return;
+  case ParseStatus::out_of_bounds:
+    throw elf_error(ErrorCode::out_of_bounds, "date::from_string: invalid date", "input={}", s_date);
+  default:
+    throw elf_error(ErrorCode::bad_format, "date::from_string: invalid format", "input={}", s_date);
+  }
+}
+
+ParseResult<Date>
+Date::try_parse(string_view s_date) {
+  Date date;
+  uint32_t ymd;
+  if(s_date.size() != Date::required_len || !substring_atoi<Date::required_len>(s_date.data(), ymd))
+    return { date, ParseStatus::bad_format };
+  if(!validate_date(ymd))
+    return { date, ParseStatus::out_of_bounds };
+  date._d = ymd;
+  return { date, ParseStatus::ok };
 }
 
 void
 Date::from_int(date_t i_date) {
   if(!validate_date(i_date))
-    throw elf_error("date::from_string: invalid date input="+std::to_string(i_date));
+    throw elf_error(ErrorCode::out_of_bounds, "date::from_string: invalid date", "input={}", i_date);
   _d = i_date;
 }
 
@@ -31,20 +100,37 @@ Date::to_int() const {
 
 std::string
 Date::to_string() const {
-  return fmt::format("{}", _d);
+  char buf[max_str_len];
+  return string(buf, format_to(buf));
+}
+
+size_t
+Date::format_to(char* buf) const {
+  char* p = buf;
+  if(_d >= 10000000 && _d <= 99999999) {
+    p = write_2d(p, _d / 1000000);
+    p = write_2d(p, _d / 10000 % 100);
+    p = write_2d(p, _d / 100 % 100);
+    p = write_2d(p, _d % 100);
+    return p - buf;
+  }
+  if(_d < 0)
+    *p++ = '-';
+  p = write_uint(p, _d < 0 ? -static_cast<int64_t>(_d) : _d);
+  return p - buf;
 }
 
 date_t
 Date::y() const {
   if(_d==INVALID_DATE)
-    throw elf_error("date::y: not initialized");
+    throw elf_error(ErrorCode::invalid_argument, "date::y: not initialized");
   return _d / 10000;
 }
 
 date_t
 Date::m() const {
   if(_d==INVALID_DATE)
-    throw elf_error("date::m: not initialized");
+    throw elf_error(ErrorCode::invalid_argument, "date::m: not initialized");
   auto date = _d / 100;
   return date % 100;
 }
@@ -52,369 +138,887 @@ Date::m() const {
 date_t
 Date::d() const {
   if(_d==INVALID_DATE)
-    throw elf_error("date::d: not initialized");
+    throw elf_error(ErrorCode::invalid_argument, "date::d: not initialized");
   return _d % 100;
 }
 
-bool
-elf::validate_date(date_t date) {
-  if(date <= 0)
-    return false;
-
-  if(num_digits(date) != 8)
-    return false;
-
-  const int days = date % 100;
-  date /= 100;
-  const int month = date % 100;
-  date /= 100;
-  const int year = date;
-
-  if((month < 1) || (month > 12))
-    return false;
-  if((year < 1970) || (year >= 9999))
-    return false;
-
-  int enddays;
-
-  switch(month) {
-  case 1:
-  case 3:
-  case 5:
-  case 7:
-  case 8:
-  case 10:
-  case 12:
-    enddays = 31;
-    break;
-  case 4:
-  case 6:
-  case 9:
-  case 11:
-    enddays = 30;
-    break;
-  case 2:
-    // check for leap year
-    if(!(year % 4) && ((year % 100) || !(year % 400)))
-      enddays = 29;
-    else
-      enddays = 28;
-    break;
-  }
+days_t
+Date::to_days() const {
+  if(_d==INVALID_DATE)
+    throw elf_error(ErrorCode::invalid_argument, "date::to_days: not initialized");
+  return days_from_date(_d);
+}
 
-  if((days < 1) || (days > enddays))
-    return false;
+Date
+Date::add_days(int32_t n) const {
+  return from_days(to_days() + n);
+}
 
-  return true;
+int32_t
+Date::weekday() const {
+  // 1970-01-01 was a Thursday
+  const days_t days = to_days();
+  return ((days + 4) % 7 + 7) % 7;
 }
 
-Date
-elf::find_date_from_file(const string& fname, date_t user_date) {
-  if(user_date>0)
-    return Date(user_date);
+int32_t
+Date::day_of_year() const {
+  return to_days() - days_from_civil(y(), 1, 1) + 1;
+}
+
+days_t
+elf::operator-(const Date& d1, const Date& d2) {
+  return d1.to_days() - d2.to_days();
+}
 
-  std::regex fmt(".*(\\d{8}).*");
-  std::smatch match;
+namespace {
+  template <typename Kernel>
+  size_t
+  convert_date_words(const date_t* dates, size_t n, days_t* days, uint64_t* bad, Kernel kernel) {
+    size_t n_bad = 0;
+    for(size_t w = 0; w < n; w += 64) {
+      const size_t end = std::min(n, w + 64);
+      uint64_t word = kernel(dates, w, end, days);
+      bad[w / 64] = word;
+      n_bad += __builtin_popcountll(word);
+    }
+    return n_bad;
+  }
 
-  if(!std::regex_match(fname, match, fmt))
-    throw elf_error("find_date_from_file: unparseable pattern="+fname);
-  auto s_ymd = std::string(match[1]);
-  if(s_ymd.size() != Date::required_len)
-    throw elf_error("find_date_from_file: invalid pattern="+fname);
+  inline uint64_t
+  days_from_dates_scalar(const date_t* dates, size_t begin, size_t end, days_t* days) {
+    uint64_t word = 0;
+    for(size_t i = begin; i < end; ++i) {
+      const bool valid = validate_date(dates[i]);
+      days[i] = valid ? days_from_date(dates[i]) : 0;
+      word |= uint64_t(!valid) << (i - begin);
+    }
+    return word;
+  }
 
-  return Date(s_ymd);
+#if defined(__x86_64__)
+  // Four dates per step in double lanes. Every intermediate is an integer
+  // far below 2^53, so (x + 0.5) / d sits at least 0.5/d away from an
+  // integer and flooring its product with the reciprocal is exact.
+  __attribute__((target("avx2"))) inline __m256d
+  floor_div(__m256d x, double d) {
+    return _mm256_floor_pd(_mm256_mul_pd(_mm256_add_pd(x, _mm256_set1_pd(0.5)), _mm256_set1_pd(1 / d)));
+  }
+
+  __attribute__((target("avx2"))) inline uint64_t
+  days_from_dates_avx2(const date_t* dates, size_t begin, size_t end, days_t* days) {
+    alignas(16) static const int32_t month_days[16] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31, 0, 0, 0 };
+    uint64_t word = 0;
+    size_t i = begin;
+    for(; i + 4 <= end; i += 4) {
+      const __m128i date = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dates + i));
+      const __m256d dt = _mm256_cvtepi32_pd(date);
+      const __m256d y = floor_div(dt, 10000);
+      const __m256d md = _mm256_sub_pd(dt, _mm256_mul_pd(y, _mm256_set1_pd(10000)));
+      const __m256d m = floor_div(md, 100);
+      const __m256d d = _mm256_sub_pd(md, _mm256_mul_pd(m, _mm256_set1_pd(100)));
+
+      // range and month checks, then the day against the month length
+      const __m128i in_range = _mm_andnot_si128(
+        _mm_or_si128(_mm_cmplt_epi32(date, _mm_set1_epi32(19700101)), _mm_cmpgt_epi32(date, _mm_set1_epi32(99981231))),
+        _mm_set1_epi32(-1));
+      const __m128i mi = _mm_min_epi32(_mm_max_epi32(_mm256_cvtpd_epi32(m), _mm_setzero_si128()), _mm_set1_epi32(13));
+      const __m256d y4 = _mm256_sub_pd(y, _mm256_mul_pd(floor_div(y, 4), _mm256_set1_pd(4)));
+      const __m256d y100 = _mm256_sub_pd(y, _mm256_mul_pd(floor_div(y, 100), _mm256_set1_pd(100)));
+      const __m256d y400 = _mm256_sub_pd(y, _mm256_mul_pd(floor_div(y, 400), _mm256_set1_pd(400)));
+      const __m256d zero = _mm256_setzero_pd();
+      const __m256d leap = _mm256_and_pd(_mm256_cmp_pd(y4, zero, _CMP_EQ_OQ),
+                                         _mm256_or_pd(_mm256_cmp_pd(y100, zero, _CMP_NEQ_OQ), _mm256_cmp_pd(y400, zero, _CMP_EQ_OQ)));
+      const __m256d feb = _mm256_cmp_pd(m, _mm256_set1_pd(2), _CMP_EQ_OQ);
+      const __m256d enddays = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_i32gather_epi32(month_days, mi, 4)),
+                                            _mm256_and_pd(_mm256_and_pd(leap, feb), _mm256_set1_pd(1)));
+      const __m256d day_ok = _mm256_and_pd(_mm256_cmp_pd(d, _mm256_set1_pd(1), _CMP_GE_OQ), _mm256_cmp_pd(d, enddays, _CMP_LE_OQ));
+      const int valid = _mm256_movemask_pd(day_ok) & _mm_movemask_ps(_mm_castsi128_ps(in_range));
+
+      // days_from_civil with the year starting in March
+      const __m256d jan_feb = _mm256_cmp_pd(m, _mm256_set1_pd(2), _CMP_LE_OQ);
+      const __m256d ya = _mm256_sub_pd(y, _mm256_and_pd(jan_feb, _mm256_set1_pd(1)));
+      const __m256d mp = _mm256_add_pd(m, _mm256_blendv_pd(_mm256_set1_pd(-3), _mm256_set1_pd(9), jan_feb));
+      const __m256d doy = _mm256_add_pd(floor_div(_mm256_add_pd(_mm256_mul_pd(mp, _mm256_set1_pd(153)), _mm256_set1_pd(2)), 5),
+                                        _mm256_sub_pd(d, _mm256_set1_pd(1)));
+      __m256d n = _mm256_mul_pd(ya, _mm256_set1_pd(365));
+      n = _mm256_add_pd(n, floor_div(ya, 4));
+      n = _mm256_sub_pd(n, floor_div(ya, 100));
+      n = _mm256_add_pd(n, floor_div(ya, 400));
+      n = _mm256_add_pd(n, _mm256_sub_pd(doy, _mm256_set1_pd(719468)));
+
+      const __m128i valid_mask = _mm_cmpeq_epi32(
+        _mm_and_si128(_mm_set1_epi32(valid), _mm_setr_epi32(1, 2, 4, 8)), _mm_setr_epi32(1, 2, 4, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(days + i), _mm_and_si128(_mm256_cvtpd_epi32(n), valid_mask));
+      word |= uint64_t(~valid & 0xf) << (i - begin);
+    }
+    // a full 64-row word leaves no tail, and shifting by 64 is undefined
+    if(i == end)
+      return word;
+    return word | days_from_dates_scalar(dates, i, end, days) << (i - begin);
+  }
+
+  __attribute__((target("avx2"))) void
+  dates_from_days_avx2(const days_t* days, size_t n, date_t* dates) {
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+      const __m256d z = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(days + i))),
+                                      _mm256_set1_pd(719468));
+      const __m256d era = floor_div(z, 146097);
+      const __m256d doe = _mm256_sub_pd(z, _mm256_mul_pd(era, _mm256_set1_pd(146097)));
+      __m256d t = _mm256_sub_pd(doe, floor_div(doe, 1460));
+      t = _mm256_add_pd(t, floor_div(doe, 36524));
+      t = _mm256_sub_pd(t, floor_div(doe, 146096));
+      const __m256d yoe = floor_div(t, 365);
+      __m256d doy = _mm256_sub_pd(doe, _mm256_mul_pd(yoe, _mm256_set1_pd(365)));
+      doy = _mm256_sub_pd(doy, floor_div(yoe, 4));
+      doy = _mm256_add_pd(doy, floor_div(yoe, 100));
+      const __m256d mp = floor_div(_mm256_add_pd(_mm256_mul_pd(doy, _mm256_set1_pd(5)), _mm256_set1_pd(2)), 153);
+      const __m256d d = _mm256_add_pd(_mm256_sub_pd(doy, floor_div(_mm256_add_pd(_mm256_mul_pd(mp, _mm256_set1_pd(153)), _mm256_set1_pd(2)), 5)),
+                                      _mm256_set1_pd(1));
+      const __m256d late = _mm256_cmp_pd(mp, _mm256_set1_pd(10), _CMP_GE_OQ);
+      const __m256d m = _mm256_add_pd(mp, _mm256_blendv_pd(_mm256_set1_pd(3), _mm256_set1_pd(-9), late));
+      const __m256d y = _mm256_add_pd(_mm256_add_pd(yoe, _mm256_mul_pd(era, _mm256_set1_pd(400))), _mm256_and_pd(late, _mm256_set1_pd(1)));
+      const __m256d date = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(y, _mm256_set1_pd(10000)), _mm256_mul_pd(m, _mm256_set1_pd(100))), d);
+      // day numbers whose date doesn't fit a date_t, as in date_from_days
+      const __m256d in_range = _mm256_and_pd(_mm256_cmp_pd(z, _mm256_set1_pd(min_date_days + 719468.0), _CMP_GE_OQ),
+                                             _mm256_cmp_pd(z, _mm256_set1_pd(max_date_days + 719468.0), _CMP_LE_OQ));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dates + i),
+                       _mm256_cvtpd_epi32(_mm256_blendv_pd(_mm256_set1_pd(INVALID_DATE), date, in_range)));
+    }
+    for(; i < n; ++i)
+      dates[i] = date_from_days(days[i]);
+  }
+#endif
 }
 
-Timestamp::Timestamp(const string& s_ts) {
-  _ts = convert(s_ts);
+size_t
+elf::days_from_dates(const date_t* dates, size_t n, days_t* days, uint64_t* bad) {
+#if defined(__x86_64__)
+  if(simd_level() == SimdLevel::avx2)
+    return convert_date_words(dates, n, days, bad, days_from_dates_avx2);
+#endif
+  return convert_date_words(dates, n, days, bad, days_from_dates_scalar);
 }
 
 void
-Timestamp::from_string(const string& s_ts) {
-  _ts = convert(s_ts);
+elf::dates_from_days(const days_t* days, size_t n, date_t* dates) {
+#if defined(__x86_64__)
+  if(simd_level() == SimdLevel::avx2)
+    return dates_from_days_avx2(days, n, dates);
+#endif
+  for(size_t i = 0; i < n; ++i)
+    dates[i] = date_from_days(days[i]);
 }
 
-void
-Timestamp::from_go_ts(const string& s_ts) {
-  // 20220203-104528.093817
-  bool is_valid = s_ts.size()==22 && s_ts[8]=='-' && s_ts[15]=='.';
-  if(!is_valid)
-    throw elf_error("timestamp::from_go_ts: unhandled format");
-  int64_t h, m, s, u;
-  const char* p = s_ts.c_str();
-  substring_atoi(p+9, 2, h);
-  substring_atoi(p+11, 2, m);
-  substring_atoi(p+13, 2, s);
-  substring_atoi(p+16, 6, u);
-  _ts = h*TimeConstants::ticks_per_hour + m*TimeConstants::ticks_per_minute + s*TimeConstants::ticks_per_second + u*TimeConstants::ticks_per_usec;
+date_t
+elf::find_date_in_name(string_view name) {
+  // walk digit runs from the end; the last run of exactly 8 digits wins
+  const char* begin = name.data();
+  const char* p = begin + name.size();
+  while(p != begin) {
+    if(!is_digit(p[-1])) {
+      --p;
+      continue;
+    }
+    const char* end = p;
+    while(p != begin && is_digit(p[-1]))
+      --p;
+    if(end - p == Date::required_len) {
+      uint32_t date;
+      substring_atoi<8>(p, date);
+      return date;
+    }
+  }
+  return INVALID_DATE;
 }
 
-timestamp_t
-Timestamp::convert(const string& s_ts) const {
-  std::regex fmt_hmsu("(\\d{2}):(\\d{2}):(\\d{2})(\\.(\\d{3,6}))?");
-  std::regex fmt_dhmsu("(\\d)D(\\d{2}):(\\d{2}):(\\d{2})(\\.(\\d{6}))?");
-  std::smatch match;
+Date
+elf::find_date_from_file(const string& fname, date_t user_date) {
+  const ParseResult<Date> r = try_find_date_from_file(fname, user_date);
+  switch(r.status) {
+  case ParseStatus::ok:
+    return r.value;
+  case ParseStatus::out_of_bounds:
+    throw elf_error(ErrorCode::out_of_bounds, "date::from_string: invalid date", "input={}", user_date > 0 ? user_date : find_date_in_name(fname));
+  default:
+    throw elf_error(ErrorCode::bad_format, "find_date_from_file: unparseable", "pattern={}", fname);
+  }
+}
 
-  timestamp_t ts;
-  try {
-    if(std::regex_match(s_ts, match, fmt_dhmsu)) {
-      timestamp_t d = boost::lexical_cast<timestamp_t>(match[1]);
-      timestamp_t h = boost::lexical_cast<timestamp_t>(match[2]);
-      timestamp_t m = boost::lexical_cast<timestamp_t>(match[3]);
-      timestamp_t s = boost::lexical_cast<timestamp_t>(match[4]);
-      timestamp_t u = 0;
-
-      if(match[5].length())
-        u = boost::lexical_cast<timestamp_t>(string(match[5]).substr(1));
-
-      if(h > TimeConstants::max_hour ||
-         m > TimeConstants::max_minute ||
-         s > TimeConstants::max_second ||
-         u > TimeConstants::max_usec)
-        throw elf_error("timestamp_convert: out of bounds");
-
-      ts = d * TimeConstants::ticks_per_day + h * TimeConstants::ticks_per_hour
-        + m * TimeConstants::ticks_per_minute + s * TimeConstants::ticks_per_second
-        + u * TimeConstants::ticks_per_usec;
-
-    } else if(std::regex_match(s_ts, match, fmt_hmsu)) {
-      timestamp_t h = boost::lexical_cast<timestamp_t>(match[1]);
-      timestamp_t m = boost::lexical_cast<timestamp_t>(match[2]);
-      timestamp_t s = boost::lexical_cast<timestamp_t>(match[3]);
-      timestamp_t u = 0;
-
-      if(match[4].length())
-        u = boost::lexical_cast<timestamp_t>(string(match[4]).substr(1));
-
-      if(h > TimeConstants::max_hour ||
-         m > TimeConstants::max_minute ||
-         s > TimeConstants::max_second ||
-         u > TimeConstants::max_usec)
-        throw elf_error("timestamp_convert: out of bounds");
-
-      ts = h * TimeConstants::ticks_per_hour + m * TimeConstants::ticks_per_minute
-        + s * TimeConstants::ticks_per_second + u * TimeConstants::ticks_per_usec;
+ParseResult<Date>
+elf::try_find_date_from_file(string_view fname, date_t user_date) {
+  Date date;
+  const date_t found = user_date > 0 ? user_date : find_date_in_name(fname);
+  if(found == INVALID_DATE)
+    return { date, ParseStatus::bad_format };
+  if(!validate_date(found))
+    return { date, ParseStatus::out_of_bounds };
+  date._d = found;
+  return { date, ParseStatus::ok };
+}
+
+namespace {
+  // parse "HH:MM:SS" at p; caller guarantees 8 readable bytes
+  template <typename Res>
+  inline ParseStatus
+  scan_hms(const char* p, timestamp_t& out) {
+    // read as one 8 digit field with the colons swapped for '0': HH0MM0SS
+    const uint64_t raw = detail::load_u64(p);
+    const uint64_t v = raw ^ (uint64_t(':' ^ '0') << 16) ^ (uint64_t(':' ^ '0') << 40);
+    if(!detail::swar_is_8_digits(v) | (p[2] != ':') | (p[5] != ':'))
+      return ParseStatus::bad_format;
+
+    const uint32_t hms = detail::swar_8_digits(v);
+    const uint32_t h = hms / 1000000, m = hms / 1000 % 1000, s = hms % 1000;
+
+    if(h > TimeConstants::max_hour ||
+       m > TimeConstants::max_minute ||
+       s > TimeConstants::max_second)
+      return ParseStatus::out_of_bounds;
+
+    out = h * Res::ticks_per_hour + m * Res::ticks_per_minute + s * Res::ticks_per_second;
+    return ParseStatus::ok;
+  }
 
+  // N fractional digits at p in ticks of Res; digits below a tick must be 0.
+  // The scale is a constant per N, so Micros pays nothing for Nanos.
+  template <size_t N, typename Res>
+  inline bool
+  scan_frac_digits(const char* p, timestamp_t& out) {
+    uint32_t u;
+    const bool ok = substring_atoi<N>(p, u);
+    if constexpr(static_cast<int>(N) <= Res::frac_digits) {
+      out = u * detail::pow10_ticks(Res::frac_digits - N);
+      return ok;
     } else {
-      throw elf_error("timestamp_convert: unhandled format: " + s_ts);
+      constexpr uint32_t scale = detail::pow10_ticks(N - Res::frac_digits);
+      out = u / scale;
+      return ok & (u % scale == 0);
     }
+  }
 
-  } catch(const boost::bad_lexical_cast&) {
-    throw elf_error("timestamp_convert: unparseable format: " + s_ts);
+  // parse ".f{min_digits,9}" at p, in ticks of Res
+  template <typename Res>
+  inline ParseStatus
+  scan_frac(const char* p, size_t len, size_t min_digits, timestamp_t& out) {
+    if(p[0] != '.' || len - 1 < min_digits || len - 1 > 9)
+      return ParseStatus::bad_format;
+
+    bool ok = true;
+    switch(len - 1) {
+    case 1: ok = scan_frac_digits<1, Res>(p + 1, out); break;
+    case 2: ok = scan_frac_digits<2, Res>(p + 1, out); break;
+    case 3: ok = scan_frac_digits<3, Res>(p + 1, out); break;
+    case 4: ok = scan_frac_digits<4, Res>(p + 1, out); break;
+    case 5: ok = scan_frac_digits<5, Res>(p + 1, out); break;
+    case 6: ok = scan_frac_digits<6, Res>(p + 1, out); break;
+    case 7: ok = scan_frac_digits<7, Res>(p + 1, out); break;
+    case 8: ok = scan_frac_digits<8, Res>(p + 1, out); break;
+    case 9: ok = scan_frac_digits<9, Res>(p + 1, out); break;
+    }
+    return ok ? ParseStatus::ok : ParseStatus::bad_format;
   }
 
-  return ts;
+  // HH:MM:SS[.fff..fffffffff] or ND HH:MM:SS[.ffffff..fffffffff]
+  template <typename Res>
+  ParseStatus
+  scan_timestamp(const char* p, size_t len, timestamp_t& out) {
+    timestamp_t days = 0;
+    size_t min_frac_digits = 3;
+    if(len >= 2 && p[1] == 'D') {
+      if(!is_digit(p[0]))
+        return ParseStatus::bad_format;
+      days = p[0] - '0';
+      p += 2;
+      len -= 2;
+      min_frac_digits = 6;
+    }
+
+    if(len < 8)
+      return ParseStatus::bad_format;
+
+    timestamp_t hms, frac = 0;
+    ParseStatus status = scan_hms<Res>(p, hms);
+    if(status != ParseStatus::ok)
+      return status;
+
+    if(len > 8) {
+      status = scan_frac<Res>(p + 8, len - 8, min_frac_digits, frac);
+      if(status != ParseStatus::ok)
+        return status;
+    }
+
+    out = days * Res::ticks_per_day + hms + frac;
+    return ParseStatus::ok;
+  }
 }
 
-string
-Timestamp::to_hms() const {
-  timestamp_t ts = _ts;
-  ts %= TimeConstants::ticks_per_day;
-  char buf[1024];
+namespace {
+  // 20220203-104528.093817 or 20220203-104528.093817123; the length picks
+  // the fraction width, then separator and digit checks are and-folded into
+  // one flag rather than branched on per character, and the field ranges
+  // are checked in a second branch
+  template <typename Res>
+  ParseStatus
+  scan_go_ts(const char* p, size_t len, date_t& date, timestamp_t& ts) {
+    timestamp_t frac;
+    bool frac_ok;
+    if(len == go_ts_len)
+      frac_ok = scan_frac_digits<6, Res>(p + 16, frac);
+    else if(len == go_ts_len + 3)
+      frac_ok = scan_frac_digits<9, Res>(p + 16, frac);
+    else
+      return ParseStatus::bad_format;
+
+    uint32_t ymd, hms;
+    const bool format_ok = (p[8] == '-') & (p[15] == '.')
+      & substring_atoi<8>(p, ymd) & substring_atoi<6>(p + 9, hms) & frac_ok;
+    if(!format_ok)
+      return ParseStatus::bad_format;
 
-  int h = ts / TimeConstants::ticks_per_hour;
-  ts -= h * TimeConstants::ticks_per_hour;
-  int m = ts / TimeConstants::ticks_per_minute;
-  ts -= m * TimeConstants::ticks_per_minute;
-  int s = ts / TimeConstants::ticks_per_second;
+    const uint32_t h = hms / 10000, m = hms / 100 % 100, s = hms % 100;
+    date = ymd;
+    if((h > TimeConstants::max_hour) | (m > TimeConstants::max_minute) | (s > TimeConstants::max_second) | !validate_date(date))
+      return ParseStatus::out_of_bounds;
 
-  snprintf(buf, 1024, "%02d:%02d:%02d", h, m, s);
-  return buf;
+    ts = h * Res::ticks_per_hour + m * Res::ticks_per_minute + s * Res::ticks_per_second + frac;
+    return ParseStatus::ok;
+  }
 }
 
-string
-Timestamp::to_hms_msec() const {
-  timestamp_t ts = _ts;
-  ts %= TimeConstants::ticks_per_day;
-  char buf[1024];
+template <typename Res>
+BasicTimestamp<Res>::BasicTimestamp(const string& s_ts) {
+  _ts = convert(s_ts);
+}
 
-  int h = ts / TimeConstants::ticks_per_hour;
-  ts -= h * TimeConstants::ticks_per_hour;
-  int m = ts / TimeConstants::ticks_per_minute;
-  ts -= m * TimeConstants::ticks_per_minute;
-  int s = ts / TimeConstants::ticks_per_second;
-  ts -= s * TimeConstants::ticks_per_second;
-  int msec = ts / TimeConstants::ticks_per_msec;
+template <typename Res>
+void
+BasicTimestamp<Res>::from_string(const string& s_ts) {
+  _ts = convert(s_ts);
+}
 
-  snprintf(buf, sizeof(buf), "%02d:%02d:%02d.%03d", h, m, s, msec);
-  return buf;
+template <typename Res>
+void
+BasicTimestamp<Res>::from_string(string_view s_ts) {
+  _ts = convert(s_ts);
 }
 
-string
-Timestamp::str(bool show_usec) const {
-  timestamp_t ts = _ts;
-  string s_ts;
-  int d = ts / TimeConstants::ticks_per_day;
-  char buf[1024];
+template <typename Res>
+void
+BasicTimestamp<Res>::from_go_ts(string_view s_ts) {
+  Date date;
+  from_go_ts(s_ts, date);
+}
 
-  if(d) {
-    snprintf(buf, 1024, "%dD", d);
-    s_ts = buf;
+template <typename Res>
+void
+BasicTimestamp<Res>::from_go_ts(string_view s_ts, Date& date) {
+  // date and *this are left alone unless the whole string is valid
+  date_t d;
+  timestamp_t ts;
+  switch(scan_go_ts<Res>(s_ts.data(), s_ts.size(), d, ts)) {
+  case ParseStatus::ok:
+    date._d = d;
+    _ts = ts;
+    return;
+  case ParseStatus::out_of_bounds:
+    throw elf_error(ErrorCode::out_of_bounds, "timestamp::from_go_ts: out of bounds:", "{}", s_ts);
+  default:
+    throw elf_error(ErrorCode::bad_format, "timestamp::from_go_ts: unhandled format:", "{}", s_ts);
   }
+}
 
-  ts -= d * TimeConstants::ticks_per_day;
-  int h = ts / TimeConstants::ticks_per_hour;
-  ts -= h * TimeConstants::ticks_per_hour;
-  int m = ts / TimeConstants::ticks_per_minute;
-  ts -= m * TimeConstants::ticks_per_minute;
-  int s = ts / TimeConstants::ticks_per_second;
-  ts -= s * TimeConstants::ticks_per_second;
-  int us = ts / TimeConstants::ticks_per_usec;
+timestamp_t
+elf::epoch_from_go_ts(string_view s_ts) {
+  Date date;
+  Timestamp ts;
+  ts.from_go_ts(s_ts, date);
+  return days_from_date(date) * TimeConstants::ticks_per_day + ts;
+}
 
-  if(show_usec)
-    snprintf(buf, 1024, "%02d:%02d:%02d.%06d", h, m, s, us);
-  else
-    snprintf(buf, 1024, "%02d:%02d:%02d", h, m, s);
+ParseResult<timestamp_t>
+elf::try_epoch_from_go_ts(string_view s_ts) {
+  date_t date;
+  timestamp_t ts;
+  const ParseStatus status = scan_go_ts<Micros>(s_ts.data(), s_ts.size(), date, ts);
+  if(status != ParseStatus::ok)
+    return { 0, status };
+  return { days_from_date(date) * TimeConstants::ticks_per_day + ts, status };
+}
 
-  s_ts += buf;
-  return s_ts;
+size_t
+elf::convert_go_timestamps(const char* buf, size_t stride, size_t n, timestamp_t* out, uint64_t* bad) {
+  size_t n_bad = 0;
+  for(size_t w = 0; w < n; w += 64) {
+    const size_t end = std::min(n, w + 64);
+    uint64_t word = 0;
+    for(size_t i = w; i < end; ++i) {
+      date_t date;
+      timestamp_t ts;
+      const bool ok = scan_go_ts<Micros>(buf + i * stride, go_ts_len, date, ts) == ParseStatus::ok;
+      out[i] = ok ? days_from_date(date) * TimeConstants::ticks_per_day + ts : 0;
+      word |= uint64_t(!ok) << (i - w);
+    }
+    bad[w / 64] = word;
+    n_bad += __builtin_popcountll(word);
+  }
+  return n_bad;
 }
 
-Timedelta::Timedelta(const string& s_td) { _td = convert(s_td); }
+template <typename Res>
+timestamp_t
+BasicTimestamp<Res>::convert(const string& s_ts) const {
+  return convert(s_ts.data(), s_ts.size());
+}
 
-string
-Timedelta::str() const {
-  timedelta_t td = _td;
-  timestamp_t ts = ::llabs(td);
-  char buf[1024];
+template <typename Res>
+timestamp_t
+BasicTimestamp<Res>::convert(string_view s_ts) const {
+  return convert(s_ts.data(), s_ts.size());
+}
 
-  // handle small quantities
-  string s_td = _td < 0 ? "-" : "";
-  if(ts < TimeConstants::ticks_per_msec) {
-    snprintf(buf, 1024, "%dusec", (int)ts);
-    return s_td + buf;
+template <typename Res>
+timestamp_t
+BasicTimestamp<Res>::convert(const char* buf, size_t len) const {
+  timestamp_t ts;
+  switch(scan_timestamp<Res>(buf, len, ts)) {
+  case ParseStatus::ok:
+    return ts;
+  case ParseStatus::out_of_bounds:
+    throw elf_error(ErrorCode::out_of_bounds, "timestamp_convert: out of bounds");
+  default:
+    throw elf_error(ErrorCode::bad_format, "timestamp_convert: unhandled format:", "{}", string_view(buf, len));
+  }
+}
 
-  } else if(ts < TimeConstants::ticks_per_second) {
-    snprintf(buf, 1024, "%dmsec", (int)(ts / TimeConstants::ticks_per_msec));
-    return s_td + buf;
+template <typename Res>
+ParseResult<BasicTimestamp<Res>>
+BasicTimestamp<Res>::try_parse(string_view s_ts) {
+  timestamp_t ts = 0;
+  const ParseStatus status = scan_timestamp<Res>(s_ts.data(), s_ts.size(), ts);
+  return { BasicTimestamp(status == ParseStatus::ok ? ts : 0), status };
+}
 
-  } else if(ts < TimeConstants::ticks_per_minute) {
-    snprintf(buf, 1024, "%dsec", (int)(ts / TimeConstants::ticks_per_second));
-    return s_td + buf;
+namespace {
+  // HH:MM:SS.ffffff, the only 15 byte form accepted by scan_timestamp
+  constexpr size_t simd_ts_len = 15;
+
+  struct fixed_rows {
+    const char* buf;
+    size_t width;
+    size_t stride;
+    const char* limit;
+
+    const char* data(size_t i) const { return buf + i * stride; }
+    size_t size(size_t) const { return width; }
+    bool simd_ok(size_t i) const { return width == simd_ts_len && data(i) + 16 <= limit; }
+  };
+
+  struct indexed_rows {
+    const char* buf;
+    const uint32_t* offsets;
+    const char* limit;
+
+    const char* data(size_t i) const { return buf + offsets[i]; }
+    size_t size(size_t i) const { return offsets[i + 1] - offsets[i]; }
+    bool simd_ok(size_t i) const { return size(i) == simd_ts_len && data(i) + 16 <= limit; }
+  };
+
+  // returns 1 if row i is bad
+  template <typename Rows>
+  inline uint64_t
+  convert_row(const Rows& rows, size_t i, timestamp_t* out) {
+    if(scan_timestamp<Micros>(rows.data(i), rows.size(i), out[i]) == ParseStatus::ok)
+      return 0;
+    out[i] = 0;
+    return 1;
   }
 
-  // generic case
-  int h = ts / TimeConstants::ticks_per_hour;
-  ts -= h * TimeConstants::ticks_per_hour;
-  int m = ts / TimeConstants::ticks_per_minute;
-  ts -= m * TimeConstants::ticks_per_minute;
-  int s = ts / TimeConstants::ticks_per_second;
-  ts -= s * TimeConstants::ticks_per_second;
-  int us = ts / TimeConstants::ticks_per_usec;
+  template <typename Rows>
+  size_t
+  convert_rows_scalar(const Rows& rows, size_t n, timestamp_t* out, uint64_t* bad) {
+    size_t n_bad = 0;
+    for(size_t w = 0; w < n; w += 64) {
+      const size_t end = std::min(n, w + 64);
+      uint64_t word = 0;
+      for(size_t i = w; i < end; ++i)
+        word |= convert_row(rows, i, out) << (i - w);
+      bad[w / 64] = word;
+      n_bad += __builtin_popcountll(word);
+    }
+    return n_bad;
+  }
 
-  if(us)
-    snprintf(buf, 1024, "%02d:%02d:%02d.%06d", h, m, s, us);
-  else
-    snprintf(buf, 1024, "%02d:%02d:%02d", h, m, s);
+#if defined(__x86_64__)
+  // Per 16 byte lane: validate digits and separators, gather the digits as
+  // [H M f01 f23 f45 0 S 0] 16-bit fields, range check H/M/S, then fold to
+  // 32-bit [seconds, usec] with two multiply-adds.
+#define ELF_TS_SIMD_CONSTANTS                                           \
+  0, 1, 3, 4, 9, 10, 11, 12, 13, 14, -1, -1, 6, 7, -1, -1
+
+  __attribute__((target("sse4.2"))) inline uint64_t
+  convert_one_sse42(const char* p, timestamp_t* out) {
+    const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i sep = _mm_setr_epi8(0, 0, ':', 0, 0, ':', 0, 0, '.', 0, 0, 0, 0, 0, 0, 0);
+    const __m128i sep_mask = _mm_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i digits = _mm_sub_epi8(raw, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    const __m128i ok = _mm_blendv_epi8(is_digit, _mm_cmpeq_epi8(raw, sep), sep_mask);
+
+    const __m128i packed = _mm_shuffle_epi8(digits, _mm_setr_epi8(ELF_TS_SIMD_CONSTANTS));
+    const __m128i fields = _mm_maddubs_epi16(packed, _mm_set1_epi16(0x010a));
+    const __m128i over = _mm_cmpgt_epi16(fields, _mm_setr_epi16(TimeConstants::max_hour, TimeConstants::max_minute,
+                                                                INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX,
+                                                                TimeConstants::max_second, INT16_MAX));
+    __m128i v = _mm_madd_epi16(fields, _mm_setr_epi16(60, 1, 100, 1, 1, 0, 1, 0));
+    v = _mm_mullo_epi32(v, _mm_setr_epi32(60, 100, 1, 1));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+
+    const bool is_bad = (_mm_movemask_epi8(ok) | 0x8000) != 0xffff || _mm_movemask_epi8(over);
+    const uint64_t su = _mm_cvtsi128_si64(v);
+    *out = is_bad ? 0 : (su & 0xffffffff) * TimeConstants::ticks_per_second + (su >> 32) * TimeConstants::ticks_per_usec;
+    return is_bad;
+  }
+
+  // two rows per 256-bit register, one per 128-bit lane
+  __attribute__((target("avx2"))) inline uint64_t
+  convert_two_avx2(const char* p0, const char* p1, timestamp_t* out) {
+    const __m256i raw = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0))),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)), 1);
+    const __m256i sep = _mm256_setr_epi8(0, 0, ':', 0, 0, ':', 0, 0, '.', 0, 0, 0, 0, 0, 0, 0,
+                                         0, 0, ':', 0, 0, ':', 0, 0, '.', 0, 0, 0, 0, 0, 0, 0);
+    const __m256i sep_mask = _mm256_setr_epi8(0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 0, -1, 0, 0, -1, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i digits = _mm256_sub_epi8(raw, _mm256_set1_epi8('0'));
+    const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+    const __m256i ok = _mm256_blendv_epi8(is_digit, _mm256_cmpeq_epi8(raw, sep), sep_mask);
+
+    const __m256i packed = _mm256_shuffle_epi8(digits, _mm256_setr_epi8(ELF_TS_SIMD_CONSTANTS, ELF_TS_SIMD_CONSTANTS));
+    const __m256i fields = _mm256_maddubs_epi16(packed, _mm256_set1_epi16(0x010a));
+    const __m256i over = _mm256_cmpgt_epi16(fields, _mm256_setr_epi16(
+      TimeConstants::max_hour, TimeConstants::max_minute, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, TimeConstants::max_second, INT16_MAX,
+      TimeConstants::max_hour, TimeConstants::max_minute, INT16_MAX, INT16_MAX, INT16_MAX, INT16_MAX, TimeConstants::max_second, INT16_MAX));
+    __m256i v = _mm256_madd_epi16(fields, _mm256_setr_epi16(60, 1, 100, 1, 1, 0, 1, 0, 60, 1, 100, 1, 1, 0, 1, 0));
+    v = _mm256_mullo_epi32(v, _mm256_setr_epi32(60, 100, 1, 1, 60, 100, 1, 1));
+    v = _mm256_add_epi32(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+
+    const uint32_t not_ok = ~(static_cast<uint32_t>(_mm256_movemask_epi8(ok)) | 0x80008000);
+    const uint32_t bad_bytes = not_ok | static_cast<uint32_t>(_mm256_movemask_epi8(over));
+    const uint64_t bad0 = (bad_bytes & 0xffff) != 0;
+    const uint64_t bad1 = (bad_bytes >> 16) != 0;
+    const uint64_t su0 = _mm256_extract_epi64(v, 0);
+    const uint64_t su1 = _mm256_extract_epi64(v, 2);
+    out[0] = bad0 ? 0 : (su0 & 0xffffffff) * TimeConstants::ticks_per_second + (su0 >> 32) * TimeConstants::ticks_per_usec;
+    out[1] = bad1 ? 0 : (su1 & 0xffffffff) * TimeConstants::ticks_per_second + (su1 >> 32) * TimeConstants::ticks_per_usec;
+    return bad0 | (bad1 << 1);
+  }
+#undef ELF_TS_SIMD_CONSTANTS
+
+  template <typename Rows>
+  __attribute__((target("sse4.2"))) size_t
+  convert_rows_sse42(const Rows& rows, size_t n, timestamp_t* out, uint64_t* bad) {
+    size_t n_bad = 0;
+    for(size_t w = 0; w < n; w += 64) {
+      const size_t end = std::min(n, w + 64);
+      uint64_t word = 0;
+      for(size_t i = w; i < end; ++i) {
+        const uint64_t is_bad = rows.simd_ok(i) ? convert_one_sse42(rows.data(i), out + i) : convert_row(rows, i, out);
+        word |= is_bad << (i - w);
+      }
+      bad[w / 64] = word;
+      n_bad += __builtin_popcountll(word);
+    }
+    return n_bad;
+  }
 
-  s_td += buf;
-  return s_td;
+  // 16 rows per iteration as 8 register pairs; odd tails and rows that are
+  // not 15 bytes long, or too close to the end of the buffer for a 16 byte
+  // load, go through the scalar scanner
+  template <typename Rows>
+  __attribute__((target("avx2"))) size_t
+  convert_rows_avx2(const Rows& rows, size_t n, timestamp_t* out, uint64_t* bad) {
+    size_t n_bad = 0;
+    for(size_t w = 0; w < n; w += 64) {
+      const size_t end = std::min(n, w + 64);
+      uint64_t word = 0;
+      size_t i = w;
+      for(; i + 16 <= end; i += 16) {
+        uint64_t block = 0;
+#pragma GCC unroll 8
+        for(size_t j = 0; j < 16; j += 2) {
+          const size_t k = i + j;
+          uint64_t pair;
+          if(rows.simd_ok(k) && rows.simd_ok(k + 1))
+            pair = convert_two_avx2(rows.data(k), rows.data(k + 1), out + k);
+          else
+            pair = convert_row(rows, k, out) | (convert_row(rows, k + 1, out) << 1);
+          block |= pair << j;
+        }
+        word |= block << (i - w);
+      }
+      for(; i < end; ++i)
+        word |= convert_row(rows, i, out) << (i - w);
+      bad[w / 64] = word;
+      n_bad += __builtin_popcountll(word);
+    }
+    return n_bad;
+  }
+#endif
+
+  template <typename Rows>
+  size_t
+  convert_rows(const Rows& rows, size_t n, timestamp_t* out, uint64_t* bad) {
+    switch(simd_level()) {
+#if defined(__x86_64__)
+    case SimdLevel::avx2:
+      return convert_rows_avx2(rows, n, out, bad);
+    case SimdLevel::sse42:
+      return convert_rows_sse42(rows, n, out, bad);
+#endif
+    default:
+      return convert_rows_scalar(rows, n, out, bad);
+    }
+  }
+}
+
+size_t
+elf::convert_timestamps(const char* buf, size_t width, size_t stride, size_t n,
+                        timestamp_t* out, uint64_t* bad) {
+  if(!n)
+    return 0;
+  const fixed_rows rows{buf, width, stride, buf + (n - 1) * stride + width};
+  return convert_rows(rows, n, out, bad);
+}
+
+size_t
+elf::convert_timestamps(const char* buf, const uint32_t* offsets, size_t n,
+                        timestamp_t* out, uint64_t* bad) {
+  if(!n)
+    return 0;
+  const indexed_rows rows{buf, offsets, buf + offsets[n]};
+  return convert_rows(rows, n, out, bad);
 }
 
+template <typename Res>
 string
-Timedelta::to_hms() const {
-  timestamp_t ts = ::llabs(_td);
-  char buf[1024];
+BasicTimestamp<Res>::to_hms() const {
+  char buf[max_str_len];
+  return string(buf, format_hms_to(buf));
+}
+
+template <typename Res>
+string
+BasicTimestamp<Res>::to_hms_msec() const {
+  char buf[max_str_len];
+  return string(buf, format_hms_msec_to(buf));
+}
 
-  int h = ts / TimeConstants::ticks_per_hour;
-  ts -= h * TimeConstants::ticks_per_hour;
-  int m = ts / TimeConstants::ticks_per_minute;
-  ts -= m * TimeConstants::ticks_per_minute;
-  int s = ts / TimeConstants::ticks_per_second;
+template <typename Res>
+string
+BasicTimestamp<Res>::str(bool show_frac) const {
+  char buf[max_str_len];
+  return string(buf, format_to(buf, show_frac));
+}
 
-  snprintf(buf, 1024, "%02d:%02d:%02d", h, m, s);
-  return buf;
+template <typename Res>
+size_t
+BasicTimestamp<Res>::format_hms_to(char* buf) const {
+  return write_hms<Res>(buf, _ts % Res::ticks_per_day, 0) - buf;
 }
 
-timedelta_t
-Timedelta::convert(const string& us_td) {
-  std::regex fmt_usec("(\\d+)usec");
-  std::regex fmt_msec("(\\d+)msec");
-  std::regex fmt_sec("(\\d+)sec");
-  std::regex fmt_min("(\\d+)min");
-  std::regex fmt_hour("(\\d+)hour");
-  std::regex fmt_hmsu("(\\d{2}):(\\d{2}):(\\d{2})(\\.(\\d{6}))?");
-
-  if(!us_td.size())
-    throw elf_error("timedelta_convert: invalid input");
-
-  string s_td = us_td;
-  int sign = 1;
-  timedelta_t td = 0;
-  std::smatch match;
+template <typename Res>
+size_t
+BasicTimestamp<Res>::format_hms_msec_to(char* buf) const {
+  return write_hms<Res>(buf, _ts % Res::ticks_per_day, 3) - buf;
+}
 
-  if(s_td[0] == '-') {
-    s_td = s_td.substr(1);
-    sign = -1;
+template <typename Res>
+size_t
+BasicTimestamp<Res>::format_to(char* buf, bool show_frac) const {
+  char* p = buf;
+  const timestamp_t d = _ts / Res::ticks_per_day;
+  if(d) {
+    p = write_uint(p, d);
+    *p++ = 'D';
   }
+  return write_hms<Res>(p, _ts - d * Res::ticks_per_day, show_frac ? Res::frac_digits : 0) - buf;
+}
 
-  try {
-    if(std::regex_match(s_td, match, fmt_usec)) {
-      td = sign * TimeConstants::ticks_per_usec * boost::lexical_cast<timedelta_t>(match[1]);
-
-    } else if(std::regex_match(s_td, match, fmt_msec)) {
-      td = sign * TimeConstants::ticks_per_msec * boost::lexical_cast<timedelta_t>(match[1]);
+size_t
+elf::format_timestamps(const timestamp_t* ts, size_t n, char* buf, char delim, bool show_usec) {
+  char* p = buf;
+  for(size_t i = 0; i < n; ++i) {
+    p += Timestamp(ts[i]).format_to(p, show_usec);
+    *p++ = delim;
+  }
+  return p - buf;
+}
 
-    } else if(std::regex_match(s_td, match, fmt_sec)) {
-      td = sign * TimeConstants::ticks_per_second * boost::lexical_cast<timedelta_t>(match[1]);
+template <typename Res>
+BasicTimedelta<Res>::BasicTimedelta(const string& s_td) { _td = convert(s_td); }
 
-    } else if(std::regex_match(s_td, match, fmt_min)) {
-      td = sign * TimeConstants::ticks_per_minute * boost::lexical_cast<timedelta_t>(match[1]);
+template <typename Res>
+string
+BasicTimedelta<Res>::str() const {
+  char buf[max_str_len];
+  return string(buf, format_to(buf));
+}
 
-    } else if(std::regex_match(s_td, match, fmt_hour)) {
-      td = sign * TimeConstants::ticks_per_hour * boost::lexical_cast<timedelta_t>(match[1]);
+template <typename Res>
+string
+BasicTimedelta<Res>::to_hms() const {
+  char buf[max_str_len];
+  return string(buf, format_hms_to(buf));
+}
 
-    } else if(std::regex_match(s_td, match, fmt_hmsu)) {
-      timestamp_t h = boost::lexical_cast<timestamp_t>(match[1]);
-      timestamp_t m = boost::lexical_cast<timestamp_t>(match[2]);
-      timestamp_t s = boost::lexical_cast<timestamp_t>(match[3]);
-      timestamp_t u = 0;
+template <typename Res>
+size_t
+BasicTimedelta<Res>::format_to(char* buf) const {
+  timestamp_t ts = ::llabs(_td);
+  char* p = buf;
+  if(_td < 0)
+    *p++ = '-';
 
-      if(match[4].length())
-        u = boost::lexical_cast<timestamp_t>(string(match[4]).substr(1));
+  // handle small quantities
+  constexpr timestamp_t ticks_per_usec = Res::ticks_per_second / 1000000;
+  constexpr timestamp_t ticks_per_msec = Res::ticks_per_second / 1000;
+  if constexpr(ticks_per_usec > 1) {
+    if(ts < ticks_per_usec) {
+      p = write_uint(p, ts);
+      memcpy(p, "nsec", 4);
+      return p + 4 - buf;
+    }
+  }
+  if(ts < ticks_per_msec) {
+    p = write_uint(p, ts / ticks_per_usec);
+    memcpy(p, "usec", 4);
+    return p + 4 - buf;
+
+  } else if(ts < Res::ticks_per_second) {
+    p = write_uint(p, ts / ticks_per_msec);
+    memcpy(p, "msec", 4);
+    return p + 4 - buf;
+
+  } else if(ts < Res::ticks_per_minute) {
+    p = write_uint(p, ts / Res::ticks_per_second);
+    memcpy(p, "sec", 3);
+    return p + 3 - buf;
+  }
 
-      if(h > TimeConstants::max_hour ||
-         m > TimeConstants::max_minute ||
-         s > TimeConstants::max_second ||
-         u > TimeConstants::max_usec)
-        throw elf_error("timedelta_convert: out of bounds");
+  // generic case
+  const bool has_frac = ts % Res::ticks_per_second;
+  return write_hms<Res>(p, ts, has_frac ? Res::frac_digits : 0) - buf;
+}
 
-      td = sign
-        * (h * TimeConstants::ticks_per_hour + m * TimeConstants::ticks_per_minute
-           + s * TimeConstants::ticks_per_second + u * TimeConstants::ticks_per_usec);
+template <typename Res>
+size_t
+BasicTimedelta<Res>::format_hms_to(char* buf) const {
+  return write_hms<Res>(buf, ::llabs(_td), 0) - buf;
+}
 
+namespace {
+  // [-]HH:MM:SS[.fff..fffffffff] or [-]<unit terms>
+  template <typename Res>
+  ParseStatus
+  scan_timedelta(const char* p, size_t len, timedelta_t& out) {
+    const bool negative = len && *p == '-';
+    if(negative) {
+      ++p;
+      --len;
+    }
+    if(!len)
+      return ParseStatus::bad_format;
+
+    timestamp_t td = 0;
+    ParseStatus status;
+    if(len >= 8 && p[2] == ':') {
+      status = scan_hms<Res>(p, td);
+      timestamp_t frac = 0;
+      if(status == ParseStatus::ok && len > 8)
+        status = scan_frac<Res>(p + 8, len - 8, 3, frac);
+      td += frac;
     } else {
-      throw elf_error("timedelta_convert: unhandled format" + us_td);
+      status = detail::scan_timedelta_units<Res>(p, p + len, td);
     }
 
-  } catch(const boost::bad_lexical_cast&) {
-    throw elf_error("timedelta_convert: unparseable format" + us_td);
+    if(status == ParseStatus::ok)
+      out = negative ? -static_cast<timedelta_t>(td) : static_cast<timedelta_t>(td);
+    return status;
   }
+}
 
-  return td;
+template <typename Res>
+timedelta_t
+BasicTimedelta<Res>::convert(const string& s_td) {
+  return convert(s_td.data(), s_td.size());
 }
 
-Timedelta
-elf::operator-(const Timestamp& ts1, const Timestamp& ts2) {
-  Timedelta delta;
-  delta._td = (long)ts1._ts - (long)ts2._ts;
-  return delta;
+template <typename Res>
+timedelta_t
+BasicTimedelta<Res>::convert(string_view s_td) {
+  return convert(s_td.data(), s_td.size());
 }
 
-Timestamp
-elf::operator+(const Timestamp& ts, const Timedelta& td) {
-  return Timestamp(ts._ts + td._td);
+template <typename Res>
+timedelta_t
+BasicTimedelta<Res>::convert(const char* buf, size_t len) {
+  if(!len)
+    throw elf_error(ErrorCode::bad_format, "timedelta_convert: invalid input");
+
+  timedelta_t td;
+  switch(scan_timedelta<Res>(buf, len, td)) {
+  case ParseStatus::ok:
+    return td;
+  case ParseStatus::out_of_bounds:
+    throw elf_error(ErrorCode::out_of_bounds, "timedelta_convert: out of bounds");
+  default:
+    throw elf_error(ErrorCode::bad_format, "timedelta_convert: unhandled format:", "{}", string_view(buf, len));
+  }
 }
 
-timestamp_t
-get_rt_timestamp(timestamp_t midnight_offset_secs) {
-  timestamp_t ts;
+template <typename Res>
+ParseResult<BasicTimedelta<Res>>
+BasicTimedelta<Res>::try_parse(string_view s_td) {
+  timedelta_t td = 0;
+  const ParseStatus status = scan_timedelta<Res>(s_td.data(), s_td.size(), td);
+  return { BasicTimedelta(status == ParseStatus::ok ? td : 0), status };
+}
 
-  struct timeval tv;
-  ::gettimeofday(&tv, nullptr);
+namespace {
+  // one bit per bad row, as the other bulk converters; Parse returns a
+  // ParseResult and bad rows are written as 0
+  template <typename T, typename Parse>
+  size_t
+  convert_indexed(const char* buf, const uint32_t* offsets, size_t n, T* out, uint64_t* bad, Parse parse) {
+    size_t n_bad = 0;
+    for(size_t w = 0; w < n; w += 64) {
+      const size_t end = std::min(n, w + 64);
+      uint64_t word = 0;
+      for(size_t i = w; i < end; ++i) {
+        const auto r = parse(string_view(buf + offsets[i], offsets[i + 1] - offsets[i]));
+        out[i] = r.ok() ? static_cast<T>(r.value) : 0;
+        word |= uint64_t(!r.ok()) << (i - w);
+      }
+      bad[w / 64] = word;
+      n_bad += __builtin_popcountll(word);
+    }
+    return n_bad;
+  }
+}
+
+size_t
+elf::convert_dates(const char* buf, const uint32_t* offsets, size_t n, date_t* out, uint64_t* bad) {
+  return convert_indexed(buf, offsets, n, out, bad, Date::try_parse);
+}
 
-  int seconds = tv.tv_sec - midnight_offset_secs;
-  ts = (timestamp_t)seconds * TimeConstants::ticks_per_second;
-  ts += (timestamp_t)tv.tv_usec * TimeConstants::ticks_per_usec;
-  return ts;
+size_t
+elf::convert_timedeltas(const char* buf, const uint32_t* offsets, size_t n, timedelta_t* out, uint64_t* bad) {
+  return convert_indexed(buf, offsets, n, out, bad, Timedelta::try_parse);
 }
+
+template struct elf::BasicTimestamp<Micros>;
+template struct elf::BasicTimestamp<Nanos>;
+template struct elf::BasicTimedelta<Micros>;
+template struct elf::BasicTimedelta<Nanos>;
@@ -1,37 +1,180 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <ctime>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/format.h>
 
 namespace elf {
   using date_t = int32_t;
   constexpr date_t INVALID_DATE = -1;
+  using days_t = int32_t;
   using timestamp_t = uint64_t;
   using timedelta_t = int64_t;
 
+  // Outcome of the non-throwing parsers. The throwing API (from_string,
+  // convert, find_date_from_file) wraps them and reports the same status
+  // in its elf_error message.
+  enum class ParseStatus : uint8_t { ok, bad_format, out_of_bounds };
+
+  constexpr const char*
+  to_string(ParseStatus status) {
+    switch(status) {
+    case ParseStatus::ok: return "ok";
+    case ParseStatus::bad_format: return "bad format";
+    default: return "out of bounds";
+    }
+  }
+
+  // value is meaningful only when ok(); no allocation, no unwinding
+  template <typename T>
+  struct ParseResult {
+    T value;
+    ParseStatus status;
+
+    constexpr bool ok() const { return status == ParseStatus::ok; }
+    constexpr explicit operator bool() const { return ok(); }
+  };
+
+  // Proleptic Gregorian day numbers, counted from 1970-01-01. Branch-light
+  // and exact for years -214748 to 214747, the ones a YYYYMMDD date_t can
+  // hold; days_from_civil does no validation.
+  constexpr days_t
+  days_from_civil(int32_t y, int32_t m, int32_t d) {
+    y -= m <= 2;
+    const int32_t era = (y >= 0 ? y : y - 399) / 400;
+    const int32_t yoe = y - era * 400;
+    const int32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+  }
+
+  constexpr days_t
+  days_from_date(date_t date) {
+    return days_from_civil(date / 10000, date / 100 % 100, date % 100);
+  }
+
+  constexpr days_t min_date_days = days_from_civil(-214748, 1, 1);
+  constexpr days_t max_date_days = days_from_civil(214747, 12, 31);
+
+  // INVALID_DATE for day numbers outside [min_date_days, max_date_days]
+  constexpr date_t
+  date_from_days(days_t z) {
+    if(z < min_date_days || z > max_date_days)
+      return INVALID_DATE;
+    z += 719468;
+    const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int32_t doe = z - era * 146097;
+    const int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int32_t mp = (5 * doy + 2) / 153;
+    const int32_t d = doy - (153 * mp + 2) / 5 + 1;
+    const int32_t m = mp < 10 ? mp + 3 : mp - 9;
+    const int32_t y = yoe + era * 400 + (m <= 2);
+    return y * 10000 + m * 100 + d;
+  }
+
+  constexpr bool
+  is_leap_year(int32_t y) {
+    return !(y % 4) && ((y % 100) || !(y % 400));
+  }
+
+  // YYYYMMDD with a year in [1970, 9999)
+  constexpr bool
+  validate_date(date_t date) {
+    constexpr int8_t month_days[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if(date < 19700101 || date > 99981231)
+      return false;
+
+    const int32_t day = date % 100;
+    const int32_t month = date / 100 % 100;
+    if(static_cast<uint32_t>(month - 1) >= 12)
+      return false;
+
+    const int32_t enddays = month_days[month] + (month == 2 && is_leap_year(date / 10000));
+    return day >= 1 && day <= enddays;
+  }
+
   struct Date {
     Date() = default;
     Date(const std::string& s_date) { from_string(s_date); }
     Date(date_t i_date) { from_int(i_date); }
 
-    operator int() const  { return _d; }
+    // exactly 8 digits forming a valid YYYYMMDD
+    static ParseResult<Date> try_parse(std::string_view s_date);
+
+    constexpr operator int() const  { return _d; }
     void from_string(const std::string& s_date);
     void from_int(date_t i_date);
     std::string to_string() const;
+    size_t format_to(char* buf) const;
     date_t to_int() const;
     date_t y() const;
     date_t m() const;
     date_t d() const;
+    days_t to_days() const;
+    static Date from_days(days_t days) { return Date(date_from_days(days)); }
+    Date add_days(int32_t n) const;
+    // 0=Sunday .. 6=Saturday
+    int32_t weekday() const;
+    // 1 .. 366
+    int32_t day_of_year() const;
     bool is_valid() const { return _d == INVALID_DATE; }
 
     static const int required_len = 8;
+    static constexpr size_t max_str_len = 16;
     date_t _d = INVALID_DATE;
   };
 
-  bool validate_date(date_t date);
+  days_t operator-(const Date& d1, const Date& d2);
+
+  // Bulk YYYYMMDD <-> day number conversion. Invalid dates are written as 0
+  // and flagged in bad, one bit per row over (n+63)/64 words; returns the
+  // number of invalid dates. Day numbers with no date_t are written as
+  // INVALID_DATE, as by date_from_days.
+  size_t days_from_dates(const date_t* dates, size_t n, days_t* days, uint64_t* bad);
+  void dates_from_days(const days_t* days, size_t n, date_t* dates);
+
+  // last run of exactly 8 digits in name, unvalidated, or INVALID_DATE
+  date_t find_date_in_name(std::string_view name);
   Date find_date_from_file(const std::string& fname, date_t user_date=0);
+  // user_date when positive, else the date in fname; bad_format when fname
+  // has none, out_of_bounds when either is not a valid date
+  ParseResult<Date> try_find_date_from_file(std::string_view fname, date_t user_date=0);
+
+  namespace detail {
+    constexpr timestamp_t
+    pow10_ticks(int n) {
+      timestamp_t v = 1;
+      for(; n > 0; --n)
+        v *= 10;
+      return v;
+    }
+
+    template <int FracDigits>
+    struct resolution {
+      static_assert(FracDigits >= 0 && FracDigits <= 9, "resolution finer than a nanosecond");
+      static constexpr int frac_digits = FracDigits;
+      static constexpr timestamp_t ticks_per_second = pow10_ticks(FracDigits);
+      static constexpr timestamp_t ticks_per_minute = 60 * ticks_per_second;
+      static constexpr timestamp_t ticks_per_hour = 60 * ticks_per_minute;
+      static constexpr timestamp_t ticks_per_day = 24 * ticks_per_hour;
+    };
+  }
+
+  // Tick resolutions for BasicTimestamp and BasicTimedelta: a tick is
+  // 10^-frac_digits seconds. Nanos still spans 1970..2554 in a timestamp_t.
+  struct Micros : detail::resolution<6> {};
+  struct Nanos : detail::resolution<9> {};
 
+  // Micros, the resolution of Timestamp, Timedelta and the bulk functions
   namespace TimeConstants {
     constexpr timestamp_t midnight = 0;
 
@@ -47,44 +190,464 @@ namespace elf {
     constexpr timestamp_t max_second = 60;
     constexpr timestamp_t max_usec = 1e6;
   }
+  static_assert(TimeConstants::ticks_per_second == Micros::ticks_per_second);
+
+  namespace detail {
+    // ratio of two resolutions; From is finer than To when narrowing
+    template <typename From, typename To>
+    constexpr timestamp_t resolution_scale = From::frac_digits < To::frac_digits
+      ? pow10_ticks(To::frac_digits - From::frac_digits) : pow10_ticks(From::frac_digits - To::frac_digits);
+
+    template <typename From, typename To>
+    using if_widening = std::enable_if_t<(From::frac_digits < To::frac_digits), int>;
+    template <typename From, typename To>
+    using if_narrowing = std::enable_if_t<(From::frac_digits > To::frac_digits), int>;
+  }
 
-  struct Timestamp {
-    constexpr Timestamp()
+  // Time of day, or an absolute time since 1970-01-01, in ticks of Res.
+  // Converting to a finer resolution is implicit and exact; converting to a
+  // coarser one does not compile, and is spelled resolution_cast.
+  template <typename Res>
+  struct BasicTimestamp {
+    using resolution = Res;
+
+    constexpr BasicTimestamp()
       : _ts(0) {}
-    constexpr Timestamp(timestamp_t ts)
+    constexpr BasicTimestamp(timestamp_t ts)
       : _ts(ts) {}
-    Timestamp(const std::string& s_ts);
+    template <typename From, detail::if_widening<From, Res> = 0>
+    constexpr BasicTimestamp(const BasicTimestamp<From>& ts)
+      : _ts(ts._ts * detail::resolution_scale<From, Res>) {}
+    template <typename From, detail::if_narrowing<From, Res> = 0>
+    BasicTimestamp(const BasicTimestamp<From>& ts) = delete;
+    BasicTimestamp(const std::string& s_ts);
+
+    static ParseResult<BasicTimestamp> try_parse(std::string_view s_ts);
 
-    std::string str(bool show_usec=true) const;
+    // show_frac writes Res::frac_digits fractional digits
+    std::string str(bool show_frac=true) const;
     std::string to_hms() const;
     std::string to_hms_msec() const;
+    // format_to variants write without a terminating NUL into a buffer of
+    // at least max_str_len bytes and return the number of bytes written
+    size_t format_to(char* buf, bool show_frac=true) const;
+    size_t format_hms_to(char* buf) const;
+    size_t format_hms_msec_to(char* buf) const;
     void from_string(const std::string& s_ts);
-    void from_go_ts(const std::string& s_ts);
+    void from_string(std::string_view s_ts);
+    void from_string(const char* s_ts) { from_string(std::string_view(s_ts)); }
+    // 20220203-104528.093817 or 20220203-104528.093817123; the date part is
+    // validated and returned through date by the second overload
+    void from_go_ts(std::string_view s_ts);
+    void from_go_ts(std::string_view s_ts, Date& date);
     timestamp_t convert(const std::string& s_ts) const;
+    timestamp_t convert(std::string_view s_ts) const;
+    timestamp_t convert(const char* s_ts) const { return convert(std::string_view(s_ts)); }
+    timestamp_t convert(const char* buf, size_t len) const;
     constexpr operator timestamp_t() const { return _ts; }
-    timestamp_t get() const { return _ts; };
-    int to_seconds() const { return _ts/TimeConstants::ticks_per_second; }
+    constexpr timestamp_t get() const { return _ts; };
+    int to_seconds() const { return _ts/Res::ticks_per_second; }
 
+    static constexpr size_t max_str_len = 32;
     timestamp_t _ts;
   };
 
-  struct Timedelta {
-    constexpr Timedelta()
+  template <typename Res>
+  struct BasicTimedelta {
+    using resolution = Res;
+
+    constexpr BasicTimedelta()
       : _td(0) {}
-    constexpr Timedelta(timedelta_t td)
+    constexpr BasicTimedelta(timedelta_t td)
       : _td(td) {}
-    constexpr Timedelta(timestamp_t ts)
+    constexpr BasicTimedelta(timestamp_t ts)
       : _td(static_cast<timedelta_t>(ts)) {}
-    Timedelta(const std::string& s_ts);
+    template <typename From, detail::if_widening<From, Res> = 0>
+    constexpr BasicTimedelta(const BasicTimedelta<From>& td)
+      : _td(td._td * static_cast<timedelta_t>(detail::resolution_scale<From, Res>)) {}
+    template <typename From, detail::if_narrowing<From, Res> = 0>
+    BasicTimedelta(const BasicTimedelta<From>& td) = delete;
+    BasicTimedelta(const std::string& s_ts);
+
+    static ParseResult<BasicTimedelta> try_parse(std::string_view s_td);
 
     std::string str() const;
     std::string to_hms() const;
+    size_t format_to(char* buf) const;
+    size_t format_hms_to(char* buf) const;
     void from_string(const std::string& s_td) { _td = convert(s_td); }
+    void from_string(std::string_view s_td) { _td = convert(s_td); }
+    void from_string(const char* s_td) { _td = convert(s_td); }
     timedelta_t convert(const std::string& s_td);
+    timedelta_t convert(std::string_view s_td);
+    timedelta_t convert(const char* s_td) { return convert(std::string_view(s_td)); }
+    timedelta_t convert(const char* buf, size_t len);
     constexpr operator timedelta_t() const { return _td; }
+
+    static constexpr size_t max_str_len = 32;
     timedelta_t _td;
   };
 
-  Timedelta operator-(const Timestamp& ts1, const Timestamp& ts2);
-  Timestamp operator+(const Timestamp& ts, const Timedelta& td);
+  // members not defined here are instantiated for Micros and Nanos in
+  // elf_time.cpp
+  using Timestamp = BasicTimestamp<Micros>;
+  using Timedelta = BasicTimedelta<Micros>;
+  using NanoTimestamp = BasicTimestamp<Nanos>;
+  using NanoTimedelta = BasicTimedelta<Nanos>;
+
+  // Conversion to any resolution; narrowing truncates towards zero.
+  template <typename To, typename From>
+  constexpr BasicTimestamp<To>
+  resolution_cast(const BasicTimestamp<From>& ts) {
+    if constexpr(From::frac_digits > To::frac_digits)
+      return BasicTimestamp<To>(ts._ts / detail::resolution_scale<From, To>);
+    else
+      return BasicTimestamp<To>(ts);
+  }
+
+  template <typename To, typename From>
+  constexpr BasicTimedelta<To>
+  resolution_cast(const BasicTimedelta<From>& td) {
+    if constexpr(From::frac_digits > To::frac_digits)
+      return BasicTimedelta<To>(td._td / static_cast<timedelta_t>(detail::resolution_scale<From, To>));
+    else
+      return BasicTimedelta<To>(td);
+  }
+
+  constexpr size_t go_ts_len = 22;
+
+  // 20220203-104528.093817 as ticks since 1970-01-01 00:00 of the same clock;
+  // no timezone conversion is applied
+  timestamp_t epoch_from_go_ts(std::string_view s_ts);
+  ParseResult<timestamp_t> try_epoch_from_go_ts(std::string_view s_ts);
+  // Bulk epoch_from_go_ts over fixed-width rows at buf+i*stride, reporting
+  // bad rows like convert_timestamps below
+  size_t convert_go_timestamps(const char* buf, size_t stride, size_t n,
+                               timestamp_t* out, uint64_t* bad);
+
+  // Bulk HH:MM:SS.ffffff conversion. Fixed-width rows start at buf+i*stride
+  // and are width bytes long; offset-indexed rows span
+  // [buf+offsets[i], buf+offsets[i+1]). Rows accepted by Timestamp::convert
+  // are written to out; bad rows are written as 0 and flagged in bad, one bit
+  // per row over (n+63)/64 words. Returns the number of bad rows.
+  size_t convert_timestamps(const char* buf, size_t width, size_t stride, size_t n,
+                            timestamp_t* out, uint64_t* bad);
+  size_t convert_timestamps(const char* buf, const uint32_t* offsets, size_t n,
+                            timestamp_t* out, uint64_t* bad);
+
+  // Bulk YYYYMMDD and Timedelta conversion over offset-indexed rows,
+  // reporting bad rows like convert_timestamps
+  size_t convert_dates(const char* buf, const uint32_t* offsets, size_t n,
+                       date_t* out, uint64_t* bad);
+  size_t convert_timedeltas(const char* buf, const uint32_t* offsets, size_t n,
+                            timedelta_t* out, uint64_t* bad);
+
+  // Writes each Timestamp::str() followed by delim into buf, which must hold
+  // n * (Timestamp::max_str_len + 1) bytes. Returns the number of bytes written.
+  size_t format_timestamps(const timestamp_t* ts, size_t n, char* buf,
+                           char delim='\n', bool show_usec=true);
+
+  template <typename Res>
+  constexpr BasicTimedelta<Res>
+  operator-(const BasicTimestamp<Res>& ts1, const BasicTimestamp<Res>& ts2) {
+    return BasicTimedelta<Res>(static_cast<timedelta_t>(ts1._ts) - static_cast<timedelta_t>(ts2._ts));
+  }
+
+  template <typename Res>
+  constexpr BasicTimestamp<Res>
+  operator+(const BasicTimestamp<Res>& ts, const BasicTimedelta<Res>& td) {
+    return BasicTimestamp<Res>(ts._ts + td._td);
+  }
+
+  namespace detail {
+    template <typename T>
+    struct time_resolution { using type = void; };
+    template <typename Res>
+    struct time_resolution<BasicTimestamp<Res>> { using type = Res; };
+    template <typename Res>
+    struct time_resolution<BasicTimedelta<Res>> { using type = Res; };
+
+    template <typename A, typename B, typename RA = typename time_resolution<A>::type,
+              typename RB = typename time_resolution<B>::type>
+    using if_mixed_resolution = std::enable_if_t<!std::is_void_v<RA> && !std::is_void_v<RB> && !std::is_same_v<RA, RB>, int>;
+  }
+
+  // Arithmetic and comparison across resolutions would otherwise compile
+  // through the raw tick conversions and mix units; convert one side first.
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  void operator+(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  void operator-(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator==(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator!=(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator<(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator<=(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator>(const A&, const B&) = delete;
+  template <typename A, typename B, detail::if_mixed_resolution<A, B> = 0>
+  bool operator>=(const A&, const B&) = delete;
+
+  namespace detail {
+    // Compile-time mirrors of the Timestamp::convert and Timedelta::convert
+    // scanners for the literals below; test_elf_time checks they agree.
+    struct literal_result {
+      int64_t value;
+      bool ok;
+    };
+
+    constexpr bool
+    literal_digit(char c) {
+      return c >= '0' && c <= '9';
+    }
+
+    // HH:MM:SS at p, bounds as in Timestamp::convert
+    template <typename Res=Micros>
+    constexpr literal_result
+    parse_hms_literal(const char* p, size_t len) {
+      if(len < 8 || p[2] != ':' || p[5] != ':')
+        return { 0, false };
+      for(size_t i: { 0, 1, 3, 4, 6, 7 }) {
+        if(!literal_digit(p[i]))
+          return { 0, false };
+      }
+      const timestamp_t h = (p[0] - '0') * 10 + (p[1] - '0');
+      const timestamp_t m = (p[3] - '0') * 10 + (p[4] - '0');
+      const timestamp_t s = (p[6] - '0') * 10 + (p[7] - '0');
+      if(h > TimeConstants::max_hour || m > TimeConstants::max_minute || s > TimeConstants::max_second)
+        return { 0, false };
+      return { static_cast<int64_t>(h * Res::ticks_per_hour + m * Res::ticks_per_minute + s * Res::ticks_per_second), true };
+    }
+
+    // "" or .f{min_digits,9} in ticks of Res; digits below a tick must be 0
+    template <typename Res=Micros>
+    constexpr literal_result
+    parse_frac_literal(const char* p, size_t len, size_t min_digits) {
+      if(!len)
+        return { 0, true };
+      if(p[0] != '.' || len - 1 < min_digits || len - 1 > 9)
+        return { 0, false };
+      int64_t nsec = 0;
+      for(size_t i = 1; i < 10; ++i) {
+        if(i < len && !literal_digit(p[i]))
+          return { 0, false };
+        nsec = nsec * 10 + (i < len ? p[i] - '0' : 0);
+      }
+      constexpr int64_t nsec_per_tick = pow10_ticks(9 - Res::frac_digits);
+      return { nsec / nsec_per_tick, nsec % nsec_per_tick == 0 };
+    }
+
+    // HH:MM:SS[.fff..fffffffff] or ND HH:MM:SS[.ffffff..fffffffff], as
+    // Timestamp::convert
+    template <typename Res=Micros>
+    constexpr literal_result
+    parse_timestamp_literal(const char* p, size_t len) {
+      int64_t days = 0;
+      size_t min_frac_digits = 3;
+      if(len >= 2 && p[1] == 'D') {
+        if(!literal_digit(p[0]))
+          return { 0, false };
+        days = p[0] - '0';
+        p += 2;
+        len -= 2;
+        min_frac_digits = 6;
+      }
+      const literal_result hms = parse_hms_literal<Res>(p, len);
+      if(!hms.ok)
+        return hms;
+      const literal_result frac = parse_frac_literal<Res>(p + 8, len - 8, min_frac_digits);
+      return { days * static_cast<int64_t>(Res::ticks_per_day) + hms.value + frac.value, frac.ok };
+    }
+
+    struct timedelta_unit {
+      const char* name;
+      size_t len;
+      timestamp_t ticks;
+    };
+
+    // largest first; compound forms must name units in this order. A unit
+    // below the resolution has zero ticks and is not accepted.
+    template <typename Res>
+    constexpr timedelta_unit timedelta_units[] = {
+      { "hour", 4, Res::ticks_per_hour },
+      { "min", 3, Res::ticks_per_minute },
+      { "sec", 3, Res::ticks_per_second },
+      { "msec", 4, Res::ticks_per_second / 1000 },
+      { "usec", 4, Res::ticks_per_second / 1000000 },
+      { "nsec", 4, Res::ticks_per_second / 1000000000 },
+    };
+
+    // one or more <digits>[.<digits>]<unit> terms, e.g. 5min, 1.5sec,
+    // 1hour30min; shared by Timedelta::convert and the _td literal
+    template <typename Res>
+    constexpr ParseStatus
+    scan_timedelta_units(const char* p, const char* end, timestamp_t& out) {
+      constexpr timestamp_t max_timedelta = std::numeric_limits<timedelta_t>::max();
+      constexpr auto& units = timedelta_units<Res>;
+      timestamp_t total = 0;
+      size_t next_unit = 0;
+
+      do {
+        timestamp_t whole = 0;
+        const char* start = p;
+        for(; p != end && literal_digit(*p); ++p) {
+          if(whole > (max_timedelta - (*p - '0')) / 10)
+            return ParseStatus::out_of_bounds;
+          whole = whole * 10 + (*p - '0');
+        }
+        if(p == start)
+          return ParseStatus::bad_format;
+
+        timestamp_t frac = 0;
+        timestamp_t frac_scale = 1;
+        if(p != end && *p == '.') {
+          start = ++p;
+          for(; p != end && literal_digit(*p); ++p) {
+            if(p - start == 9)
+              return ParseStatus::bad_format;
+            frac = frac * 10 + (*p - '0');
+            frac_scale *= 10;
+          }
+          if(p == start)
+            return ParseStatus::bad_format;
+        }
+
+        size_t u = next_unit;
+        for(; u < std::size(units); ++u) {
+          bool match = units[u].ticks && static_cast<size_t>(end - p) >= units[u].len;
+          for(size_t i = 0; match && i < units[u].len; ++i)
+            match = p[i] == units[u].name[i];
+          if(match)
+            break;
+        }
+        if(u == std::size(units))
+          return ParseStatus::bad_format;
+
+        const timestamp_t ticks = units[u].ticks;
+        p += units[u].len;
+        next_unit = u + 1;
+
+        // fractions must land on a whole tick; split so frac * ticks cannot
+        // overflow at coarse units
+        const timestamp_t frac_q = ticks / frac_scale, frac_r = ticks % frac_scale;
+        if((frac * frac_r) % frac_scale)
+          return ParseStatus::bad_format;
+        if(whole > (max_timedelta - total) / ticks)
+          return ParseStatus::out_of_bounds;
+        total += whole * ticks + frac * frac_q + frac * frac_r / frac_scale;
+        if(total > max_timedelta)
+          return ParseStatus::out_of_bounds;
+      } while(p != end);
+
+      out = total;
+      return ParseStatus::ok;
+    }
+
+    // [-]HH:MM:SS[.fff..fffffffff] or [-]<digits>[.<digits>]<unit> terms
+    // with units in descending order, as Timedelta::convert
+    template <typename Res=Micros>
+    constexpr literal_result
+    parse_timedelta_literal(const char* p, size_t len) {
+      const bool negative = len && *p == '-';
+      if(negative) {
+        ++p;
+        --len;
+      }
+      if(!len)
+        return { 0, false };
+
+      int64_t total = 0;
+      if(len >= 8 && p[2] == ':') {
+        const literal_result hms = parse_hms_literal<Res>(p, len);
+        const literal_result frac = parse_frac_literal<Res>(p + 8, len - 8, 3);
+        if(!hms.ok || !frac.ok)
+          return { 0, false };
+        total = hms.value + frac.value;
+      } else {
+        timestamp_t td = 0;
+        if(scan_timedelta_units<Res>(p, p + len, td) != ParseStatus::ok)
+          return { 0, false };
+        total = static_cast<int64_t>(td);
+      }
+      return { negative ? -total : total, true };
+    }
+  }
+
+  // "09:30:00"_ts, "5min"_td and 20220304_d fold to constants; a malformed
+  // literal is a compile error. _ts and _td use the GNU string literal
+  // operator template extension, supported by gcc and clang.
+  inline namespace literals {
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+    template <typename Char, Char... Cs>
+    constexpr Timestamp
+    operator""_ts() {
+      constexpr char s[] = { Cs..., '\0' };
+      constexpr detail::literal_result r = detail::parse_timestamp_literal(s, sizeof...(Cs));
+      static_assert(r.ok, "malformed Timestamp literal");
+      return Timestamp(r.value);
+    }
+
+    template <typename Char, Char... Cs>
+    constexpr Timedelta
+    operator""_td() {
+      constexpr char s[] = { Cs..., '\0' };
+      constexpr detail::literal_result r = detail::parse_timedelta_literal(s, sizeof...(Cs));
+      static_assert(r.ok, "malformed Timedelta literal");
+      return Timedelta(static_cast<timedelta_t>(r.value));
+    }
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+    template <char... Cs>
+    constexpr Date
+    operator""_d() {
+      constexpr date_t value = [] {
+        date_t v = 0;
+        bool ok = true;
+        for(char c: { Cs... }) {
+          if(c == '\'')
+            continue;
+          ok = ok && detail::literal_digit(c) && v < 10000000;
+          v = ok ? v * 10 + (c - '0') : 0;
+        }
+        return ok ? v : INVALID_DATE;
+      }();
+      static_assert(validate_date(value), "malformed Date literal");
+      Date d;
+      d._d = value;
+      return d;
+    }
+  }
+
+  namespace detail {
+    // formats through T::format_to, so fmt output needs no temporary string
+    template <typename T>
+    struct elf_time_formatter {
+      constexpr auto parse(fmt::format_parse_context& ctx) -> decltype(ctx.begin()) {
+        auto it = ctx.begin();
+        if(it != ctx.end() && *it != '}')
+          throw fmt::format_error("invalid format");
+        return it;
+      }
+
+      template <typename FormatContext>
+      auto format(const T& value, FormatContext& ctx) const -> decltype(ctx.out()) {
+        char buf[T::max_str_len];
+        return std::copy_n(buf, value.format_to(buf), ctx.out());
+      }
+    };
+  }
 }
+
+template <> struct fmt::formatter<elf::Date> : elf::detail::elf_time_formatter<elf::Date> {};
+template <typename Res>
+struct fmt::formatter<elf::BasicTimestamp<Res>> : elf::detail::elf_time_formatter<elf::BasicTimestamp<Res>> {};
+template <typename Res>
+struct fmt::formatter<elf::BasicTimedelta<Res>> : elf::detail::elf_time_formatter<elf::BasicTimedelta<Res>> {};
@@ -1,17 +1,92 @@
 #include "elf_util.h"
 
 #include <boost/assert.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <cmath>
+#include <cstdlib>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <locale>
+#include <string>
+#include <utility>
+
+#include <locale.h>
 
 using namespace elf;
 using namespace std;
 
-size_t
-elf::num_digits(uint64_t n) {
-  return 1+::floor(::log10((double)n));
+namespace {
+  SimdLevel
+  detect_simd_level() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+      return SimdLevel::avx2;
+    if(__builtin_cpu_supports("sse4.2"))
+      return SimdLevel::sse42;
+#endif
+    return SimdLevel::scalar;
+  }
+
+  SimdLevel
+  cpu_simd_level() {
+    static const SimdLevel level = detect_simd_level();
+    return level;
+  }
+
+  std::atomic<SimdLevel>&
+  active_simd_level() {
+    static std::atomic<SimdLevel> level{cpu_simd_level()};
+    return level;
+  }
+}
+
+SimdLevel
+elf::simd_level() {
+  return active_simd_level().load(std::memory_order_relaxed);
+}
+
+void
+elf::set_simd_level(SimdLevel level) {
+  // never dispatch above what the cpu supports
+  active_simd_level().store(std::min(level, cpu_simd_level()), std::memory_order_relaxed);
+}
+
+Divider::Divider(uint64_t d)
+  : _d(d) {
+  BOOST_ASSERT(d != 0);
+  const int floor_log2 = 63 - __builtin_clzll(d);
+  if(!(d & (d - 1))) {
+    // powers of two are a plain shift
+    _magic = 0;
+    _shift = floor_log2;
+    _add = false;
+    return;
+  }
+
+  // m = ceil(2^(64+floor_log2) / d), kept to 64 bits when the error term
+  // allows, otherwise 65 bits with the implicit top bit handled by _add
+  const unsigned __int128 numerator = static_cast<unsigned __int128>(1) << (64 + floor_log2);
+  uint64_t proposed = static_cast<uint64_t>(numerator / d);
+  const uint64_t rem = static_cast<uint64_t>(numerator % d);
+  const uint64_t e = d - rem;
+  if(e < (uint64_t(1) << floor_log2)) {
+    _shift = floor_log2;
+    _add = false;
+  } else {
+    proposed += proposed;
+    const uint64_t twice_rem = rem + rem;
+    if(twice_rem >= d || twice_rem < rem)
+      proposed += 1;
+    _shift = floor_log2;
+    _add = true;
+  }
+  _magic = proposed + 1;
 }
 
 bool
@@ -60,52 +135,288 @@ elf::substring_atoi(const char* p, std::size_t len, std::int64_t& out) {
   return true;
 }
 
+namespace {
+  constexpr double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  constexpr uint64_t max_exact_mantissa = uint64_t(1) << 53;
+  constexpr size_t max_mantissa_digits = 19;
+
+  // correctly rounded conversion of an already validated unsigned span,
+  // for what the exact path can't represent
+  bool
+  slow_atod(const char* begin, const char* end, double& out) {
+#if defined(__cpp_lib_to_chars)
+    double d;
+    const auto r = std::from_chars(begin, end, d);
+    if(r.ec != std::errc() || r.ptr != end)
+      return false;
+    out = d;
+    return true;
+#else
+    // strtod takes its decimal point from LC_NUMERIC; strtod_l with the C
+    // locale always reads '.'. errno stays the caller's.
+    static const locale_t c_locale = ::newlocale(LC_ALL_MASK, "C", locale_t(0));
+    constexpr size_t stack_len = 255;
+    const size_t len = end - begin;
+    char stack_buf[stack_len + 1];
+    string heap_buf;
+    char* buf = stack_buf;
+    if(len > stack_len) {
+      heap_buf.assign(begin, len);
+      buf = heap_buf.data();
+    } else {
+      memcpy(buf, begin, len);
+      buf[len] = '\0';
+    }
+    const int saved_errno = errno;
+    errno = 0;
+    char* stop;
+    const double d = ::strtod_l(buf, &stop, c_locale);
+    const bool out_of_range = errno == ERANGE;
+    errno = saved_errno;
+    // ERANGE is also raised for subnormal results, which are kept
+    if(stop != buf + len || (out_of_range && (d == 0 || std::isinf(d))))
+      return false;
+    out = d;
+    return true;
+#endif
+  }
+
+  // consume up to max_digits digits into value, 8 at a time while they
+  // last; returns the number consumed
+  inline size_t
+  scan_digits(const char*& p, const char* end, size_t max_digits, uint64_t& value) {
+    const char* begin = p;
+    const char* stop = p + std::min<size_t>(max_digits, end - p);
+    while(stop - p >= 8) {
+      const uint64_t v = detail::load_u64(p);
+      if(!detail::swar_is_8_digits(v))
+        break;
+      value = value * 100000000 + detail::swar_8_digits(v);
+      p += 8;
+    }
+    for(; p != stop && static_cast<unsigned char>(*p - '0') < 10; ++p)
+      value = value * 10 + (*p - '0');
+    return p - begin;
+  }
+
+  template<unsigned Scale>
+  bool
+  atofixed(const char* p, size_t len, int64_t& out) {
+    const char* end = p + len;
+    for(; p != end && *p == ' '; ++p)
+      ;
+
+    bool negative = false;
+    if(p != end && (*p == '+' || *p == '-')) {
+      negative = *p == '-';
+      ++p;
+    }
+
+    // leading zeros don't count towards the 19 digits a uint64 holds; a
+    // digit left over after those is an overflow
+    const char* const start = p;
+    for(; p != end && *p == '0'; ++p)
+      ;
+    uint64_t whole = 0;
+    scan_digits(p, end, max_mantissa_digits, whole);
+    bool has_digits = p != start;
+
+    uint64_t frac = 0;
+    size_t n_frac = 0;
+    if(p != end && *p == '.') {
+      ++p;
+      const char* frac_start = p;
+      n_frac = scan_digits(p, end, Scale, frac);
+      // digits past the scale are only exact if they are zero
+      for(; p != end && *p == '0'; ++p)
+        ;
+      has_digits |= p != frac_start;
+    }
+
+    // a NUL ends the field early, as in substring_atoi; any other byte,
+    // including an overflowing or excess-precision digit, is an error
+    if(!has_digits || (p != end && *p != '\0'))
+      return false;
+
+    uint64_t v;
+    if(__builtin_mul_overflow(whole, detail::pow10_u64[Scale], &v) ||
+       __builtin_add_overflow(v, frac * detail::pow10_u64[Scale - n_frac], &v))
+      return false;
+    if(v > uint64_t(std::numeric_limits<int64_t>::max()) + negative)
+      return false;
+    out = static_cast<int64_t>(negative ? 0 - v : v);
+    return true;
+  }
+
+  using atofixed_fn = bool (*)(const char*, size_t, int64_t&);
+
+  template<size_t... Scales>
+  constexpr std::array<atofixed_fn, sizeof...(Scales)>
+  make_atofixed_table(std::index_sequence<Scales...>) {
+    return { &atofixed<Scales>... };
+  }
+
+  constexpr auto atofixed_table = make_atofixed_table(std::make_index_sequence<max_fixed_scale + 1>());
+}
+
 bool
 elf::substring_atod(const char* p, size_t len, double& out) {
   BOOST_ASSERT(p != nullptr);
   const char* end = p + len;
-  for(; *p == ' ' && p != end && *p != '\0'; ++p)
+  for(; p != end && *p == ' '; ++p)
     ;
 
-  if(p == end || *p == '\0')
-    return false;
+  bool negative = false;
+  if(p != end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    ++p;
+  }
 
-  int sign = 1;
-  if(*p == '+') {
+  // the mantissa wraps past 19 digits; that is only used to pick the slow
+  // path, which reparses from start
+  const char* const start = p;
+  uint64_t mantissa = 0;
+  size_t n_digits = scan_digits(p, end, SIZE_MAX, mantissa);
+  int64_t exp10 = 0;
+  if(p != end && *p == '.') {
     ++p;
-  } else if(*p == '-') {
-    sign = -1;
+    const size_t n_frac = scan_digits(p, end, SIZE_MAX, mantissa);
+    n_digits += n_frac;
+    exp10 = -static_cast<int64_t>(n_frac);
+  }
+  if(!n_digits)
+    return false;
+
+  if(p != end && (*p == 'e' || *p == 'E')) {
     ++p;
+    bool exp_negative = false;
+    if(p != end && (*p == '+' || *p == '-')) {
+      exp_negative = *p == '-';
+      ++p;
+    }
+    if(p == end || static_cast<unsigned char>(*p - '0') >= 10)
+      return false;
+    int64_t e = 0;
+    for(; p != end && static_cast<unsigned char>(*p - '0') < 10; ++p) {
+      // anything this large is zero or infinity either way
+      if(e < 100000)
+        e = e * 10 + (*p - '0');
+    }
+    exp10 += exp_negative ? -e : e;
   }
 
-  if(p == end || *p == '\0')
+  // a NUL ends the field early, as in substring_atoi
+  if(p != end && *p != '\0')
     return false;
 
-  std::uint64_t before = 0;
-  for(; p != end && *p != '\0'; ++p) {
-    if(*p == '.')
-      break;
-    const int digit = static_cast<int>(*p) - '0';
-    if(digit < 0 || digit > 9)
-      return false;
+  double d;
+  if(n_digits <= max_mantissa_digits && mantissa <= max_exact_mantissa && exp10 >= -22 && exp10 <= 22) {
+    // Clinger's fast path: both operands are exact doubles, so the single
+    // rounding of the multiply or divide is the correct one
+    d = static_cast<double>(mantissa);
+    d = exp10 < 0 ? d / exact_pow10[-exp10] : d * exact_pow10[exp10];
+  } else if(n_digits <= max_mantissa_digits && mantissa == 0) {
+    d = 0;
+  } else if(!slow_atod(start, p, d)) {
+    return false;
+  }
+  out = negative ? -d : d;
+  return true;
+}
+
+size_t
+elf::convert_doubles(const char* buf, const uint32_t* offsets, size_t n, double* out, uint64_t* bad) {
+  size_t n_bad = 0;
+  for(size_t w = 0; w < n; w += 64) {
+    const size_t end = std::min(n, w + 64);
+    uint64_t word = 0;
+    for(size_t i = w; i < end; ++i) {
+      double d = 0;
+      const bool ok = substring_atod(buf + offsets[i], offsets[i + 1] - offsets[i], d);
+      out[i] = ok ? d : 0;
+      word |= uint64_t(!ok) << (i - w);
+    }
+    bad[w / 64] = word;
+    n_bad += __builtin_popcountll(word);
+  }
+  return n_bad;
+}
 
-    before = before * 10 + digit;
+size_t
+elf::convert_integers(const char* buf, const uint32_t* offsets, size_t n, int64_t* out, uint64_t* bad) {
+  size_t n_bad = 0;
+  for(size_t w = 0; w < n; w += 64) {
+    const size_t end = std::min(n, w + 64);
+    uint64_t word = 0;
+    for(size_t i = w; i < end; ++i) {
+      int64_t v = 0;
+      const bool ok = substring_atoi(buf + offsets[i], offsets[i + 1] - offsets[i], v);
+      out[i] = ok ? v : 0;
+      word |= uint64_t(!ok) << (i - w);
+    }
+    bad[w / 64] = word;
+    n_bad += __builtin_popcountll(word);
   }
+  return n_bad;
+}
 
-  if(*p == '.')
-    ++p;
+template<unsigned Scale>
+bool
+elf::substring_atofixed(const char* p, size_t len, int64_t& out) {
+  BOOST_ASSERT(p != nullptr);
+  return atofixed<Scale>(p, len, out);
+}
 
-  std::uint32_t div = 1;
-  std::uint64_t after = 0;
-  for(; p != end && *p != '\0'; ++p) {
-    const int digit = static_cast<int>(*p) - '0';
-    if(digit < 0 || digit > 9)
-      return false;
+#define ELF_INSTANTIATE_ATOFIXED(scale) \
+  template bool elf::substring_atofixed<scale>(const char*, size_t, int64_t&);
+ELF_INSTANTIATE_ATOFIXED(0)
+ELF_INSTANTIATE_ATOFIXED(1)
+ELF_INSTANTIATE_ATOFIXED(2)
+ELF_INSTANTIATE_ATOFIXED(3)
+ELF_INSTANTIATE_ATOFIXED(4)
+ELF_INSTANTIATE_ATOFIXED(5)
+ELF_INSTANTIATE_ATOFIXED(6)
+ELF_INSTANTIATE_ATOFIXED(7)
+ELF_INSTANTIATE_ATOFIXED(8)
+ELF_INSTANTIATE_ATOFIXED(9)
+ELF_INSTANTIATE_ATOFIXED(10)
+ELF_INSTANTIATE_ATOFIXED(11)
+ELF_INSTANTIATE_ATOFIXED(12)
+ELF_INSTANTIATE_ATOFIXED(13)
+ELF_INSTANTIATE_ATOFIXED(14)
+ELF_INSTANTIATE_ATOFIXED(15)
+ELF_INSTANTIATE_ATOFIXED(16)
+ELF_INSTANTIATE_ATOFIXED(17)
+ELF_INSTANTIATE_ATOFIXED(18)
+#undef ELF_INSTANTIATE_ATOFIXED
 
-    after = after * 10 + digit;
-    div *= 10;
-  }
+bool
+elf::substring_atofixed(const char* p, size_t len, unsigned scale, int64_t& out) {
+  BOOST_ASSERT(p != nullptr);
+  if(scale > max_fixed_scale)
+    return false;
+  return atofixed_table[scale](p, len, out);
+}
 
-  out = (before + (after / static_cast<double>(div))) * sign;
-  return true;
+size_t
+elf::convert_fixed(const char* buf, const uint32_t* offsets, size_t n, unsigned scale,
+                   int64_t* out, uint64_t* bad) {
+  const atofixed_fn parse = scale <= max_fixed_scale ? atofixed_table[scale] : nullptr;
+  size_t n_bad = 0;
+  for(size_t w = 0; w < n; w += 64) {
+    const size_t end = std::min(n, w + 64);
+    uint64_t word = 0;
+    for(size_t i = w; i < end; ++i) {
+      int64_t v = 0;
+      const bool ok = parse && parse(buf + offsets[i], offsets[i + 1] - offsets[i], v);
+      out[i] = ok ? v : 0;
+      word |= uint64_t(!ok) << (i - w);
+    }
+    bad[w / 64] = word;
+    n_bad += __builtin_popcountll(word);
+  }
+  return n_bad;
 }
@@ -2,9 +2,277 @@
 
 #include <stdint.h>
 #include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace elf {
-  size_t num_digits(uint64_t n);
+  // instruction set used by the bulk kernels; detected once at startup
+  enum class SimdLevel { scalar, sse42, avx2 };
+  SimdLevel simd_level();
+  void set_simd_level(SimdLevel level);
+
   bool substring_atoi(const char* buf, size_t len, int64_t& n);
+  // [spaces][sign]digits[.digits][e[sign]digits], correctly rounded; false
+  // for malformed fields and values outside the range of double
   bool substring_atod(const char* buf, size_t len, double& d);
+  // Bulk substring_atod over fields [buf+offsets[i], buf+offsets[i+1]).
+  // Bad fields are written as 0 and flagged in bad, one bit per field over
+  // (n+63)/64 words. Returns the number of bad fields.
+  size_t convert_doubles(const char* buf, const uint32_t* offsets, size_t n,
+                         double* out, uint64_t* bad);
+  // Bulk substring_atoi over offset-indexed fields, reporting bad fields
+  // like convert_doubles
+  size_t convert_integers(const char* buf, const uint32_t* offsets, size_t n,
+                          int64_t* out, uint64_t* bad);
+
+  // [spaces][sign]digits[.digits] as an integer count of 10^-Scale units,
+  // e.g. "123.4567" at scale 4 is 1234567. Fails on overflow of int64 and
+  // on nonzero digits past the scale rather than rounding. Scales
+  // 0..max_fixed_scale are instantiated in elf_util.cpp.
+  constexpr unsigned max_fixed_scale = 18;
+  template<unsigned Scale>
+  bool substring_atofixed(const char* buf, size_t len, int64_t& n);
+  bool substring_atofixed(const char* buf, size_t len, unsigned scale, int64_t& n);
+  // Bulk substring_atofixed over offset-indexed fields, reporting bad fields
+  // like convert_doubles
+  size_t convert_fixed(const char* buf, const uint32_t* offsets, size_t n, unsigned scale,
+                       int64_t* out, uint64_t* bad);
+
+  namespace detail {
+    constexpr uint64_t pow10_u64[] = {
+      1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+      100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+      10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+      100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+    };
+
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "swar parsing assumes little-endian loads");
+
+    inline uint64_t
+    load_u64(const char* p) {
+      uint64_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    // N bytes as a little-endian integer, built from naturally sized loads;
+    // a short memcpy into a zeroed word goes through the stack and stalls
+    template<size_t N>
+    inline uint64_t
+    load_le(const char* p) {
+      if constexpr(N == 8) {
+        return load_u64(p);
+      } else if constexpr(N >= 4) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v | (load_le<N - 4>(p + 4) << 32);
+      } else if constexpr(N >= 2) {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        return v | (load_le<N - 2>(p + 2) << 16);
+      } else if constexpr(N == 1) {
+        return static_cast<unsigned char>(*p);
+      } else {
+        return 0;
+      }
+    }
+
+    // N bytes placed at the top of the word with '0' padding below, as if
+    // the field were zero-filled on the left to 8 digits
+    template<size_t N>
+    inline uint64_t
+    load_digits(const char* p) {
+      static_assert(N >= 1 && N <= 8);
+      if constexpr(N == 8)
+        return load_u64(p);
+      else
+        return (load_le<N>(p) << (8 * (8 - N))) | (0x3030303030303030ull >> (8 * N));
+    }
+
+    inline bool
+    swar_is_8_digits(uint64_t v) {
+      return (((v & 0xf0f0f0f0f0f0f0f0) | (((v + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) == 0x3333333333333333);
+    }
+
+    // ascii digits, first byte most significant, combined pairwise into
+    // 16-bit lanes holding two-digit values
+    inline uint64_t
+    swar_pairs(uint64_t v) {
+      v -= 0x3030303030303030;
+      return (v * 10 + (v >> 8)) & 0x00ff00ff00ff00ff;
+    }
+
+    inline uint32_t
+    swar_8_digits(uint64_t v) {
+      v = swar_pairs(v);
+      v = (v * 100 + (v >> 16)) & 0x0000ffff0000ffff;
+      return (v * 10000 + (v >> 32)) & 0xffffffff;
+    }
+
+    inline bool
+    parse_16_digits(const char* p, uint64_t& out) {
+#if defined(__SSE2__)
+      const __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), _mm_set1_epi8('0'));
+      // bytes below '0' wrap around and fail the same test as those above '9'
+      const __m128i over = _mm_subs_epu8(digits, _mm_set1_epi8(9));
+      const bool ok = _mm_movemask_epi8(_mm_cmpeq_epi8(over, _mm_setzero_si128())) == 0xffff;
+      // each 16-bit lane holds a tens digit in its low byte
+      const __m128i pairs = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(digits, _mm_set1_epi16(0xff)), _mm_set1_epi16(10)),
+                                          _mm_srli_epi16(digits, 8));
+      const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+      const __m128i octs = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set1_epi32(0x00012710));
+      out = uint64_t(uint32_t(_mm_cvtsi128_si32(octs))) * 100000000
+        + uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(octs, 4)));
+      return ok;
+#else
+      const uint64_t hi = load_u64(p), lo = load_u64(p + 8);
+      out = uint64_t(swar_8_digits(hi)) * 100000000 + swar_8_digits(lo);
+      return swar_is_8_digits(hi) & swar_is_8_digits(lo);
+#endif
+    }
+
+    // exactly N ascii digits; out is unspecified when false is returned
+    template<size_t N>
+    inline bool
+    parse_digits(const char* p, uint64_t& out) {
+      if constexpr(N <= 8) {
+        const uint64_t v = load_digits<N>(p);
+        out = swar_8_digits(v);
+        return swar_is_8_digits(v);
+      } else if constexpr(N == 16) {
+        return parse_16_digits(p, out);
+      } else {
+        uint64_t hi, lo;
+        const bool ok = parse_digits<N - 8>(p, hi) & parse_digits<8>(p + N - 8, lo);
+        out = hi * 100000000 + lo;
+        return ok;
+      }
+    }
+
+    // ascii digit writers; each returns the end of what it wrote
+    constexpr char digit_pairs[] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+
+    inline char*
+    write_2d(char* p, unsigned v) {
+      memcpy(p, digit_pairs + 2 * v, 2);
+      return p + 2;
+    }
+
+    inline char*
+    write_uint(char* p, uint64_t v) {
+      char tmp[20];
+      char* t = tmp + sizeof(tmp);
+      for(; v >= 100; v /= 100) {
+        t -= 2;
+        memcpy(t, digit_pairs + 2 * (v % 100), 2);
+      }
+      if(v >= 10) {
+        t -= 2;
+        memcpy(t, digit_pairs + 2 * v, 2);
+      } else {
+        *--t = '0' + v;
+      }
+      const size_t n = tmp + sizeof(tmp) - t;
+      memcpy(p, t, n);
+      return p + n;
+    }
+
+    inline char*
+    write_6d(char* p, unsigned v) {
+      p = write_2d(p, v / 10000);
+      p = write_2d(p, v / 100 % 100);
+      return write_2d(p, v % 100);
+    }
+
+    inline char*
+    write_9d(char* p, unsigned v) {
+      *p++ = '0' + v / 100000000;
+      v %= 100000000;
+      p = write_2d(p, v / 1000000);
+      p = write_2d(p, v / 10000 % 100);
+      p = write_2d(p, v / 100 % 100);
+      return write_2d(p, v % 100);
+    }
+  }
+
+  // Unsigned 64-bit division by a divisor fixed at construction, as a
+  // multiply-high and shifts (the libdivide scheme); for dividing many
+  // values by the same runtime divisor.
+  class Divider {
+  public:
+    explicit Divider(uint64_t d);
+
+    uint64_t divisor() const { return _d; }
+    uint64_t magic() const { return _magic; }
+    uint8_t shift() const { return _shift; }
+    // magic is 65 bits wide; the quotient needs the add step below
+    bool add_marker() const { return _add; }
+
+    uint64_t
+    divide(uint64_t n) const {
+      // a zero magic marks a power of two
+      if(!_magic)
+        return n >> _shift;
+      const uint64_t q = static_cast<uint64_t>((static_cast<unsigned __int128>(n) * _magic) >> 64);
+      if(_add)
+        return (((n - q) >> 1) + q) >> _shift;
+      return q >> _shift;
+    }
+
+  private:
+    uint64_t _d;
+    uint64_t _magic;
+    uint8_t _shift;
+    bool _add;
+  };
+
+  // decimal digits in n, 1 for 0. bits*1233>>12 is floor(bits*log10(2)),
+  // which undercounts by at most one; a table compare corrects it. n|1
+  // doesn't change the answer since powers of ten above 1 are even.
+  constexpr size_t
+  num_digits(uint64_t n) {
+    const uint64_t m = n | 1;
+    const size_t t = ((64 - __builtin_clzll(m)) * 1233) >> 12;
+    return t + (m >= detail::pow10_u64[t]);
+  }
+
+  // Fixed-width field of N bytes. An unsigned Int means the field is digits
+  // only; a signed Int also accepts the leading whitespace and sign of the
+  // runtime-length version, which handles anything that isn't all digits.
+  // out is written even when the digits don't validate, so callers can
+  // combine several fields and test once.
+  template<size_t N, typename Int>
+  inline bool
+  substring_atoi(const char* p, Int& out) {
+    static_assert(std::is_integral_v<Int>);
+    static_assert(N >= 1 && N <= 16, "substring_atoi: width must be 1..16");
+    static_assert(N <= std::numeric_limits<Int>::digits10, "substring_atoi: width overflows the output type");
+
+    uint64_t v;
+    const bool ok = detail::parse_digits<N>(p, v);
+    out = static_cast<Int>(v);
+    if constexpr(std::is_signed_v<Int>) {
+      int64_t n;
+      if(!ok && substring_atoi(p, N, n)) {
+        out = static_cast<Int>(n);
+        return true;
+      }
+    }
+    return ok;
+  }
 }
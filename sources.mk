@@ -1,11 +1,21 @@
-INCLUDES=elf_exception.h elf_util.h elf_time.h boost_enum.hpp
+INCLUDES=elf_exception.h elf_util.h elf_time.h elf_partition.h elf_clock.h elf_datetime.h elf_calendar.h elf_bars.h elf_csv.h elf_parallel.h boost_enum.h
 
-SOURCES=elf_exception.cpp elf_util.cpp elf_time.cpp
+SOURCES=elf_exception.cpp elf_util.cpp elf_time.cpp elf_partition.cpp elf_clock.cpp elf_datetime.cpp elf_calendar.cpp elf_bars.cpp elf_csv.cpp elf_parallel.cpp
 
-UNITTEST_SOURCES=test/unittest_driver.cpp test/test_elf_time.cpp
+BENCH_SOURCES=bench/bench_main.cpp bench/bench_time.cpp bench/bench_util.cpp bench/bench_enum.cpp bench/bench_clock.cpp bench/bench_datetime.cpp bench/bench_calendar.cpp bench/bench_bars.cpp bench/bench_csv.cpp bench/bench_parallel.cpp
+
+UNITTEST_SOURCES=test/unittest_driver.cpp test/test_elf_time.cpp test/test_elf_partition.cpp test/test_elf_clock.cpp test/test_elf_util.cpp test/test_elf_datetime.cpp test/test_elf_calendar.cpp test/test_elf_bars.cpp test/test_elf_exception.cpp test/test_boost_enum.cpp test/test_elf_csv.cpp test/test_elf_parallel.cpp
 
 OBJECTS=$(SOURCES:.cpp=.o)
 UNITTEST_OBJECTS:=$(UNITTEST_SOURCES:.cpp=.o)
 
+# benchmarks always build optimized, in their own object tree
+BENCH_OBJDIR=.bench
+BENCH_OBJECTS:=$(addprefix $(BENCH_OBJDIR)/,$(SOURCES:.cpp=.o) $(BENCH_SOURCES:.cpp=.o))
+
+# the sanitized unit tests, likewise
+UBSAN_OBJDIR=.ubsan
+UBSAN_OBJECTS:=$(addprefix $(UBSAN_OBJDIR)/,$(SOURCES:.cpp=.o) $(UNITTEST_SOURCES:.cpp=.o))
+
 DEPENDS:=$(SOURCES:.cpp=.d)
 DEPENDS+=$(UNITTEST_SOURCES:.cpp=.d)
@@ -0,0 +1,208 @@
+#include "boost_enum.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+  BOOST_ENUM(Side, (Buy)(Sell)(SellShort)(SellShortExempt))
+
+  // names equal up to case resolve to the first in declaration order
+  BOOST_ENUM(Cased, (Open)(OPEN)(open)(Close))
+
+  BOOST_ENUM_VALUES(Exchange, int,
+    (AMEX)(1)(ARCA)(2)(BATS)(3)(BATY)(4)(BOX)(5)(C2)(6)(CBOE)(7)(CHX)(8)
+    (EDGA)(9)(EDGX)(10)(EMLD)(11)(GEMX)(12)(IEX)(13)(ISE)(14)(LTSE)(15)(MCRY)(16)
+    (MEMX)(17)(MIAX)(18)(MPRL)(19)(NASDAQ)(20)(NQBX)(21)(NQPX)(22)(NSX)(23)(NYSE)(24)
+    (PHLX)(25)(PSX)(26)(SAPPHIRE)(27)(OTC)(28)(FINRA)(29)(CME)(30)(CBOT)(31)(NYMEX)(32))
+
+  BOOST_ENUM_VALUES(Wire, char, (Bid)('B')(Ask)('A')(Trade)('T')(Cross)('T'))
+  // too spread out for a direct table
+  BOOST_ENUM_VALUES(Sparse, int64_t, (Low)(-5000000000)(Mid)(7)(High)(1 << 30)(Again)(7))
+  BOOST_ENUM_VALUES(Tick, double, (Half)(0.5)(Quarter)(0.25)(Cent)(0.01))
+  // the long-standing string form; pointers found by == on the same literal
+  BOOST_ENUM_VALUES(Level, const char*, (Abort)("abort")(Error)("error")(Warn)("warn"))
+
+  // PASSIVE is a composite of two other flags
+  BOOST_BITFIELD(OrderFlags,
+    (IOC)(0x1)(POST_ONLY)(0x2)(HIDDEN)(0x4)(REDUCE_ONLY)(0x10)(PASSIVE)(0x6))
+
+  static_assert(Exchange(Exchange::NYSE).value() == 24);
+  static_assert(Exchange(Exchange::AMEX) < Exchange(Exchange::NYSE));
+  static_assert(Side(Side::Sell).value() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE(boost_enum)
+
+BOOST_AUTO_TEST_CASE(get_by_string) {
+  for(const Exchange& e: Exchange()) {
+    const std::string name = e.str();
+    BOOST_TEST(Exchange::get_by_string(name.c_str())->index() == e.index());
+    BOOST_TEST(Exchange::get_by_string(std::string_view(name))->index() == e.index());
+    BOOST_TEST(Exchange::get_by_name(name.c_str())->index() == e.index());
+  }
+  BOOST_TEST(!Exchange::get_by_string("nyse"));
+  BOOST_TEST(!Exchange::get_by_string(""));
+  BOOST_TEST(!Exchange::get_by_string("NYSEX"));
+  // a view need not be NUL-terminated
+  BOOST_TEST((*Exchange::get_by_string(std::string_view("NYSEX", 4)) == Exchange::NYSE));
+  BOOST_TEST((*Side::get_by_string("SellShort") == Side::SellShort));
+  BOOST_TEST((Side::get_by_string_with_default("Hold", Side::Sell) == Side::Sell));
+  BOOST_TEST((Side::get_by_string_with_default(std::string_view("Buy"), Side::Sell) == Side::Buy));
+
+  BOOST_TEST((*Cased::get_by_string("OPEN") == Cased::OPEN));
+  BOOST_TEST((*Cased::get_by_string("open") == Cased::open));
+  BOOST_TEST(!Cased::get_by_string("oPEN"));
+}
+
+BOOST_AUTO_TEST_CASE(get_by_istring) {
+  BOOST_TEST((*Exchange::get_by_istring("nasdaq") == Exchange::NASDAQ));
+  BOOST_TEST((*Exchange::get_by_istring(std::string_view("Sapphire")) == Exchange::SAPPHIRE));
+  BOOST_TEST(!Exchange::get_by_istring("nasda"));
+  BOOST_TEST((Side::get_by_istring_with_default("SELLSHORTEXEMPT", Side::Buy) == Side::SellShortExempt));
+  BOOST_TEST((Side::get_by_istring_with_default("sel", Side::Buy) == Side::Buy));
+
+  BOOST_TEST((*Cased::get_by_istring("oPEN") == Cased::Open));
+  BOOST_TEST((*Cased::get_by_istring("close") == Cased::Close));
+}
+
+BOOST_AUTO_TEST_CASE(value_tables) {
+  BOOST_TEST(std::string(Exchange(Exchange::NASDAQ).str()) == "NASDAQ");
+  BOOST_TEST(Wire(Wire::Trade).value() == 'T');
+
+  for(const Exchange& e: Exchange())
+    BOOST_TEST(Exchange::get_by_value(e.value())->index() == e.index());
+  BOOST_TEST(!Exchange::get_by_value(0));
+  BOOST_TEST(!Exchange::get_by_value(33));
+  BOOST_TEST(!Exchange::get_by_value(-1));
+  for(const Side& s: Side())
+    BOOST_TEST(Side::get_by_value(s.value())->index() == s.index());
+  BOOST_TEST(!Side::get_by_value(4));
+
+  // a repeated value finds its first name
+  BOOST_TEST((*Wire::get_by_value('T') == Wire::Trade));
+  BOOST_TEST(!Wire::get_by_value('C'));
+  BOOST_TEST((*Sparse::get_by_value(7) == Sparse::Mid));
+  BOOST_TEST((*Sparse::get_by_value(-5000000000) == Sparse::Low));
+  BOOST_TEST((*Sparse::get_by_value(1 << 30) == Sparse::High));
+  BOOST_TEST(!Sparse::get_by_value(8));
+  BOOST_TEST(!Sparse::get_by_value(-5000000001));
+  BOOST_TEST((*Tick::get_by_value(0.25) == Tick::Quarter));
+  BOOST_TEST(!Tick::get_by_value(0.1));
+  for(const Level& l: Level())
+    BOOST_TEST(Level::get_by_value(l.value())->index() == l.index());
+  BOOST_TEST(std::string(Level(Level::Error).value()) == "error");
+  BOOST_TEST(std::string(Level::get_by_string("Warn")->value()) == "warn");
+  const char other[] = "error";
+  BOOST_TEST(!Level::get_by_value(other));
+
+  // ordered by value, then by declaration
+  std::vector<Sparse> sorted(Sparse::begin(), Sparse::end());
+  std::sort(sorted.begin(), sorted.end());
+  BOOST_TEST((sorted[0] == Sparse::Low && sorted[1] == Sparse::Mid && sorted[2] == Sparse::Again && sorted[3] == Sparse::High));
+  BOOST_TEST((Wire(Wire::Trade) < Wire(Wire::Cross)));
+  BOOST_TEST(!(Wire(Wire::Cross) < Wire(Wire::Trade)));
+}
+
+BOOST_AUTO_TEST_CASE(bitfield_flags) {
+  OrderFlags flags = OrderFlags(OrderFlags::REDUCE_ONLY) | OrderFlags(OrderFlags::IOC);
+  BOOST_TEST(flags.value() == 0x11u);
+  BOOST_TEST(flags.count() == 2u);
+  BOOST_TEST(flags.test(OrderFlags::IOC));
+  BOOST_TEST(!flags.test(OrderFlags::PASSIVE));
+  flags |= OrderFlags::PASSIVE;
+  BOOST_TEST(flags.test(OrderFlags::HIDDEN));
+  BOOST_TEST((~flags).value() == 0u);
+  BOOST_TEST((~OrderFlags(OrderFlags::IOC)).value() == 0x16u);
+  BOOST_TEST(OrderFlags(OrderFlags::all_mask).value() == 0x17u);
+  BOOST_TEST(!OrderFlags().any());
+
+  // not_mask holds only undeclared bits: none of the flag views see them,
+  // but test() does, on the raw bits
+  const OrderFlags undeclared(OrderFlags::not_mask);
+  BOOST_TEST(undeclared.value() == ~uint64_t(0x17));
+  BOOST_TEST(!undeclared.any());
+  BOOST_TEST(undeclared.count() == 0u);
+  BOOST_TEST(undeclared.str() == "");
+  BOOST_TEST(std::distance(undeclared.flags().begin(), undeclared.flags().end()) == 0);
+  BOOST_TEST((~undeclared).value() == 0x17u);
+  BOOST_TEST(!undeclared.test(OrderFlags::IOC));
+  BOOST_TEST(undeclared.test(undeclared));
+  BOOST_TEST((OrderFlags(OrderFlags::IOC) | undeclared).any());
+  std::ostringstream undeclared_out;
+  undeclared_out << undeclared << '.' << (undeclared | OrderFlags::HIDDEN);
+  BOOST_TEST(undeclared_out.str() == ".HIDDEN");
+
+  // set flags come back in bit order, composites as their parts
+  std::vector<std::string> names;
+  for(const OrderFlags& flag: flags.flags())
+    names.push_back(flag.str());
+  BOOST_TEST((names == std::vector<std::string>{ "IOC", "POST_ONLY", "HIDDEN", "REDUCE_ONLY" }));
+  BOOST_TEST(std::distance(OrderFlags().flags().begin(), OrderFlags().flags().end()) == 0);
+
+  // every declared flag
+  BOOST_TEST(std::distance(OrderFlags::begin(), OrderFlags::end()) == 5);
+
+  BOOST_TEST(OrderFlags::get_by_value(0x13)->count() == 3u);
+  BOOST_TEST(!OrderFlags::get_by_value(0x8));
+  BOOST_TEST(OrderFlags::get_by_name("PASSIVE")->value() == 0x6u);
+}
+
+BOOST_AUTO_TEST_CASE(bitfield_parse_format) {
+  BOOST_TEST(OrderFlags::parse("IOC|POST_ONLY")->value() == 0x3u);
+  BOOST_TEST(OrderFlags::parse("PASSIVE|REDUCE_ONLY")->value() == 0x16u);
+  BOOST_TEST(OrderFlags::parse("HIDDEN")->value() == 0x4u);
+  BOOST_TEST(OrderFlags::parse("")->value() == 0u);
+  BOOST_TEST(OrderFlags::parse("IOC,HIDDEN", ',')->value() == 0x5u);
+  BOOST_TEST(OrderFlags::iparse("ioc|Post_Only")->value() == 0x3u);
+  BOOST_TEST(!OrderFlags::parse("IOC|"));
+  BOOST_TEST(!OrderFlags::parse("IOC||HIDDEN"));
+  BOOST_TEST(!OrderFlags::parse("ioc"));
+  BOOST_TEST(!OrderFlags::parse("IOC|FOK"));
+
+  const OrderFlags flags = *OrderFlags::parse("REDUCE_ONLY|PASSIVE");
+  char buf[64];
+  BOOST_TEST(flags.format(buf, sizeof(buf)) == 28u);
+  BOOST_TEST(std::string(buf) == "POST_ONLY|HIDDEN|REDUCE_ONLY");
+  BOOST_TEST(flags.format(buf, sizeof(buf), ' ') == 28u);
+  BOOST_TEST(std::string(buf) == "POST_ONLY HIDDEN REDUCE_ONLY");
+  BOOST_TEST(flags.str() == "POST_ONLY|HIDDEN|REDUCE_ONLY");
+  BOOST_TEST(OrderFlags::parse(flags.str())->value() == flags.value());
+
+  // truncated to the buffer, the full length still reported
+  BOOST_TEST(flags.format(buf, 12) == 28u);
+  BOOST_TEST(std::string(buf) == "POST_ONLY|H");
+  BOOST_TEST(flags.format(buf, 1) == 28u);
+  BOOST_TEST(std::string(buf) == "");
+  BOOST_TEST(flags.format(nullptr, 0) == 28u);
+  BOOST_TEST(OrderFlags().format(buf, sizeof(buf)) == 0u);
+  BOOST_TEST(std::string(buf) == "");
+
+  std::ostringstream out;
+  out << flags;
+  BOOST_TEST(out.str() == "POST_ONLY|HIDDEN|REDUCE_ONLY");
+  std::istringstream in("IOC|HIDDEN IOC|BAD");
+  OrderFlags read;
+  in >> read;
+  BOOST_TEST(read.value() == 0x5u);
+  in >> read;
+  BOOST_TEST(in.bad());
+}
+
+BOOST_AUTO_TEST_CASE(stream) {
+  std::istringstream in("CBOT Bogus");
+  Exchange e;
+  in >> e;
+  BOOST_TEST((e == Exchange::CBOT));
+  in >> e;
+  BOOST_TEST(in.bad());
+
+  std::ostringstream out;
+  out << Side(Side::SellShortExempt);
+  BOOST_TEST(out.str() == "SellShortExempt");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+#include "elf_bars.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace elf;
+
+namespace {
+  // a trading day of ticks, sorted, with gaps longer than a bar
+  std::vector<timestamp_t>
+  tick_times(size_t n, uint32_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<timestamp_t> out;
+    timestamp_t t = Timestamp("09:30:00").get() + Date(20220304).to_days() * TimeConstants::ticks_per_day;
+    for(size_t i = 0; i < n; ++i) {
+      t += rng() % 8 == 0 ? rng() % 300000000 : rng() % 50000;
+      out.push_back(t);
+    }
+    return out;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(elf_bars)
+
+BOOST_AUTO_TEST_CASE(bucket_ids_and_floor) {
+  const std::vector<timestamp_t> ts = tick_times(1001, 17);
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    for(timedelta_t width: { timedelta_t(1000), timedelta_t(60000000), timedelta_t(300000000), timedelta_t(86400000000),
+                             timedelta_t(7) << 40, timedelta_t(1) << 36 }) {
+      for(timestamp_t origin: { timestamp_t(0), ts[0] - 12345 }) {
+        std::vector<uint64_t> ids(ts.size());
+        std::vector<timestamp_t> floors(ts.size());
+        bucket_ids(ts.data(), ts.size(), Timedelta(width), ids.data(), origin);
+        floor_timestamps(ts.data(), ts.size(), Timedelta(width), floors.data(), origin);
+        BOOST_TEST_CONTEXT("simd " << int(level) << " width " << width << " origin " << origin) {
+          for(size_t i = 0; i < ts.size(); ++i) {
+            const uint64_t q = static_cast<uint64_t>(ts[i] - origin) / width;
+            BOOST_TEST(ids[i] == q, "row " << i);
+            BOOST_TEST(floors[i] == static_cast<timestamp_t>(q * width) + origin, "row " << i);
+          }
+        }
+      }
+    }
+  }
+  set_simd_level(detected);
+
+  timestamp_t t = 0;
+  BOOST_CHECK_THROW(floor_timestamps(&t, 1, Timedelta(timedelta_t(0)), &t), elf_error);
+  BOOST_CHECK_THROW(bucket_ids(&t, 1, Timedelta(timedelta_t(-5)), nullptr), elf_error);
+}
+
+BOOST_AUTO_TEST_CASE(bucket_run_lengths) {
+  // runs on either side of each gallop step and search window, ending on
+  // the last row or one short of it
+  const timedelta_t width = 60000000;
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    for(size_t len: { 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 100, 1000, 4095, 4096, 4097, 100000 }) {
+      for(size_t tail: { 0, 1, 20 }) {
+        std::vector<timestamp_t> ts;
+        for(size_t i = 0; i < len; ++i)
+          ts.push_back(i * (width - 1) / len);
+        for(size_t i = 0; i < tail; ++i)
+          ts.push_back(width + i);
+        std::vector<BucketRun> runs;
+        bucket_runs(ts.data(), ts.size(), Timedelta(width), runs);
+        BOOST_TEST_CONTEXT("simd " << int(level) << " len " << len << " tail " << tail) {
+          BOOST_TEST(runs.size() == (tail ? 2u : 1u));
+          BOOST_TEST(runs[0].end == len);
+        }
+      }
+    }
+  }
+  set_simd_level(detected);
+}
+
+BOOST_AUTO_TEST_CASE(bucket_runs_and_ohlcv) {
+  const std::vector<timestamp_t> ts = tick_times(5000, 18);
+  std::vector<double> price;
+  std::vector<int64_t> fixed_price, qty;
+  std::mt19937 rng(18);
+  for(size_t i = 0; i < ts.size(); ++i) {
+    fixed_price.push_back(1000000 + rng() % 5000);
+    price.push_back(fixed_price.back() / 100.0);
+    qty.push_back(1 + rng() % 500);
+  }
+
+  const Timedelta minute("00:01:00");
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    std::vector<BucketRun> runs = { { 0, 0, 0 } };
+    const size_t n_runs = bucket_runs(ts.data(), ts.size(), minute, runs);
+    BOOST_TEST(runs.size() == n_runs + 1);
+    runs.erase(runs.begin());
+
+    // every row in exactly one run, runs in order and non-empty
+    BOOST_TEST_CONTEXT("simd " << int(level)) {
+      BOOST_TEST(runs.front().begin == 0u);
+      BOOST_TEST(runs.back().end == ts.size());
+      for(size_t r = 0; r < runs.size(); ++r) {
+        BOOST_TEST_CONTEXT("run " << r) {
+          BOOST_TEST(runs[r].begin < runs[r].end);
+          if(r) {
+            BOOST_TEST(runs[r].begin == runs[r - 1].end);
+            BOOST_TEST(runs[r].start > runs[r - 1].start);
+          }
+          for(uint32_t i = runs[r].begin; i < runs[r].end; ++i) {
+            BOOST_TEST(ts[i] >= runs[r].start, "row " << i);
+            BOOST_TEST(ts[i] < runs[r].start + minute._td, "row " << i);
+          }
+        }
+      }
+    }
+
+    std::vector<OhlcvBar<int64_t>> bars(runs.size());
+    aggregate_ohlcv(runs.data(), runs.size(), fixed_price.data(), qty.data(), bars.data());
+    std::vector<OhlcvBar<double>> float_bars(runs.size());
+    aggregate_ohlcv(runs.data(), runs.size(), price.data(), static_cast<const double*>(nullptr), float_bars.data());
+    for(size_t r = 0; r < runs.size(); ++r) {
+      const auto begin = fixed_price.begin() + runs[r].begin, end = fixed_price.begin() + runs[r].end;
+      int64_t volume = 0;
+      for(uint32_t i = runs[r].begin; i < runs[r].end; ++i)
+        volume += qty[i];
+      BOOST_TEST_CONTEXT("simd " << int(level) << " bar " << r) {
+        BOOST_TEST(bars[r].start == runs[r].start);
+        BOOST_TEST(bars[r].open == *begin);
+        BOOST_TEST(bars[r].close == *(end - 1));
+        BOOST_TEST(bars[r].high == *std::max_element(begin, end));
+        BOOST_TEST(bars[r].low == *std::min_element(begin, end));
+        BOOST_TEST(bars[r].volume == volume);
+        BOOST_TEST(bars[r].count == runs[r].end - runs[r].begin);
+        BOOST_TEST(float_bars[r].high == bars[r].high / 100.0);
+        BOOST_TEST(float_bars[r].volume == 0.0);
+      }
+    }
+  }
+  set_simd_level(detected);
+
+  std::vector<BucketRun> runs;
+  BOOST_TEST(bucket_runs(nullptr, 0, minute, runs) == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
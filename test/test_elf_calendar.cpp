@@ -0,0 +1,224 @@
+#include "elf_calendar.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace elf;
+
+namespace {
+  // the day-by-day loops the calendar replaces
+  struct NaiveCalendar {
+    std::set<date_t> holidays;
+
+    bool is_trading_day(Date d) const {
+      const int32_t wd = d.weekday();
+      return wd != 0 && wd != 6 && !holidays.count(d.to_int());
+    }
+    Date next(Date d) const {
+      do d = d.add_days(1); while(!is_trading_day(d));
+      return d;
+    }
+    Date prev(Date d) const {
+      do d = d.add_days(-1); while(!is_trading_day(d));
+      return d;
+    }
+    int32_t count(Date from, Date to) const {
+      int32_t n = 0;
+      for(Date d = from; d.to_days() < to.to_days(); d = d.add_days(1))
+        n += is_trading_day(d);
+      return n;
+    }
+  };
+
+  std::string
+  temp_path(const char* name) {
+    return "/tmp/elf_calendar_" + std::to_string(::getpid()) + "_" + name;
+  }
+
+  const std::vector<date_t> us_holidays = {
+    20220117, 20220221, 20220415, 20220530, 20220620, 20220704, 20220905, 20221124, 20221226,
+    20230102, 20230116, 20230220, 20230407, 20230529, 20230619, 20230704, 20230904, 20231123, 20231225,
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(elf_calendar)
+
+BOOST_AUTO_TEST_CASE(calendar_arithmetic) {
+  const TradingCalendar cal(us_holidays, Date(20211201), Date(20240131));
+  const NaiveCalendar naive{ std::set<date_t>(us_holidays.begin(), us_holidays.end()) };
+
+  BOOST_TEST(cal.first() == 20211201);
+  BOOST_TEST(cal.last() == 20240131);
+  BOOST_TEST(!cal.is_trading_day(Date(20220704)));
+  BOOST_TEST(!cal.is_trading_day(Date(20220702)));
+  BOOST_TEST(cal.is_trading_day(Date(20220705)));
+  BOOST_TEST(cal.next(Date(20220701)) == 20220705);
+  BOOST_TEST(cal.prev(Date(20220705)) == 20220701);
+  BOOST_TEST(cal.add(Date(20220701), 1) == 20220705);
+  BOOST_TEST(cal.add(Date(20220702), -1) == 20220701);
+  BOOST_TEST(cal.add(Date(20220702), 0) == 20220702);
+  BOOST_TEST(cal.count(Date(20220101), Date(20230101)) == 251);
+  BOOST_TEST(cal.count(Date(20230101), Date(20220101)) == -251);
+
+  for(Date d(20211215); d.to_int() < 20240115; d = d.add_days(1)) {
+    BOOST_TEST_CONTEXT("date " << d.to_int()) {
+      BOOST_TEST(cal.is_trading_day(d) == naive.is_trading_day(d));
+      BOOST_TEST(cal.next(d).to_int() == naive.next(d).to_int());
+      BOOST_TEST(cal.prev(d).to_int() == naive.prev(d).to_int());
+    }
+  }
+  std::mt19937 rng(16);
+  for(int i = 0; i < 2000; ++i) {
+    const Date d = Date(20220101).add_days(rng() % 700);
+    const int32_t n = static_cast<int32_t>(rng() % 41) - 20;
+    Date expected = d;
+    for(int32_t k = 0; k < std::abs(n); ++k)
+      expected = n > 0 ? naive.next(expected) : naive.prev(expected);
+    BOOST_TEST(cal.add(d, n).to_int() == expected.to_int(), "add " << d.to_int() << " " << n);
+    const Date to = d.add_days(rng() % 60);
+    BOOST_TEST(cal.count(d, to) == naive.count(d, to), "count " << d.to_int() << " " << to.to_int());
+  }
+
+  // the last day is counted by ending at the day after it
+  BOOST_TEST(cal.count(Date(20240101), Date(20240201)) == naive.count(Date(20240101), Date(20240201)));
+  BOOST_TEST(cal.count(Date(20240201), Date(20231201)) == -naive.count(Date(20231201), Date(20240201)));
+  BOOST_CHECK_THROW(cal.count(Date(20240101), Date(20240202)), elf_error);
+
+  BOOST_CHECK_THROW(cal.next(Date(20240131)), elf_error);
+  BOOST_CHECK_THROW(cal.prev(Date(20211201)), elf_error);
+  BOOST_CHECK_THROW(cal.is_trading_day(Date(20250101)), elf_error);
+  BOOST_CHECK_THROW(cal.add(Date(20240125), 10), elf_error);
+  BOOST_CHECK_THROW(TradingCalendar({}, Date(20220102), Date(20220101)), elf_error);
+}
+
+BOOST_AUTO_TEST_CASE(calendar_select) {
+  // every rank, in full words and in words thinned by weekends and
+  // holidays, with pdep and with the byte search
+  const TradingCalendar every_day({}, Date(20220101), Date(20221231), 0);
+  const TradingCalendar us(us_holidays, Date(20211201), Date(20240131));
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    BOOST_TEST_CONTEXT("simd " << int(level)) {
+      const int32_t days = every_day.count(Date(20220101), Date(20230101));
+      BOOST_TEST(days == 365);
+      for(int32_t n = 1; n < days; ++n)
+        BOOST_TEST(every_day.add(Date(20220101), n) == Date(20220101).add_days(n).to_int(), "n " << n);
+      Date expected = Date(20211201);
+      for(int32_t n = 1; expected.to_int() != us.last().to_int(); ++n) {
+        expected = us.next(expected);
+        BOOST_TEST(us.add(Date(20211201), n) == expected.to_int(), "n " << n);
+      }
+    }
+  }
+  set_simd_level(detected);
+}
+
+BOOST_AUTO_TEST_CASE(calendar_files) {
+  const std::string holidays = temp_path("holidays.txt");
+  {
+    std::ofstream out(holidays);
+    out << "# US equities\n\n20220704 Independence Day\n  20221124\n20221226\r\n";
+  }
+  const TradingCalendar cal = TradingCalendar::from_holiday_file(holidays, Date(20220101), Date(20221231));
+  BOOST_TEST(!cal.is_trading_day(Date(20220704)));
+  BOOST_TEST(!cal.is_trading_day(Date(20221124)));
+  BOOST_TEST(!cal.is_trading_day(Date(20221226)));
+  BOOST_TEST(cal.is_trading_day(Date(20221125)));
+
+  // written once, mapped by any number of calendars sharing the pages
+  const std::string layout = temp_path("layout.bin");
+  cal.write(layout);
+  const TradingCalendar mapped = TradingCalendar::map(layout);
+  const TradingCalendar copy = mapped;
+  BOOST_TEST(mapped.first() == 20220101);
+  BOOST_TEST(mapped.last() == 20221231);
+  BOOST_TEST(copy.count(Date(20220101), Date(20221231)) == cal.count(Date(20220101), Date(20221231)));
+  BOOST_TEST(copy.next(Date(20220701)) == 20220705);
+
+  // rewriting a mapped layout replaces the file; the old mapping still reads
+  const TradingCalendar other(std::vector<date_t>{}, Date(20230101), Date(20231231));
+  other.write(layout);
+  BOOST_TEST(mapped.last() == 20221231);
+  BOOST_TEST(!mapped.is_trading_day(Date(20220704)));
+  BOOST_TEST(TradingCalendar::map(layout).first() == 20230101);
+
+  // the file gets the mode open() would give it
+  {
+    const mode_t mask = ::umask(027);
+    cal.write(layout);
+    ::umask(mask);
+    struct stat st;
+    BOOST_TEST(::stat(layout.c_str(), &st) == 0);
+    BOOST_TEST((st.st_mode & 0777) == 0640u);
+    other.write(layout);
+  }
+
+  // counts that disagree with the bitmap, and days set past the last
+  auto corrupt = [&](size_t at, uint8_t bits) {
+    std::string bytes;
+    {
+      std::ifstream in(layout, std::ios::binary);
+      bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    bytes[at] ^= bits;
+    const std::string bad = temp_path("corrupt.bin");
+    std::ofstream(bad, std::ios::binary | std::ios::trunc) << bytes;
+    bool threw = false;
+    try {
+      TradingCalendar::map(bad);
+    } catch(const elf_error&) {
+      threw = true;
+    }
+    std::remove(bad.c_str());
+    return threw;
+  };
+  // 2023 is 6 words from offset 24, then 7 counts from offset 72
+  BOOST_TEST(!corrupt(24, 0));
+  BOOST_TEST(corrupt(72, 1));
+  BOOST_TEST(corrupt(72 + 4 * 3, 1));
+  BOOST_TEST(corrupt(72 + 4 * 6, 0x80));
+  BOOST_TEST(corrupt(24 + 8 * 2, 0x10));
+  BOOST_TEST(corrupt(24 + 8 * 5 + 7, 0x80));
+
+  // a header claiming no days
+  {
+    std::string bytes;
+    {
+      std::ifstream in(layout, std::ios::binary);
+      bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    const uint32_t zero = 0;
+    memcpy(&bytes[16], &zero, sizeof(zero));
+    memcpy(&bytes[20], &zero, sizeof(zero));
+    std::ofstream(layout, std::ios::binary | std::ios::trunc) << bytes;
+  }
+  BOOST_CHECK_THROW(TradingCalendar::map(layout), elf_error);
+
+  {
+    std::ofstream out(holidays);
+    out << "20220704\n2022070\n";
+  }
+  BOOST_CHECK_THROW(TradingCalendar::from_holiday_file(holidays), elf_error);
+  {
+    std::ofstream out(layout, std::ios::trunc);
+    out << "not a calendar layout at all";
+  }
+  BOOST_CHECK_THROW(TradingCalendar::map(layout), elf_error);
+  BOOST_CHECK_THROW(TradingCalendar::map(temp_path("missing")), elf_error);
+  std::remove(holidays.c_str());
+  std::remove(layout.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+#include "elf_clock.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+using namespace elf;
+
+namespace {
+  // re-anchoring error allowed between a source and CLOCK_REALTIME
+  constexpr int64_t tolerance = 1000000;
+
+  int64_t
+  clock_nsec(clockid_t id) {
+    struct timespec ts;
+    ::clock_gettime(id, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  int64_t
+  realtime_nsec() {
+    return clock_nsec(CLOCK_REALTIME);
+  }
+
+  // sets TZ for the clock and the libc reference, restoring it on exit;
+  // an empty zone leaves TZ alone
+  struct ScopedTz {
+    explicit ScopedTz(const char* tz) : _set(*tz) {
+      if(!_set)
+        return;
+      const char* old = ::getenv("TZ");
+      _had_old = old != nullptr;
+      if(_had_old)
+        _old = old;
+      ::setenv("TZ", tz, 1);
+      ::tzset();
+    }
+
+    ~ScopedTz() {
+      if(!_set)
+        return;
+      if(_had_old)
+        ::setenv("TZ", _old.c_str(), 1);
+      else
+        ::unsetenv("TZ");
+      ::tzset();
+    }
+
+    bool _set;
+    bool _had_old = false;
+    std::string _old;
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(elf_clock)
+
+BOOST_AUTO_TEST_CASE(clock_sources) {
+  for(auto source: {ClockSource::realtime, ClockSource::monotonic_raw, ClockSource::tsc}) {
+    Clock clock(source);
+    BOOST_TEST_CONTEXT(to_string(source)) {
+      BOOST_TEST((clock.source() == source || source == ClockSource::tsc));
+
+      // within a millisecond of CLOCK_REALTIME
+      const int64_t before = realtime_nsec();
+      const int64_t nsec = clock.epoch_nsec();
+      const int64_t after = realtime_nsec();
+      BOOST_TEST(nsec > before - tolerance);
+      BOOST_TEST(nsec < after + tolerance);
+
+      // none of the sources is monotonic: realtime follows NTP steps and the
+      // others re-anchor to it, so only bound how far a reading goes back
+      int64_t prev = clock.epoch_nsec();
+      int64_t max_step_back = 0;
+      for(int i = 0; i < 100000; ++i) {
+        const int64_t cur = clock.epoch_nsec();
+        max_step_back = std::max(max_step_back, prev - cur);
+        prev = cur;
+      }
+      BOOST_TEST(max_step_back < tolerance);
+    }
+  }
+}
+
+#if defined(__x86_64__)
+BOOST_AUTO_TEST_CASE(clock_tsc_wall_clock_steps) {
+  Clock clock(ClockSource::tsc);
+  if(clock.source() != ClockSource::tsc)
+    return;
+
+  // the wall clock stepped back an hour since construction: readings follow
+  // the new anchor, at the pace of CLOCK_MONOTONIC_RAW
+  constexpr int64_t hour = 3600 * 1000000000LL;
+  const uint64_t tsc = __rdtsc();
+  clock.calibrate(tsc, clock_nsec(CLOCK_MONOTONIC_RAW), tsc, realtime_nsec() - hour);
+  const int64_t raw_before = clock_nsec(CLOCK_MONOTONIC_RAW);
+  const int64_t before = clock.epoch_nsec();
+  BOOST_TEST(before > realtime_nsec() - hour - tolerance);
+  BOOST_TEST(before < realtime_nsec() - hour + tolerance);
+  while(clock_nsec(CLOCK_MONOTONIC_RAW) < raw_before + 20000000)
+    ;
+  const int64_t raw_elapsed = clock_nsec(CLOCK_MONOTONIC_RAW) - raw_before;
+  BOOST_TEST(std::abs(clock.epoch_nsec() - before - raw_elapsed) < tolerance);
+
+  // a rate sample that doesn't advance keeps the last rate
+  clock.calibrate(0, 0, __rdtsc(), realtime_nsec());
+  BOOST_TEST((clock.source() == ClockSource::tsc));
+  const int64_t nsec = clock.epoch_nsec();
+  BOOST_TEST(nsec > realtime_nsec() - tolerance);
+  BOOST_TEST(nsec < realtime_nsec() + tolerance);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(clock_time_of_day) {
+  using namespace TimeConstants;
+
+  // the wall clock time in each zone, whether or not DST is in force
+  for(const char* tz: {"", "UTC0", "EST5EDT,M3.2.0,M11.1.0", "AEST-10AEDT,M10.1.0,M4.1.0/3", "<+0545>-5:45"}) {
+    ScopedTz scoped_tz(tz);
+    const time_t now = ::time(nullptr);
+    struct tm tm;
+    ::localtime_r(&now, &tm);
+    const timestamp_t expected = tm.tm_hour * ticks_per_hour + tm.tm_min * ticks_per_minute + tm.tm_sec * ticks_per_second;
+
+    for(auto source: {ClockSource::realtime, ClockSource::monotonic_raw, ClockSource::tsc}) {
+      // a fresh clock, as the rt_timestamp() ones cache the offset
+      const Timestamp ts = *tz ? Clock(source).now() : rt_timestamp(source);
+      BOOST_TEST_CONTEXT("TZ=" << tz << ", " << to_string(source)) {
+        BOOST_TEST(ts.get() < ticks_per_day);
+        // allow for a second boundary between the two reads, and midnight
+        BOOST_TEST((ts.get() + ticks_per_day - expected) % ticks_per_day < 2 * ticks_per_second);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+#include "elf_csv.h"
+#include "elf_exception.h"
+#include "elf_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace elf;
+
+namespace {
+  std::string
+  temp_path(const char* name) {
+    return "/tmp/elf_csv_" + std::to_string(::getpid()) + "_" + name;
+  }
+
+  void
+  write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+  }
+
+  // date,time,symbol,qty,price,note with some bad, short, long, blank and
+  // CRLF rows; notes run past a 64-byte block
+  std::string
+  quotes_text(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::ostringstream out;
+    for(size_t i = 0; i < n; ++i) {
+      const unsigned kind = rng() % 20;
+      if(kind == 0) {
+        out << (rng() % 2 ? "\n" : "\r\n");
+        continue;
+      }
+      out << (kind == 1 ? "2022020x" : "20220203") << ','
+          << (kind == 2 ? "9:30" : "09:" + std::to_string(30 + rng() % 30) + ":0" + std::to_string(rng() % 10) + "." + std::to_string(100000 + rng() % 900000)) << ','
+          << "SYM" << rng() % 100;
+      if(kind == 3) {
+        out << '\n';
+        continue;
+      }
+      out << ',' << (kind == 4 ? "12a" : std::to_string(int64_t(rng() % 10000) - 5000))
+          << ',' << (kind == 5 ? "" : std::to_string(rng() % 100000) + "." + std::to_string(rng() % 100))
+          << ',' << std::string(rng() % 90, 'x');
+      out << (kind == 6 ? "\r\n" : "\n");
+    }
+    return out.str();
+  }
+
+  struct Expected {
+    std::vector<timestamp_t> ts;
+    std::vector<date_t> dates;
+    std::vector<int64_t> qty;
+    std::vector<double> price;
+    // per row, bit per column as in the reader: date, time, qty, price
+    std::vector<unsigned> bad;
+  };
+
+  Expected
+  expected(const std::string& text) {
+    Expected e;
+    std::istringstream in(text);
+    std::string line;
+    while(std::getline(in, line)) {
+      if(!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if(line.empty())
+        continue;
+      std::vector<std::string> fields;
+      std::istringstream split(line);
+      std::string field;
+      while(std::getline(split, field, ','))
+        fields.push_back(field);
+      if(line.back() == ',')
+        fields.push_back("");
+      unsigned bad = 0;
+      const auto get = [&](size_t i) { return i < fields.size() ? fields[i] : std::string("\x01"); };
+      const auto date = Date::try_parse(get(0));
+      e.dates.push_back(date ? date.value._d : 0);
+      bad |= !date << 0;
+      const auto ts = Timestamp::try_parse(get(1));
+      e.ts.push_back(ts ? ts.value._ts : 0);
+      bad |= !ts << 1;
+      int64_t q = 0;
+      const std::string qty = get(3);
+      const bool q_ok = substring_atoi(qty.data(), qty.size(), q);
+      e.qty.push_back(q_ok ? q : 0);
+      bad |= !q_ok << 2;
+      double p = 0;
+      const std::string price = get(4);
+      const bool p_ok = substring_atod(price.data(), price.size(), p);
+      e.price.push_back(p_ok ? p : 0);
+      bad |= !p_ok << 3;
+      e.bad.push_back(bad);
+    }
+    return e;
+  }
+
+  const std::vector<CsvColumn> quote_columns = {
+    { 0, ColumnType::date }, { 1, ColumnType::timestamp }, { 3, ColumnType::int64 }, { 4, ColumnType::float64 },
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(elf_csv)
+
+BOOST_AUTO_TEST_CASE(read_columns) {
+  const std::string path = temp_path("quotes.csv");
+  std::string text = quotes_text(3000, 5);
+  // and a last row without its newline
+  text += "20220204,10:00:00.000001,SYM1,7,1.5";
+  write_file(path, text);
+  const Expected e = expected(text);
+
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    for(size_t chunk_rows: { size_t(1), size_t(7), size_t(64), size_t(1000), size_t(100000) }) {
+      CsvOptions options;
+      options.chunk_rows = chunk_rows;
+      CsvReader reader(path, quote_columns, options);
+      CsvChunk chunk;
+      size_t row = 0;
+      BOOST_TEST_CONTEXT("simd " << int(level) << " chunk_rows " << chunk_rows) {
+        while(reader.next(chunk)) {
+          BOOST_TEST(chunk.first_row() == row);
+          BOOST_TEST(chunk.rows() <= chunk_rows);
+          const date_t* dates = chunk.column<date_t>(0);
+          const timestamp_t* ts = chunk.column<timestamp_t>(1);
+          const int64_t* qty = chunk.column<int64_t>(2);
+          const double* price = chunk.column<double>(3);
+          for(size_t i = 0; i < chunk.rows() && row + i < e.bad.size(); ++i) {
+            const size_t r = row + i;
+            BOOST_TEST_CONTEXT("row " << r) {
+              BOOST_TEST(dates[i] == e.dates[r]);
+              BOOST_TEST(ts[i] == e.ts[r]);
+              BOOST_TEST(qty[i] == e.qty[r]);
+              BOOST_TEST(price[i] == e.price[r]);
+              for(size_t col = 0; col < 4; ++col)
+                BOOST_TEST(((chunk.bad(col)[i / 64] >> (i % 64)) & 1) == ((e.bad[r] >> col) & 1), "bad column " << col);
+            }
+          }
+          row += chunk.rows();
+        }
+        BOOST_TEST(row == e.bad.size());
+        BOOST_TEST(!reader.next(chunk));
+      }
+    }
+  }
+  set_simd_level(detected);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(read_options) {
+  const std::string path = temp_path("options.csv");
+  write_file(path, "price|when\n1.25|09:30:00\n\n2.5|bad|extra\n|10:00:00.500\n");
+  CsvOptions options;
+  options.delim = '|';
+  options.header = true;
+  options.huge_pages = true;
+  CsvReader reader(path, { { 1, ColumnType::timestamp }, { 0, ColumnType::float64 } }, options);
+  CsvChunk chunk;
+  BOOST_TEST(reader.next(chunk));
+  BOOST_TEST(chunk.rows() == 3u);
+  BOOST_TEST(chunk.columns() == 2u);
+  BOOST_TEST((chunk.type(0) == ColumnType::timestamp));
+  const timestamp_t* ts = chunk.column<timestamp_t>(0);
+  const double* price = chunk.column<double>(1);
+  BOOST_TEST(ts[0] == Timestamp("09:30:00").get());
+  BOOST_TEST(ts[1] == 0u);
+  BOOST_TEST(ts[2] == Timestamp("10:00:00.500000").get());
+  BOOST_TEST(price[0] == 1.25);
+  BOOST_TEST(price[1] == 2.5);
+  BOOST_TEST(price[2] == 0.0);
+  BOOST_TEST(chunk.bad(0)[0] == 0x2u);
+  BOOST_TEST(chunk.bad(1)[0] == 0x4u);
+  BOOST_TEST(chunk.bad_count(0) == 1u);
+  BOOST_CHECK_THROW(chunk.column<double>(0), elf_error);
+  BOOST_TEST(!reader.next(chunk));
+  BOOST_TEST(chunk.rows() == 0u);
+
+  write_file(path, "");
+  CsvReader empty(path, { { 0, ColumnType::int64 } });
+  BOOST_TEST(!empty.next(chunk));
+
+  // rows are counted even with no columns requested
+  write_file(path, "a,b\nc\n\nd,e,f");
+  CsvReader count(path, {});
+  BOOST_TEST(count.next(chunk));
+  BOOST_TEST(chunk.rows() == 3u);
+
+  BOOST_CHECK_THROW(CsvReader(path, { { 0, ColumnType::int64 }, { 0, ColumnType::date } }), elf_error);
+  // fields are checked against the first row, not trusted to size the lookup
+  BOOST_CHECK_NO_THROW(CsvReader(path, { { 1, ColumnType::int64 } }));
+  BOOST_CHECK_THROW(CsvReader(path, { { 2, ColumnType::int64 } }), elf_error);
+  BOOST_CHECK_THROW(CsvReader(path, { { 0xffffffff, ColumnType::int64 } }), elf_error);
+  options.chunk_rows = 0;
+  BOOST_CHECK_THROW(CsvReader(path, { { 0, ColumnType::int64 } }, options), elf_error);
+  BOOST_CHECK_THROW(CsvReader(temp_path("missing"), { { 0, ColumnType::int64 } }), elf_error);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,251 @@
+#include "elf_datetime.h"
+#include "elf_exception.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace elf;
+
+namespace {
+  // sets TZ for the libc reference conversions, restoring it on exit
+  struct ScopedTz {
+    explicit ScopedTz(const char* tz) {
+      const char* old = ::getenv("TZ");
+      _had_old = old != nullptr;
+      if(_had_old)
+        _old = old;
+      ::setenv("TZ", tz, 1);
+      ::tzset();
+    }
+
+    ~ScopedTz() {
+      if(_had_old)
+        ::setenv("TZ", _old.c_str(), 1);
+      else
+        ::unsetenv("TZ");
+      ::tzset();
+    }
+
+    bool _had_old;
+    std::string _old;
+  };
+
+  constexpr timestamp_t tps = TimeConstants::ticks_per_second;
+
+  std::string
+  temp_path(const char* name) {
+    return "/tmp/elf_datetime_" + std::to_string(::getpid()) + "_" + name;
+  }
+
+  void
+  write_file(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+  }
+
+  void
+  put_be(std::string& out, uint64_t v, int n) {
+    for(int i = n - 1; i >= 0; --i)
+      out += static_cast<char>(v >> (8 * i));
+  }
+
+  // TZif v1/v2 header with the six counts in file order: isutcnt, isstdcnt,
+  // leapcnt, timecnt, typecnt, charcnt
+  void
+  put_tzif_header(std::string& out, std::initializer_list<uint32_t> counts) {
+    out += "TZif2";
+    out.append(15, '\0');
+    for(uint32_t count: counts)
+      put_be(out, count, 4);
+  }
+
+  // a version 2 TZif file starting on UTC and moving to each offset at its
+  // time; the v1 block holds only the UTC type
+  std::string
+  tzif_text(const std::vector<std::pair<int64_t, int32_t>>& transitions) {
+    std::string out;
+    put_tzif_header(out, { 0, 0, 0, 0, 1, 1 });
+    out.append(7, '\0');
+
+    const uint32_t n = transitions.size();
+    put_tzif_header(out, { 0, 0, 0, n, n + 1, 1 });
+    for(auto& [when, offset]: transitions)
+      put_be(out, when, 8);
+    for(uint32_t i = 0; i < n; ++i)
+      out += static_cast<char>(i + 1);
+    out.append(6, '\0');
+    for(auto& [when, offset]: transitions) {
+      put_be(out, static_cast<uint32_t>(offset), 4);
+      out.append(2, '\0');
+    }
+    out += '\0';
+    return out + "\n\n";
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(elf_datetime)
+
+BOOST_AUTO_TEST_CASE(datetime_fields) {
+  const DateTime t(Date(20220203), Timestamp("10:45:28.093817"));
+  BOOST_TEST(t.get() == DateTime::from_go_ts("20220203-104528.093817").get());
+  BOOST_TEST(t.date() == 20220203);
+  BOOST_TEST(t.time().get() == Timestamp("10:45:28.093817").get());
+  BOOST_TEST(t.days() == Date(20220203).to_days());
+  BOOST_TEST(t.str() == "20220203-104528.093817");
+  BOOST_TEST(fmt::format("{}", DateTime()) == "19700101-000000.000000");
+  BOOST_TEST(((t + Timedelta("14hour")).date() == 20220204));
+  BOOST_TEST(timedelta_t((t + Timedelta("1hour")) - t) == timedelta_t(Timedelta("1hour")));
+}
+
+BOOST_AUTO_TEST_CASE(timezone_against_libc) {
+  std::mt19937_64 rng(15);
+  const int64_t end = days_from_civil(2100, 1, 1) * 86400LL;
+  for(const char* name: {"America/New_York", "Europe/London", "Australia/Sydney", "Asia/Kolkata",
+                         "America/Sao_Paulo", "Pacific/Apia", "Asia/Tehran", "Europe/Moscow"}) {
+    const TimeZone& zone = TimeZone::get(name);
+    ScopedTz tz(name);
+    for(int i = 0; i < 20000; ++i) {
+      const time_t utc = rng() % end;
+      struct tm tm;
+      ::localtime_r(&utc, &tm);
+      const DateTime local = zone.to_local(DateTime(utc * tps));
+      BOOST_TEST(zone.utc_offset(DateTime(utc * tps)) == tm.tm_gmtoff, name << " utc " << utc);
+      BOOST_TEST(local.get() == static_cast<timestamp_t>(utc + tm.tm_gmtoff) * tps, name << " utc " << utc);
+      // times away from a transition round trip
+      const time_t hour_later = utc + 3600, hour_earlier = utc - 3600;
+      struct tm later, earlier;
+      ::localtime_r(&hour_later, &later);
+      ::localtime_r(&hour_earlier, &earlier);
+      if(later.tm_gmtoff == tm.tm_gmtoff && earlier.tm_gmtoff == tm.tm_gmtoff)
+        BOOST_TEST(zone.to_utc(local).get() == static_cast<timestamp_t>(utc) * tps, name << " local " << local.str());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(timezone_transitions) {
+  const TimeZone& ny = TimeZone::get("America/New_York");
+  // 2022-03-13 02:00 EST -> 03:00 EDT; 2022-11-06 02:00 EDT -> 01:00 EST
+  const DateTime spring(Date(20220313), Timestamp("07:00:00"));
+  BOOST_TEST(ny.utc_offset(spring - Timedelta("1usec")) == -5 * 3600);
+  BOOST_TEST(ny.utc_offset(spring) == -4 * 3600);
+  BOOST_TEST(ny.to_local(spring).str() == "20220313-030000.000000");
+  BOOST_TEST(ny.to_utc(Date(20220313), Timestamp("01:59:59")).str() == "20220313-065959.000000");
+  BOOST_TEST(ny.to_utc(Date(20220313), Timestamp("03:00:00")).str() == "20220313-070000.000000");
+  // 02:00-03:00 never happens; it is read on EST, the clock before the jump
+  BOOST_TEST(ny.to_utc(Date(20220313), Timestamp("02:00:00")).str() == "20220313-070000.000000");
+  BOOST_TEST(ny.to_utc(Date(20220313), Timestamp("02:30:00")).str() == "20220313-073000.000000");
+  BOOST_TEST(ny.to_utc(Date(20220313), Timestamp("02:59:59")).str() == "20220313-075959.000000");
+  // 01:30 happens twice on 2022-11-06; the first, EDT, one is chosen
+  BOOST_TEST(ny.to_utc(Date(20221106), Timestamp("01:30:00")).str() == "20221106-053000.000000");
+  BOOST_TEST(ny.to_utc(Date(20221106), Timestamp("02:00:00")).str() == "20221106-070000.000000");
+
+  // past the table, from the footer rule
+  BOOST_TEST(ny.utc_offset(DateTime(Date(21500701), Timestamp("12:00:00"))) == -4 * 3600);
+  BOOST_TEST(ny.utc_offset(DateTime(Date(21501201), Timestamp("12:00:00"))) == -5 * 3600);
+  BOOST_TEST(ny.to_utc(Date(21500308), Timestamp("02:30:00")).str() == "21500308-073000.000000");
+  BOOST_TEST(ny.to_utc(Date(21500308), Timestamp("03:00:00")).str() == "21500308-070000.000000");
+
+  // bulk forms agree with the scalar ones, in place
+  std::vector<timestamp_t> ts;
+  for(timestamp_t t = spring.get() - 86400 * tps; t < spring.get() + 86400 * tps; t += 600 * tps)
+    ts.push_back(t);
+  std::vector<timestamp_t> local(ts.size());
+  ny.to_local(ts.data(), ts.size(), local.data());
+  for(size_t i = 0; i < ts.size(); ++i)
+    BOOST_TEST(local[i] == ny.to_local(DateTime(ts[i])).get(), "utc " << DateTime(ts[i]).str());
+  std::vector<timestamp_t> utc = local;
+  ny.to_utc(utc.data(), utc.size(), utc.data());
+  for(size_t i = 0; i < ts.size(); ++i)
+    BOOST_TEST(utc[i] == ny.to_utc(DateTime(local[i])).get(), "local " << DateTime(local[i]).str());
+}
+
+BOOST_AUTO_TEST_CASE(timezone_epoch) {
+  // west of UTC the epoch has no local time, east of it no UTC one
+  const TimeZone& ny = TimeZone::get("America/New_York");
+  BOOST_CHECK_THROW(ny.to_local(DateTime()), elf_error);
+  BOOST_TEST(ny.to_local(DateTime(5 * 3600 * tps)).get() == 0u);
+  BOOST_TEST(ny.to_utc(DateTime()).get() == 5 * 3600 * tps);
+  timestamp_t t = 0;
+  BOOST_CHECK_THROW(ny.to_local(&t, 1, &t), elf_error);
+
+  const TimeZone& tokyo = TimeZone::get("Asia/Tokyo");
+  BOOST_CHECK_THROW(tokyo.to_utc(DateTime()), elf_error);
+  BOOST_CHECK_THROW(tokyo.to_utc(DateTime(9 * 3600 * tps - 1)), elf_error);
+  BOOST_TEST(tokyo.to_utc(DateTime(9 * 3600 * tps)).get() == 0u);
+  BOOST_TEST(tokyo.to_local(DateTime()).get() == 9 * 3600 * tps);
+  BOOST_CHECK_THROW(tokyo.to_utc(&t, 1, &t), elf_error);
+}
+
+BOOST_AUTO_TEST_CASE(timezone_rules) {
+  const TimeZone utc("UTC");
+  BOOST_TEST(utc.utc_offset(DateTime(123456789 * tps)) == 0);
+
+  const TimeZone posix("EST5EDT,M3.2.0,M11.1.0");
+  BOOST_TEST(posix.utc_offset(DateTime(Date(20220701), Timestamp("12:00:00"))) == -4 * 3600);
+  BOOST_TEST(posix.utc_offset(DateTime(Date(20220101), Timestamp("12:00:00"))) == -5 * 3600);
+
+  const TimeZone kolkata("<+0530>-5:30");
+  BOOST_TEST(kolkata.utc_offset(DateTime()) == 5 * 3600 + 1800);
+
+  BOOST_CHECK_THROW(TimeZone("Nowhere/Atlantis"), elf_error);
+  BOOST_CHECK_THROW(TimeZone("/etc/hostname"), elf_error);
+  BOOST_TEST(&TimeZone::get("Europe/London") == &TimeZone::get("Europe/London"));
+}
+
+BOOST_AUTO_TEST_CASE(timezone_tzif_times) {
+  // 64-bit transition times before 1970, as every real zone has
+  const std::string path = temp_path("pre_epoch.tzif");
+  write_file(path, tzif_text({ { INT64_C(-2000000000), 3600 }, { -86400, 7200 }, { 365 * 86400, 3600 } }));
+  const TimeZone zone(path);
+  BOOST_TEST(zone.utc_offset(DateTime()) == 7200);
+  BOOST_TEST(zone.utc_offset(DateTime(Date(19710102), Timestamp("00:00:00"))) == 3600);
+  ::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(timezone_tzif_corrupt) {
+  const std::string path = temp_path("corrupt.tzif");
+  const std::string good = tzif_text({ { -86400, 7200 }, { 365 * 86400, 3600 } });
+  auto loads = [&](const std::string& text) {
+    write_file(path, text);
+    try {
+      TimeZone zone(path);
+      return true;
+    } catch(const elf_error&) {
+      return false;
+    }
+  };
+  // the v2 header starts after the 44-byte v1 header and its 7-byte body
+  auto with_count = [&](size_t header, size_t field, uint32_t count) {
+    std::string text = good;
+    std::string be;
+    put_be(be, count, 4);
+    text.replace(header + 20 + 4 * field, 4, be);
+    return text;
+  };
+
+  BOOST_TEST(loads(good));
+  BOOST_TEST(!loads(good.substr(0, 30)));
+  BOOST_TEST(!loads(good.substr(0, 60)));
+  BOOST_TEST(!loads(good.substr(0, good.size() - 8)));
+  for(size_t header: { size_t(0), size_t(51) }) {
+    BOOST_TEST(!loads(with_count(header, 3, 0xffffffff)), "header " << header);
+    BOOST_TEST(!loads(with_count(header, 2, 0x80000000)), "header " << header);
+    BOOST_TEST(!loads(with_count(header, 4, 0)), "header " << header);
+    BOOST_TEST(!loads(with_count(header, 4, 257)), "header " << header);
+    BOOST_TEST(!loads(with_count(header, 0, 2)), "header " << header);
+    BOOST_TEST(!loads(with_count(header, 5, 0xffffffff)), "header " << header);
+  }
+  ::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,56 @@
+#include "elf_exception.h"
+#include "elf_time.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace elf;
+
+BOOST_AUTO_TEST_SUITE(elf_exception)
+
+BOOST_AUTO_TEST_CASE(error_text) {
+  const elf_error e(ErrorCode::bad_format, "trading_calendar: bad holiday", "path={} line={}", "h.txt", 3);
+  BOOST_TEST(std::string(e.what()) == "trading_calendar: bad holiday path=h.txt line=3");
+  BOOST_TEST(std::string(e.message()) == "trading_calendar: bad holiday");
+  BOOST_TEST((e.code() == ErrorCode::bad_format));
+
+  const elf_error plain(ErrorCode::out_of_bounds, "timestamp_convert: out of bounds");
+  BOOST_TEST(std::string(plain.what()) == "timestamp_convert: out of bounds");
+  const elf_error legacy(std::string("bucket: interval must be positive interval=0usec"));
+  BOOST_TEST(std::string(legacy.what()) == "bucket: interval must be positive interval=0usec");
+  BOOST_TEST((legacy.code() == ErrorCode::unspecified));
+
+  // copies are flat and keep the text
+  const elf_error copy = e;
+  BOOST_TEST(std::string(copy.what()) == e.what());
+  BOOST_TEST(copy.message() == e.message());
+
+  // long context is truncated to the inline buffer
+  const std::string input(1000, 'x');
+  const elf_error long_error(ErrorCode::bad_format, "timedelta_convert: unhandled format:", "{}", input);
+  BOOST_TEST(std::strlen(long_error.what()) == elf_error::max_what_len);
+  BOOST_TEST(std::string(long_error.what()).rfind("timedelta_convert: unhandled format: xxx", 0) == 0u);
+  const elf_error long_legacy(input);
+  BOOST_TEST(std::strlen(long_legacy.what()) == elf_error::max_what_len);
+}
+
+BOOST_AUTO_TEST_CASE(error_is_std_exception) {
+  try {
+    Timestamp().convert("09:3x:00");
+    BOOST_FAIL("no throw");
+  } catch(const std::exception& e) {
+    BOOST_TEST(std::string(e.what()) == "timestamp_convert: unhandled format: 09:3x:00");
+  }
+  try {
+    Date(20220230);
+    BOOST_FAIL("no throw");
+  } catch(const elf_error& e) {
+    BOOST_TEST(std::string(e.what()) == "date::from_string: invalid date input=20220230");
+    BOOST_TEST((e.code() == ErrorCode::out_of_bounds));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+#include "elf_parallel.h"
+#include "elf_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace elf;
+
+namespace {
+  // offset-indexed fields, one in ten malformed
+  struct Column {
+    std::string buf;
+    std::vector<uint32_t> offsets{0};
+
+    void add(const std::string& field) {
+      buf += field;
+      offsets.push_back(buf.size());
+    }
+  };
+
+  template <typename Make>
+  Column
+  column(size_t n, uint32_t seed, Make make) {
+    std::mt19937 rng(seed);
+    Column c;
+    for(size_t i = 0; i < n; ++i)
+      c.add(rng() % 10 == 0 ? std::string("x") + std::to_string(rng() % 100) : make(rng));
+    return c;
+  }
+
+  // the executor path matches the single-threaded one word for word;
+  // returns the serial bad count
+  template <typename T, typename Serial, typename Parallel>
+  size_t
+  check_same_as_serial(const Column& c, Serial serial, Parallel parallel, Executor& executor) {
+    const size_t n = c.offsets.size() - 1;
+    std::vector<T> out1(n), out2(n, T(1));
+    std::vector<uint64_t> bad1((n + 63) / 64), bad2((n + 63) / 64, ~uint64_t(0));
+    const size_t n_bad1 = serial(c.buf.data(), c.offsets.data(), n, out1.data(), bad1.data());
+    const size_t n_bad2 = parallel(c.buf.data(), c.offsets.data(), n, out2.data(), bad2.data(), executor);
+    BOOST_TEST(n_bad1 == n_bad2);
+    BOOST_TEST(out1 == out2, boost::test_tools::per_element());
+    BOOST_TEST(bad1 == bad2, boost::test_tools::per_element());
+    return n_bad1;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(elf_parallel)
+
+BOOST_AUTO_TEST_CASE(executor_runs_every_chunk_once) {
+  for(unsigned threads: { 1u, 2u, 5u }) {
+    Executor executor(threads);
+    BOOST_TEST(executor.threads() == threads);
+    for(size_t n_chunks: { size_t(0), size_t(1), size_t(3), size_t(1000) }) {
+      std::vector<std::atomic<int>> runs(n_chunks);
+      executor.run(n_chunks, [&](size_t c) { ++runs[c]; });
+      for(size_t c = 0; c < n_chunks; ++c)
+        BOOST_TEST(runs[c] == 1, threads << " threads, chunk " << c << " of " << n_chunks);
+    }
+  }
+  BOOST_TEST(Executor().threads() >= 1u);
+}
+
+BOOST_AUTO_TEST_CASE(convert_matches_serial) {
+  const Column ts = column(20000, 1, [](std::mt19937& rng) {
+    char buf[Timestamp::max_str_len];
+    return std::string(buf, Timestamp(rng() % TimeConstants::ticks_per_day).format_to(buf, rng() % 2));
+  });
+  const Column dates = column(20000, 2, [](std::mt19937& rng) { return Date(20220101).add_days(rng() % 1000).to_string(); });
+  const Column tds = column(20000, 3, [](std::mt19937& rng) { return std::to_string(rng() % 1000) + "msec"; });
+  const Column ints = column(20000, 4, [](std::mt19937& rng) { return std::to_string(int64_t(rng()) - (1 << 30)); });
+  const Column doubles = column(20000, 5, [](std::mt19937& rng) { return std::to_string(rng() % 100000) + "." + std::to_string(rng() % 1000); });
+
+  using TsSerial = size_t (*)(const char*, const uint32_t*, size_t, timestamp_t*, uint64_t*);
+  using TsParallel = size_t (*)(const char*, const uint32_t*, size_t, timestamp_t*, uint64_t*, Executor&);
+  using DateSerial = size_t (*)(const char*, const uint32_t*, size_t, date_t*, uint64_t*);
+  using DateParallel = size_t (*)(const char*, const uint32_t*, size_t, date_t*, uint64_t*, Executor&);
+  using TdSerial = size_t (*)(const char*, const uint32_t*, size_t, timedelta_t*, uint64_t*);
+  using TdParallel = size_t (*)(const char*, const uint32_t*, size_t, timedelta_t*, uint64_t*, Executor&);
+  using IntSerial = size_t (*)(const char*, const uint32_t*, size_t, int64_t*, uint64_t*);
+  using IntParallel = size_t (*)(const char*, const uint32_t*, size_t, int64_t*, uint64_t*, Executor&);
+  using DoubleSerial = size_t (*)(const char*, const uint32_t*, size_t, double*, uint64_t*);
+  using DoubleParallel = size_t (*)(const char*, const uint32_t*, size_t, double*, uint64_t*, Executor&);
+
+  // about one row in ten is malformed; the rest must parse, or the
+  // comparison below would only cover the bad-row path
+  const size_t n_rows = ts.offsets.size() - 1;
+  auto mostly_good = [n_rows](size_t n_bad) { return n_bad > n_rows / 20 && n_bad < n_rows / 5; };
+
+  for(unsigned threads: { 1u, 3u, 8u }) {
+    Executor executor(threads);
+    BOOST_TEST_CONTEXT(threads << " threads") {
+      BOOST_TEST_CONTEXT("timestamps")
+        BOOST_TEST(mostly_good(check_same_as_serial<timestamp_t>(ts, TsSerial(convert_timestamps), TsParallel(convert_timestamps), executor)));
+      BOOST_TEST_CONTEXT("dates")
+        BOOST_TEST(mostly_good(check_same_as_serial<date_t>(dates, DateSerial(convert_dates), DateParallel(convert_dates), executor)));
+      BOOST_TEST_CONTEXT("timedeltas")
+        BOOST_TEST(mostly_good(check_same_as_serial<timedelta_t>(tds, TdSerial(convert_timedeltas), TdParallel(convert_timedeltas), executor)));
+      BOOST_TEST_CONTEXT("integers")
+        BOOST_TEST(mostly_good(check_same_as_serial<int64_t>(ints, IntSerial(convert_integers), IntParallel(convert_integers), executor)));
+      BOOST_TEST_CONTEXT("doubles")
+        BOOST_TEST(mostly_good(check_same_as_serial<double>(doubles, DoubleSerial(convert_doubles), DoubleParallel(convert_doubles), executor)));
+    }
+
+    // sizes around a word and a chunk
+    for(size_t count: { size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(4097) }) {
+      Column head;
+      for(size_t i = 0; i < count; ++i)
+        head.add(ints.buf.substr(ints.offsets[i], ints.offsets[i + 1] - ints.offsets[i]));
+      BOOST_TEST_CONTEXT(threads << " threads, " << count << " rows")
+        check_same_as_serial<int64_t>(head, IntSerial(convert_integers), IntParallel(convert_integers), executor);
+    }
+
+    // fixed-width rows
+    const size_t n = 10000, stride = 16;
+    std::string rows(n * stride, ' ');
+    std::mt19937 rng(6);
+    for(size_t i = 0; i < n; ++i)
+      Timestamp(rng() % TimeConstants::ticks_per_day).format_to(&rows[i * stride]);
+    rows[17 * stride] = 'x';
+    std::vector<timestamp_t> out1(n), out2(n);
+    std::vector<uint64_t> bad1((n + 63) / 64), bad2((n + 63) / 64);
+    const size_t n_bad1 = convert_timestamps(rows.data(), 15, stride, n, out1.data(), bad1.data());
+    const size_t n_bad2 = convert_timestamps(rows.data(), 15, stride, n, out2.data(), bad2.data(), executor);
+    BOOST_TEST(n_bad1 == 1u);
+    BOOST_TEST(n_bad2 == n_bad1);
+    BOOST_TEST(out1 == out2, boost::test_tools::per_element());
+    BOOST_TEST(bad1 == bad2, boost::test_tools::per_element());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(convert_integers_bulk) {
+  // fields "12", "-7", "1x", "", " 3"
+  const std::string buf = "12-71x 3";
+  const uint32_t offsets[] = { 0, 2, 4, 6, 6, 8 };
+  int64_t out[5];
+  uint64_t bad[1];
+  BOOST_TEST(convert_integers(buf.data(), offsets, 5, out, bad) == 2u);
+  BOOST_TEST(bad[0] == 0b01100u);
+  BOOST_TEST(out[0] == 12);
+  BOOST_TEST(out[1] == -7);
+  BOOST_TEST(out[2] == 0);
+  BOOST_TEST(out[4] == 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
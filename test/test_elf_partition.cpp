@@ -0,0 +1,125 @@
+#include "elf_partition.h"
+#include "elf_exception.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace elf;
+namespace fs = std::filesystem;
+
+namespace {
+  struct TempTree {
+    TempTree() {
+      root = fs::temp_directory_path() / ("elf_partition_test." + std::to_string(::getpid()));
+      fs::remove_all(root);
+      fs::create_directories(root);
+    }
+    ~TempTree() { fs::remove_all(root); }
+
+    void touch(const std::string& rel) {
+      fs::create_directories((root / rel).parent_path());
+      std::ofstream(root / rel).put('\n');
+    }
+
+    fs::path root;
+  };
+
+  std::vector<std::string>
+  paths(const DatePartitionIndex::Range& range) {
+    std::vector<std::string> out;
+    for(auto& e: range)
+      out.push_back(e.path);
+    return out;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(elf_partition)
+
+BOOST_AUTO_TEST_CASE(test_find_date_in_name) {
+  BOOST_TEST(elf::find_date_in_name("quotes.20210303.csv") == 20210303);
+  BOOST_TEST(elf::find_date_in_name("20210302/quotes.20210303.csv") == 20210303);
+  BOOST_TEST(elf::find_date_in_name("20210302/quotes.csv") == 20210302);
+  BOOST_TEST(elf::find_date_in_name("20210302/quotes.20210303093000.csv") == 20210302);
+  BOOST_TEST(elf::find_date_in_name("20210303") == 20210303);
+  BOOST_TEST(elf::find_date_in_name("v2.1234567.csv") == INVALID_DATE);
+  BOOST_TEST(elf::find_date_in_name("") == INVALID_DATE);
+}
+
+BOOST_AUTO_TEST_CASE(date_partition_index) {
+  TempTree tree;
+  tree.touch("quotes.20210104.csv");
+  tree.touch("quotes.20210105.csv");
+  tree.touch("trades.20210104.csv");
+  tree.touch("README");
+  tree.touch("bad.20211332.csv");
+  tree.touch("2021/20210601/trades.csv");
+  tree.touch("2021/20210601/quotes.csv");
+  tree.touch("2022/quotes.20220103.csv");
+
+  DatePartitionIndex index(tree.root.string());
+  BOOST_TEST(index.size() == 6u);
+  BOOST_TEST(index.first_date() == 20210104);
+  BOOST_TEST(index.last_date() == 20220103);
+
+  std::vector<std::string> expected{"quotes.20210104.csv", "trades.20210104.csv"};
+  BOOST_TEST(paths(index.files(20210104)) == expected, boost::test_tools::per_element());
+  expected = {"quotes.20210104.csv", "trades.20210104.csv", "quotes.20210105.csv",
+              "2021/20210601/quotes.csv", "2021/20210601/trades.csv"};
+  BOOST_TEST(paths(index.files(20210101, 20211231)) == expected, boost::test_tools::per_element());
+  BOOST_TEST(index.files(20210106, 20210531).empty());
+  BOOST_TEST(index.files(20211231, 20210101).empty());
+
+  // a refresh that finds nothing changed leaves ranges valid
+  const DatePartitionIndex::Range held = index.files(20210104);
+  BOOST_TEST(!index.refresh());
+  BOOST_TEST(paths(held) == (std::vector<std::string>{"quotes.20210104.csv", "trades.20210104.csv"}),
+             boost::test_tools::per_element());
+
+  tree.touch("2021/20210601/bars.csv");
+  fs::remove(tree.root / "quotes.20210105.csv");
+  BOOST_TEST(index.refresh());
+  BOOST_TEST(index.size() == 6u);
+  BOOST_TEST(index.files(20210105).empty());
+  BOOST_TEST(index.files(20210601).size() == 3u);
+
+  fs::remove_all(tree.root / "2022");
+  BOOST_TEST(index.refresh());
+  BOOST_TEST(index.last_date() == 20210601);
+
+  BOOST_CHECK_THROW(DatePartitionIndex((tree.root / "missing").string()), elf_error);
+}
+
+BOOST_AUTO_TEST_CASE(date_partition_index_unstatable_entry) {
+  // a symlink loop fails to stat; it is skipped and the listing carries on
+  TempTree tree;
+  fs::create_symlink("a.20210103.csv", tree.root / "a.20210103.csv");
+  tree.touch("b.20210104.csv");
+  tree.touch("c.20210105.csv");
+
+  DatePartitionIndex index(tree.root.string());
+  const std::vector<std::string> expected{"b.20210104.csv", "c.20210105.csv"};
+  BOOST_TEST(paths(index.files(20210101, 20210131)) == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(date_partition_index_symlinks) {
+  // a dated link to a directory is neither followed nor taken for a file;
+  // a link to a file is indexed
+  TempTree tree;
+  tree.touch("store/trades.20220303.csv");
+  tree.touch("quotes.20220301.csv");
+  fs::create_directory_symlink(tree.root / "store", tree.root / "20220304");
+  fs::create_symlink(tree.root / "quotes.20220301.csv", tree.root / "quotes.20220302.csv");
+
+  DatePartitionIndex index(tree.root.string());
+  const std::vector<std::string> expected{"quotes.20220301.csv", "quotes.20220302.csv", "store/trades.20220303.csv"};
+  BOOST_TEST(paths(index.files(20220101, 20221231)) == expected, boost::test_tools::per_element());
+  BOOST_TEST(index.files(20220304).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,10 +1,16 @@
 #include "elf_time.h"
 #include "elf_exception.h"
+#include "elf_util.h"
 
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
+#include <limits>
 #include <string>
+#include <type_traits>
+#include <vector>
 
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 
@@ -37,6 +43,13 @@ BOOST_AUTO_TEST_CASE(date) {
   BOOST_TEST(d.d() == 4);
 }
 
+BOOST_AUTO_TEST_CASE(date_format) {
+  char buf[Date::max_str_len];
+  BOOST_TEST(std::string(buf, Date(20220304).format_to(buf)) == "20220304");
+  BOOST_TEST(std::string(buf, Date().format_to(buf)) == "-1");
+  BOOST_TEST(fmt::format("{}|{}", Date(20211231), Date()) == "20211231|-1");
+}
+
 BOOST_AUTO_TEST_CASE(test_validate_date) {
   //zero/negative values
   BOOST_TEST(validate_date(0) == false);
@@ -60,6 +73,103 @@ BOOST_AUTO_TEST_CASE(test_validate_date) {
   BOOST_TEST(validate_date(20210831) == true);
 }
 
+BOOST_AUTO_TEST_CASE(date_arithmetic) {
+  static_assert(days_from_date(19700101) == 0);
+  static_assert(date_from_days(-1) == 19691231);
+  static_assert(days_from_civil(2000, 3, 1) == 11017);
+  static_assert(validate_date(20240229) && !validate_date(20230229));
+
+  Date d(20220304);
+  BOOST_TEST(d.to_days() == 19055);
+  BOOST_TEST(Date::from_days(19055) == 20220304);
+  BOOST_TEST(d.weekday() == 5);
+  BOOST_TEST(Date(19700101).weekday() == 4);
+  BOOST_TEST(d.day_of_year() == 63);
+  BOOST_TEST(Date(20201231).day_of_year() == 366);
+  BOOST_TEST(d.add_days(-63) == 20211231);
+  BOOST_TEST(Date(20200228).add_days(1) == 20200229);
+  BOOST_TEST(Date(20200228).add_days(2) == 20200301);
+  BOOST_TEST(d.add_days(365) == 20230304);
+  BOOST_TEST(Date(20230304) - d == 365);
+  BOOST_TEST(Date(20000101) - Date(20010101) == -366);
+  BOOST_CHECK_THROW(Date().add_days(1), elf_error);
+  BOOST_CHECK_THROW(Date().weekday(), elf_error);
+
+  // every day number maps to a valid, increasing date and back
+  // (~3M days, so stop at the first bad one rather than assert each)
+  date_t prev = 19691231;
+  for(days_t days = 0; days <= days_from_date(99981231); ++days) {
+    const date_t date = date_from_days(days);
+    if(date <= prev || !validate_date(date) || days_from_date(date) != days) {
+      BOOST_ERROR("days " << days << " gives " << date << " after " << prev << ", back to " << days_from_date(date));
+      break;
+    }
+    prev = date;
+  }
+  BOOST_TEST(prev == 99981231);
+
+  // the ends of the date_t range, and past them
+  static_assert(date_from_days(max_date_days) == 2147471231);
+  static_assert(date_from_days(min_date_days) == -2147479899);
+  static_assert(days_from_date(2147471231) == max_date_days);
+  static_assert(date_from_days(max_date_days + 1) == INVALID_DATE);
+  static_assert(date_from_days(min_date_days - 1) == INVALID_DATE);
+  BOOST_TEST(date_from_days(std::numeric_limits<days_t>::max()) == INVALID_DATE);
+  BOOST_TEST(date_from_days(std::numeric_limits<days_t>::min()) == INVALID_DATE);
+  const days_t ends[] = { min_date_days - 1, min_date_days, max_date_days, max_date_days + 1,
+                          std::numeric_limits<days_t>::min(), std::numeric_limits<days_t>::max(), 0, -1 };
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    date_t bulk[std::size(ends)];
+    dates_from_days(ends, std::size(ends), bulk);
+    for(size_t i = 0; i < std::size(ends); ++i)
+      BOOST_TEST(bulk[i] == date_from_days(ends[i]), "simd " << int(level) << " days " << ends[i]);
+  }
+  set_simd_level(detected);
+}
+
+BOOST_AUTO_TEST_CASE(date_bulk_convert) {
+  std::vector<date_t> dates;
+  std::srand(7);
+  for(int i = 0; i < 1001; ++i) {
+    date_t date = date_from_days(std::rand() % 3000000);
+    switch(std::rand() % 6) {
+    case 0: date += std::rand() % 40; break;
+    case 1: date = date / 10000 * 10000 + 200 + std::rand() % 32; break;
+    case 2: date = std::rand() % 4 ? date / 10000 * 10000 + 1300 + std::rand() % 10: -date; break;
+    default: break;
+    }
+    dates.push_back(date);
+  }
+  dates[0] = 19700101;
+  dates[1] = 99981231;
+  dates[2] = 19691231;
+  dates[3] = 99990101;
+
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::avx2}) {
+    set_simd_level(level);
+    std::vector<days_t> days(dates.size());
+    std::vector<uint64_t> bad((dates.size() + 63) / 64);
+    size_t n_bad = days_from_dates(dates.data(), dates.size(), days.data(), bad.data());
+    size_t n_expected_bad = 0;
+    for(size_t i = 0; i < dates.size(); ++i) {
+      const bool valid = validate_date(dates[i]);
+      n_expected_bad += !valid;
+      BOOST_TEST(((bad[i / 64] >> (i % 64)) & 1) == !valid);
+      BOOST_TEST(days[i] == (valid ? days_from_date(dates[i]) : 0));
+    }
+    BOOST_TEST(n_bad == n_expected_bad);
+
+    std::vector<date_t> round_trip(dates.size());
+    dates_from_days(days.data(), days.size(), round_trip.data());
+    for(size_t i = 0; i < dates.size(); ++i)
+      BOOST_TEST(round_trip[i] == (validate_date(dates[i]) ? dates[i] : 19700101));
+  }
+  set_simd_level(detected);
+}
+
 BOOST_AUTO_TEST_CASE(test_date_pattern) {
   BOOST_CHECK_THROW(elf::find_date_from_file("test.csv"), elf_error);
   BOOST_CHECK_THROW(elf::find_date_from_file("test.csv", 10), elf_error);
@@ -96,6 +206,201 @@ BOOST_AUTO_TEST_CASE(elf_timestamp) {
   BOOST_TEST(ts8.to_hms_msec() == "12:37:51.048");
 }
 
+BOOST_AUTO_TEST_CASE(timestamp_convert) {
+  using namespace TimeConstants;
+  Timestamp ts;
+
+  const char buf[] = "xx09:30:00.250yy";
+  BOOST_TEST(ts.convert(buf+2, 12) == 9*ticks_per_hour + 30*ticks_per_minute + 250*ticks_per_msec);
+  BOOST_TEST(ts.convert(std::string_view(buf+2, 8)) == 9*ticks_per_hour + 30*ticks_per_minute);
+  BOOST_TEST(ts.convert("09:30:00.2501") == 9*ticks_per_hour + 30*ticks_per_minute + 250100*ticks_per_usec);
+  BOOST_TEST(ts.convert("24:00:00") == 24*ticks_per_hour);
+  BOOST_TEST(ts.convert("1D00:00:00.000001") == ticks_per_day + 1);
+
+  BOOST_CHECK_THROW(ts.convert(""), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09:30"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09:30:00."), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09:30:00.12"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09:30:00.1234567"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09:61:00"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("09-30-00"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("9:30:00"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("1D09:30:00.123"), elf_error);
+  BOOST_CHECK_THROW(ts.convert("12D09:30:00"), elf_error);
+  BOOST_CHECK_THROW(ts.convert(" 09:30:00"), elf_error);
+}
+
+BOOST_AUTO_TEST_CASE(timestamp_bulk_convert) {
+  // valid rows interleaved with bad digits, separators, ranges and lengths
+  std::vector<std::string> rows;
+  std::srand(42);
+  for(int i = 0; i < 1000; ++i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%02d:%02d:%02d.%06d", std::rand() % 26, std::rand() % 62, std::rand() % 62, std::rand() % 1000000);
+    std::string row = buf;
+    switch(std::rand() % 8) {
+    case 0: row[std::rand() % row.size()] = "x:.9 "[std::rand() % 5]; break;
+    case 1: row.resize(8 + std::rand() % 7); break;
+    case 2: row = "1D" + row; break;
+    default: break;
+    }
+    rows.push_back(row);
+  }
+
+  std::vector<timestamp_t> expected(rows.size());
+  std::vector<bool> expected_bad(rows.size());
+  Timestamp ts;
+  for(size_t i = 0; i < rows.size(); ++i) {
+    try {
+      expected[i] = ts.convert(rows[i]);
+    } catch(const elf_error&) {
+      expected_bad[i] = true;
+    }
+  }
+
+  std::string fixed;
+  std::string packed;
+  std::vector<uint32_t> offsets{0};
+  for(auto& row: rows) {
+    fixed += row;
+    fixed.append(17 - row.size(), ' ');
+    packed += row;
+    offsets.push_back(packed.size());
+  }
+
+  const SimdLevel detected = simd_level();
+  for(auto level: {SimdLevel::scalar, SimdLevel::sse42, SimdLevel::avx2}) {
+    set_simd_level(level);
+    std::vector<timestamp_t> out(rows.size());
+    std::vector<uint64_t> bad((rows.size() + 63) / 64);
+
+    size_t n_bad = convert_timestamps(packed.data(), offsets.data(), rows.size(), out.data(), bad.data());
+    size_t n_expected_bad = 0;
+    for(size_t i = 0; i < rows.size(); ++i) {
+      n_expected_bad += expected_bad[i];
+      BOOST_TEST(out[i] == expected[i]);
+      BOOST_TEST(((bad[i / 64] >> (i % 64)) & 1) == expected_bad[i]);
+    }
+    BOOST_TEST(n_bad == n_expected_bad);
+
+    // fixed-width column of 15 byte rows padded to a 17 byte stride
+    std::string column;
+    std::vector<size_t> index;
+    for(size_t i = 0; i < rows.size(); ++i) {
+      if(rows[i].size() == 15) {
+        column += fixed.substr(i * 17, 17);
+        index.push_back(i);
+      }
+    }
+    n_bad = convert_timestamps(column.data(), 15, 17, index.size(), out.data(), bad.data());
+    n_expected_bad = 0;
+    for(size_t j = 0; j < index.size(); ++j) {
+      n_expected_bad += expected_bad[index[j]];
+      BOOST_TEST(out[j] == expected[index[j]]);
+      BOOST_TEST(((bad[j / 64] >> (j % 64)) & 1) == expected_bad[index[j]]);
+    }
+    BOOST_TEST(n_bad == n_expected_bad);
+  }
+  set_simd_level(detected);
+}
+
+BOOST_AUTO_TEST_CASE(timestamp_go_ts) {
+  using namespace TimeConstants;
+  const timestamp_t tod = 10*ticks_per_hour + 45*ticks_per_minute + 28*ticks_per_second + 93817;
+
+  Timestamp ts;
+  ts.from_go_ts("20220203-104528.093817");
+  BOOST_TEST(ts == tod);
+
+  Date date;
+  ts.from_go_ts(std::string("20220203-235959.999999"), date);
+  BOOST_TEST(date == 20220203);
+  BOOST_TEST(ts == ticks_per_day - 1);
+
+  BOOST_TEST(epoch_from_go_ts("20220203-104528.093817") == Date(20220203).to_days() * ticks_per_day + tod);
+  BOOST_TEST(epoch_from_go_ts("19700101-000000.000000") == 0u);
+
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203-104528.09381"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203 104528.093817"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203-104528:093817"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("2022020x-104528.093817"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203-1045/8.093817"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203-104528.0938a7"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220230-104528.093817"), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220203-106528.093817"), elf_error);
+
+  // a rejected string leaves the date and time untouched
+  BOOST_CHECK_THROW(ts.from_go_ts("20220230-104528.093817", date), elf_error);
+  BOOST_CHECK_THROW(ts.from_go_ts("20220204-256528.093817", date), elf_error);
+  BOOST_TEST(date == 20220203);
+  BOOST_TEST(ts == ticks_per_day - 1);
+
+  const char column[] = "20220203-104528.093817,20220204-000000.000001,20220204-250000.000000,";
+  timestamp_t out[3];
+  uint64_t bad[1];
+  BOOST_TEST(convert_go_timestamps(column, go_ts_len + 1, 3, out, bad) == 1u);
+  BOOST_TEST(bad[0] == 4u);
+  BOOST_TEST(out[0] == epoch_from_go_ts("20220203-104528.093817"));
+  BOOST_TEST(out[1] == (Date(20220204).to_days() * ticks_per_day + 1));
+  BOOST_TEST(out[2] == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(time_literals) {
+  using namespace TimeConstants;
+  static_assert("09:30:00"_ts == 9 * ticks_per_hour + 30 * ticks_per_minute);
+  static_assert("1D00:00:01.000001"_ts == ticks_per_day + ticks_per_second + 1);
+  static_assert("5min"_td == static_cast<timedelta_t>(5 * ticks_per_minute));
+  static_assert("-1hour30min"_td == -static_cast<timedelta_t>(90 * ticks_per_minute));
+  static_assert("1.5sec"_td == 1500000);
+  static_assert(20220304_d == 20220304);
+  static_assert(2022'03'04_d == 20220304);
+
+  constexpr Timestamp open = "09:30:00"_ts;
+  BOOST_TEST(open.get() == Timestamp("09:30:00").get());
+  BOOST_TEST(timedelta_t("-00:00:01.250"_td) == Timedelta().convert("-00:00:01.250"));
+  BOOST_TEST((20240229_d).weekday() == 4);
+
+  // the compile-time scanners accept and reject exactly what convert does
+  const char* timestamps[] = {
+    "09:30:00", "23:59:59.999999", "24:00:00", "24:60:60", "25:00:00", "09:61:00", "09:30:00.1",
+    "09:30:00.123", "09:30:00.1234567", "09:30:00.", "9:30:00", "09-30-00", "09:30:0a", "2D09:30:00.000001",
+    "2D09:30:00.001", "xD09:30:00", "", "09:30", "09:30:00 ",
+  };
+  for(const char* s: timestamps) {
+    const auto r = detail::parse_timestamp_literal(s, strlen(s));
+    timestamp_t expected = 0;
+    bool ok = true;
+    try {
+      expected = Timestamp().convert(s);
+    } catch(const elf_error&) {
+      ok = false;
+    }
+    BOOST_TEST(r.ok == ok, s);
+    if(ok)
+      BOOST_TEST(static_cast<timestamp_t>(r.value) == expected, s);
+  }
+
+  const char* timedeltas[] = {
+    "5min", "-5min", "1hour30min", "30min1hour", "1.5sec", "0.0000001sec", "1.5usec", "2msec500usec",
+    "00:00:01.250", "-00:00:01", "24:00:00.5", "", "-", "min", "5", "5mins", "5.min", "1hour1hour",
+    "9223372036854usec", "92233720368547758070usec", "2562047hour", "2562048hour",
+    "9223372036854775807usec", "9223372036854775808usec", "0009223372036854775807usec",
+  };
+  for(const char* s: timedeltas) {
+    const auto r = detail::parse_timedelta_literal(s, strlen(s));
+    timedelta_t expected = 0;
+    bool ok = true;
+    try {
+      expected = Timedelta().convert(s);
+    } catch(const elf_error&) {
+      ok = false;
+    }
+    BOOST_TEST(r.ok == ok, s);
+    if(ok)
+      BOOST_TEST(r.value == expected, s);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(elf_timedelta) {
   using namespace TimeConstants;
 
@@ -123,4 +428,231 @@ BOOST_AUTO_TEST_CASE(elf_timedelta) {
   BOOST_TEST(diff2 == -1 * (int)(35*ticks_per_minute + 15*ticks_per_second));
 }
 
+BOOST_AUTO_TEST_CASE(time_format) {
+  using namespace TimeConstants;
+  char buf[Timestamp::max_str_len];
+
+  Timestamp ts(9*ticks_per_hour + 5*ticks_per_minute + 7*ticks_per_second + 42*ticks_per_usec);
+  BOOST_TEST(std::string(buf, ts.format_to(buf)) == "09:05:07.000042");
+  BOOST_TEST(std::string(buf, ts.format_to(buf, false)) == "09:05:07");
+  BOOST_TEST(std::string(buf, ts.format_hms_to(buf)) == "09:05:07");
+  BOOST_TEST(std::string(buf, ts.format_hms_msec_to(buf)) == "09:05:07.000");
+  BOOST_TEST(Timestamp(12*ticks_per_day + 1).str() == "12D00:00:00.000001");
+  BOOST_TEST(Timestamp(2*ticks_per_day + ticks_per_hour + 999*ticks_per_msec).to_hms_msec() == "01:00:00.999");
+
+  BOOST_TEST(Timedelta((timedelta_t)0).str() == "0usec");
+  BOOST_TEST(Timedelta((timedelta_t)-999).str() == "-999usec");
+  BOOST_TEST(Timedelta((timedelta_t)(25*ticks_per_msec)).str() == "25msec");
+  BOOST_TEST(Timedelta((timedelta_t)(59*ticks_per_second)).str() == "59sec");
+  BOOST_TEST(Timedelta((timedelta_t)(90*ticks_per_minute)).str() == "01:30:00");
+  BOOST_TEST(Timedelta(-(timedelta_t)(ticks_per_minute + 1)).str() == "-00:01:00.000001");
+  BOOST_TEST(Timedelta((timedelta_t)(123*ticks_per_hour + 1)).str() == "123:00:00.000001");
+  BOOST_TEST(Timedelta((timedelta_t)(123*ticks_per_hour + 1)).to_hms() == "123:00:00");
+
+  BOOST_TEST(fmt::format("{} {}", ts, Timedelta("5min")) == "09:05:07.000042 00:05:00");
+  fmt::memory_buffer out;
+  fmt::format_to(std::back_inserter(out), "{},", Timestamp(ticks_per_hour));
+  BOOST_TEST(fmt::to_string(out) == "01:00:00.000000,");
+
+  const timestamp_t column[] = { ts, ticks_per_day, 0 };
+  char bulk[3 * (Timestamp::max_str_len + 1)];
+  const size_t n = format_timestamps(column, 3, bulk);
+  BOOST_TEST(std::string(bulk, n) == "09:05:07.000042\n1D00:00:00.000000\n00:00:00.000000\n");
+  BOOST_TEST(std::string(bulk, format_timestamps(column, 2, bulk, ',', false)) == "09:05:07,1D00:00:00,");
+}
+
+BOOST_AUTO_TEST_CASE(timedelta_convert) {
+  using namespace TimeConstants;
+  Timedelta td;
+
+  BOOST_TEST(td.convert("250usec") == 250);
+  BOOST_TEST(td.convert("2hour") == (timedelta_t)(2*ticks_per_hour));
+  BOOST_TEST(td.convert("-00:01:30") == -(timedelta_t)(90*ticks_per_second));
+  BOOST_TEST(td.convert("00:00:01.500000") == (timedelta_t)(1500*ticks_per_msec));
+  BOOST_TEST(td.convert("1hour30min") == (timedelta_t)(90*ticks_per_minute));
+  BOOST_TEST(td.convert("-1min5sec250msec") == -(timedelta_t)(65250*ticks_per_msec));
+  BOOST_TEST(td.convert("1.5sec") == (timedelta_t)(1500*ticks_per_msec));
+  BOOST_TEST(td.convert("0.25hour") == (timedelta_t)(15*ticks_per_minute));
+  BOOST_TEST(td.convert(std::string_view("10sec, 5min", 5)) == (timedelta_t)(10*ticks_per_second));
+
+  BOOST_CHECK_THROW(td.convert(""), elf_error);
+  BOOST_CHECK_THROW(td.convert("-"), elf_error);
+  BOOST_CHECK_THROW(td.convert("5"), elf_error);
+  BOOST_CHECK_THROW(td.convert("min"), elf_error);
+  BOOST_CHECK_THROW(td.convert("5mins"), elf_error);
+  BOOST_CHECK_THROW(td.convert("30min1hour"), elf_error);
+  BOOST_CHECK_THROW(td.convert("1min1min"), elf_error);
+  BOOST_CHECK_THROW(td.convert("1.5usec"), elf_error);
+  BOOST_CHECK_THROW(td.convert("1.sec"), elf_error);
+  BOOST_CHECK_THROW(td.convert("25:00:00"), elf_error);
+  BOOST_CHECK_THROW(td.convert("99999999999hour"), elf_error);
+  BOOST_CHECK_THROW(td.convert("--5min"), elf_error);
+}
+
+namespace {
+  template <typename A, typename B, typename = void>
+  struct can_subtract : std::false_type {};
+  template <typename A, typename B>
+  struct can_subtract<A, B, std::void_t<decltype(std::declval<A>() - std::declval<B>())>> : std::true_type {};
+
+  template <typename A, typename B, typename = void>
+  struct can_add : std::false_type {};
+  template <typename A, typename B>
+  struct can_add<A, B, std::void_t<decltype(std::declval<A>() + std::declval<B>())>> : std::true_type {};
+
+  template <typename A, typename B, typename = void>
+  struct can_compare : std::false_type {};
+  template <typename A, typename B>
+  struct can_compare<A, B, std::void_t<decltype(std::declval<A>() < std::declval<B>()),
+                                       decltype(std::declval<A>() == std::declval<B>())>> : std::true_type {};
+}
+
+BOOST_AUTO_TEST_CASE(nano_resolution) {
+  // mixing resolutions in arithmetic or comparisons does not compile
+  static_assert(can_subtract<NanoTimestamp, NanoTimestamp>::value);
+  static_assert(!can_subtract<NanoTimestamp, Timestamp>::value);
+  static_assert(!can_subtract<Timestamp, NanoTimestamp>::value);
+  static_assert(!can_subtract<NanoTimestamp, Timedelta>::value);
+  static_assert(!can_subtract<NanoTimedelta, Timedelta>::value);
+  static_assert(can_add<NanoTimestamp, NanoTimedelta>::value);
+  static_assert(can_add<Timestamp, Timedelta>::value);
+  static_assert(!can_add<Timestamp, NanoTimedelta>::value);
+  static_assert(!can_add<NanoTimestamp, Timedelta>::value);
+  static_assert(!can_add<Timedelta, NanoTimedelta>::value);
+  static_assert(can_compare<Timestamp, Timestamp>::value);
+  static_assert(can_compare<Timestamp, timestamp_t>::value);
+  static_assert(!can_compare<Timestamp, NanoTimestamp>::value);
+  static_assert(!can_compare<NanoTimedelta, Timedelta>::value);
+  static_assert(timedelta_t(NanoTimestamp(Timestamp(2)) - NanoTimestamp(1)) == 1999);
+
+  // widening is implicit, narrowing only through resolution_cast
+  static_assert(std::is_convertible_v<Timestamp, NanoTimestamp>);
+  static_assert(!std::is_constructible_v<Timestamp, NanoTimestamp>);
+  static_assert(std::is_convertible_v<Timedelta, NanoTimedelta>);
+  static_assert(!std::is_constructible_v<Timedelta, NanoTimedelta>);
+  static_assert(NanoTimestamp(Timestamp(7)).get() == 7000);
+  static_assert(resolution_cast<Micros>(NanoTimestamp(7999)).get() == 7);
+  static_assert(timedelta_t(resolution_cast<Micros>(NanoTimedelta(timedelta_t(-7999)))) == -7);
+  static_assert(sizeof(NanoTimestamp) == sizeof(timestamp_t));
+
+  const NanoTimestamp ts("09:30:00.123456789");
+  BOOST_TEST(ts.get() == 9 * Nanos::ticks_per_hour + 30 * Nanos::ticks_per_minute + 123456789);
+  BOOST_TEST(ts.str() == "09:30:00.123456789");
+  BOOST_TEST(ts.str(false) == "09:30:00");
+  BOOST_TEST(ts.to_hms_msec() == "09:30:00.123");
+  BOOST_TEST(NanoTimestamp("09:30:00.500").str() == "09:30:00.500000000");
+  BOOST_TEST(NanoTimestamp("1D00:00:00.000001").get() == Nanos::ticks_per_day + 1000);
+  BOOST_TEST(fmt::format("{}", NanoTimestamp(Timestamp("09:30:00.000001"))) == "09:30:00.000001000");
+  BOOST_TEST(resolution_cast<Micros>(ts).str() == "09:30:00.123456");
+
+  // nine digits at microsecond resolution only when they land on a tick
+  BOOST_TEST(Timestamp("09:30:00.123456000").get() == Timestamp("09:30:00.123456").get());
+  BOOST_CHECK_THROW(Timestamp("09:30:00.123456789"), elf_error);
+  BOOST_CHECK_THROW(NanoTimestamp("09:30:00.1234567890"), elf_error);
+
+  NanoTimestamp go;
+  Date date;
+  go.from_go_ts("20220203-104528.093817123", date);
+  BOOST_TEST(date == 20220203);
+  BOOST_TEST(go.str() == "10:45:28.093817123");
+  go.from_go_ts("20220203-104528.093817");
+  BOOST_TEST(go.str() == "10:45:28.093817000");
+  Timestamp micro_go;
+  BOOST_CHECK_THROW(micro_go.from_go_ts("20220203-104528.093817123"), elf_error);
+
+  NanoTimedelta td;
+  BOOST_TEST(td.convert("250nsec") == 250);
+  BOOST_TEST(td.convert("1.5usec") == 1500);
+  BOOST_TEST(td.convert("1hour0.000000001sec") == timedelta_t(Nanos::ticks_per_hour + 1));
+  BOOST_TEST(td.convert("0.000000001hour") == 3600);
+  BOOST_TEST(td.convert("-00:00:01.000000001") == -timedelta_t(Nanos::ticks_per_second + 1));
+  BOOST_CHECK_THROW(Timedelta().convert("250nsec"), elf_error);
+  BOOST_TEST(NanoTimedelta(timedelta_t(999)).str() == "999nsec");
+  BOOST_TEST(NanoTimedelta(timedelta_t(-1500)).str() == "-1usec");
+  BOOST_TEST(NanoTimedelta(timedelta_t(Nanos::ticks_per_minute + 1)).str() == "00:01:00.000000001");
+  BOOST_TEST(timedelta_t(ts - NanoTimestamp("09:30:00")) == 123456789);
+  BOOST_TEST((NanoTimestamp("09:30:00") + NanoTimedelta("5min")).str() == "09:35:00.000000000");
+
+  // the compile-time scanners agree at nanosecond resolution too
+  for(const char* s: { "09:30:00.123456789", "09:30:00.1234567", "1D09:30:00.000001", "09:30:00.1234567890" }) {
+    const auto r = detail::parse_timestamp_literal<Nanos>(s, strlen(s));
+    bool ok = true;
+    timestamp_t expected = 0;
+    try {
+      expected = NanoTimestamp().convert(s);
+    } catch(const elf_error&) {
+      ok = false;
+    }
+    BOOST_TEST(r.ok == ok, s);
+    BOOST_TEST(static_cast<timestamp_t>(r.ok ? r.value : 0) == expected, s);
+  }
+  for(const char* s: { "250nsec", "1.5usec", "1sec1nsec", "0.1nsec", "-00:00:00.000000001" }) {
+    const auto r = detail::parse_timedelta_literal<Nanos>(s, strlen(s));
+    bool ok = true;
+    timedelta_t expected = 0;
+    try {
+      expected = NanoTimedelta().convert(s);
+    } catch(const elf_error&) {
+      ok = false;
+    }
+    BOOST_TEST(r.ok == ok, s);
+    BOOST_TEST((r.ok ? r.value : 0) == expected, s);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(try_parse) {
+  using namespace TimeConstants;
+  const auto d = Date::try_parse("20220304");
+  BOOST_TEST(d.ok());
+  BOOST_TEST(d.value == 20220304);
+  BOOST_TEST((Date::try_parse("2022034").status == ParseStatus::bad_format));
+  BOOST_TEST((Date::try_parse("2022030x").status == ParseStatus::bad_format));
+  BOOST_TEST((Date::try_parse("20220230").status == ParseStatus::out_of_bounds));
+  BOOST_CHECK_THROW(Date("20220230"), elf_error);
+
+  const auto ts = Timestamp::try_parse("09:30:00.250");
+  BOOST_TEST(ts.ok());
+  BOOST_TEST(ts.value.get() == 9 * ticks_per_hour + 30 * ticks_per_minute + 250 * ticks_per_msec);
+  BOOST_TEST(!Timestamp::try_parse("09:30"));
+  BOOST_TEST((Timestamp::try_parse("09:61:00").status == ParseStatus::out_of_bounds));
+  BOOST_TEST((NanoTimestamp::try_parse("09:30:00.000000001").value.get() == 9 * Nanos::ticks_per_hour + 30 * Nanos::ticks_per_minute + 1));
+
+  BOOST_TEST(timedelta_t(Timedelta::try_parse("-5min").value) == -timedelta_t(5 * ticks_per_minute));
+  BOOST_TEST((Timedelta::try_parse("").status == ParseStatus::bad_format));
+  BOOST_TEST((Timedelta::try_parse("99999999999hour").status == ParseStatus::out_of_bounds));
+  // whole parts up to INT64_MAX ticks, however many digits
+  BOOST_TEST(timedelta_t(Timedelta::try_parse("9223372036854775807usec").value) == std::numeric_limits<timedelta_t>::max());
+  BOOST_TEST(timedelta_t(NanoTimedelta::try_parse("9223372036854775807nsec").value) == std::numeric_limits<timedelta_t>::max());
+  BOOST_TEST((Timedelta::try_parse("9223372036854775808usec").status == ParseStatus::out_of_bounds));
+  BOOST_TEST((Timedelta::try_parse("9223372036854775807usec1nsec").status == ParseStatus::bad_format));
+
+  BOOST_TEST(try_find_date_from_file("quotes.20220304.csv").value == 20220304);
+  BOOST_TEST(try_find_date_from_file("quotes.csv", 20220304).value == 20220304);
+  BOOST_TEST((try_find_date_from_file("quotes.csv").status == ParseStatus::bad_format));
+  BOOST_TEST((try_find_date_from_file("quotes.20221304.csv").status == ParseStatus::out_of_bounds));
+  BOOST_TEST(try_epoch_from_go_ts("20220203-104528.093817").value == epoch_from_go_ts("20220203-104528.093817"));
+  BOOST_TEST((try_epoch_from_go_ts("20220230-104528.093817").status == ParseStatus::out_of_bounds));
+  BOOST_TEST(std::string(to_string(ParseStatus::bad_format)) == "bad format");
+
+  // fields "20220304", "x", "20221301", "20240229"
+  const std::string dates = "20220304x2022130120240229";
+  const uint32_t date_offsets[] = { 0, 8, 9, 17, 25 };
+  date_t date_out[4];
+  uint64_t bad[1];
+  BOOST_TEST(convert_dates(dates.data(), date_offsets, 4, date_out, bad) == 2u);
+  BOOST_TEST(bad[0] == 0b0110u);
+  BOOST_TEST(date_out[0] == 20220304);
+  BOOST_TEST(date_out[1] == 0);
+  BOOST_TEST(date_out[3] == 20240229);
+
+  // fields "5min", "", "1.5usec", "-00:00:01"
+  const std::string deltas = "5min1.5usec-00:00:01";
+  const uint32_t delta_offsets[] = { 0, 4, 4, 11, 20 };
+  timedelta_t delta_out[4];
+  BOOST_TEST(convert_timedeltas(deltas.data(), delta_offsets, 4, delta_out, bad) == 2u);
+  BOOST_TEST(bad[0] == 0b0110u);
+  BOOST_TEST(delta_out[0] == timedelta_t(5 * ticks_per_minute));
+  BOOST_TEST(delta_out[3] == -timedelta_t(ticks_per_second));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
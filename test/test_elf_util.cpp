@@ -0,0 +1,288 @@
+#include "elf_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace elf;
+
+namespace {
+  // reference parse of a fixed-width field through the runtime-length loop
+  template<size_t N>
+  void
+  check_fixed_width(const std::string& s) {
+    BOOST_REQUIRE(s.size() == N);
+    int64_t expected = 0;
+    const bool expected_ok = substring_atoi(s.data(), N, expected);
+
+    int64_t n = 0;
+    BOOST_TEST(substring_atoi<N>(s.data(), n) == expected_ok, s);
+    if(expected_ok)
+      BOOST_TEST(n == expected, s);
+
+    const bool all_digits = std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+    uint64_t u = 0;
+    BOOST_TEST(substring_atoi<N>(s.data(), u) == all_digits, s);
+    if(all_digits)
+      BOOST_TEST(u == static_cast<uint64_t>(expected), s);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(elf_util)
+
+BOOST_AUTO_TEST_CASE(test_num_digits) {
+  static_assert(num_digits(0) == 1);
+  static_assert(num_digits(20220203) == 8);
+  static_assert(num_digits(std::numeric_limits<uint64_t>::max()) == 20);
+
+  BOOST_TEST(num_digits(0) == 1u);
+  uint64_t p = 1;
+  for(size_t digits = 1; digits <= 20; ++digits, p *= 10) {
+    BOOST_TEST(num_digits(p) == digits, p);
+    BOOST_TEST(num_digits(p + 1) == digits, p + 1);
+    if(p > 1)
+      BOOST_TEST(num_digits(p - 1) == digits - 1, p - 1);
+    if(digits < 20) {
+      BOOST_TEST(num_digits(p * 10 - 1) == digits, p * 10 - 1);
+    }
+  }
+  BOOST_TEST(num_digits(std::numeric_limits<uint64_t>::max()) == 20u);
+
+  // every bit width, against the decimal string
+  for(int bits = 0; bits < 64; ++bits) {
+    for(uint64_t v: {uint64_t(1) << bits, (uint64_t(1) << bits) - 1, (uint64_t(2) << bits) - 1})
+      BOOST_TEST(num_digits(v) == std::to_string(v).size(), v);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(substring_atoi_fixed) {
+  check_fixed_width<1>("7");
+  check_fixed_width<1>("x");
+  check_fixed_width<2>("09");
+  check_fixed_width<2>("9:");
+  check_fixed_width<2>("-5");
+  check_fixed_width<2>(" 5");
+  check_fixed_width<4>("2022");
+  check_fixed_width<4>("20/2");
+  check_fixed_width<6>("093817");
+  check_fixed_width<6>("  -120");
+  check_fixed_width<8>("20220203");
+  check_fixed_width<8>("99999999");
+  check_fixed_width<8>("2022020a");
+  check_fixed_width<8>("+0000001");
+  check_fixed_width<12>("123456789012");
+  check_fixed_width<12>("12345678901.");
+  check_fixed_width<16>("1234567890123456");
+  check_fixed_width<16>("9999999999999999");
+  check_fixed_width<16>("0000000000000000");
+  check_fixed_width<16>("123456789012345/");
+  check_fixed_width<16>(":234567890123456");
+  check_fixed_width<16>("-123456789012345");
+
+  // every byte position of the 16-wide kernel rejects a non-digit
+  for(size_t i = 0; i < 16; ++i) {
+    for(char c: {'/', ':', ' ', '\0', '\xb0'}) {
+      std::string s(16, '5');
+      s[i] = c;
+      uint64_t u;
+      BOOST_TEST(!substring_atoi<16>(s.data(), u));
+    }
+  }
+
+  // field width is bounded by what the output type can hold
+  uint32_t date = 0;
+  BOOST_TEST(substring_atoi<8>("20220203", date));
+  BOOST_TEST(date == 20220203u);
+}
+
+BOOST_AUTO_TEST_CASE(substring_atod_locale) {
+  // the decimal point is '.' whatever LC_NUMERIC says; the slow path is
+  // taken for 17 significant digits and for very long fields
+  const std::string old_locale = ::setlocale(LC_NUMERIC, nullptr);
+  const char* comma_locale = nullptr;
+  for(const char* name: {"de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR"}) {
+    if(::setlocale(LC_NUMERIC, name)) {
+      comma_locale = name;
+      break;
+    }
+  }
+  if(!comma_locale)
+    BOOST_TEST_MESSAGE("no comma-decimal locale installed; parsing under " << old_locale);
+
+  const std::string long_field = "1." + std::string(300, '0') + "1";
+  errno = EDOM;
+  double d = 0;
+  BOOST_TEST(substring_atod("1.2345678901234567", 18, d));
+  BOOST_TEST(d == 1.2345678901234567);
+  BOOST_TEST(substring_atod(long_field.data(), long_field.size(), d));
+  BOOST_TEST(d == 1.0);
+  BOOST_TEST(substring_atod("4.9406564584124654e-320", 23, d));
+  BOOST_TEST(d == 4.9406564584124654e-320);
+  BOOST_TEST(errno == EDOM);
+  ::setlocale(LC_NUMERIC, old_locale.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(substring_atod_rounding) {
+  auto atod = [](const std::string& s) {
+    double d = -1;
+    BOOST_REQUIRE_MESSAGE(substring_atod(s.data(), s.size(), d), s);
+    return d;
+  };
+
+  BOOST_TEST(atod("0") == 0.0);
+  BOOST_TEST(atod("-0.0") == 0.0);
+  BOOST_TEST(std::signbit(atod("-0.0")));
+  BOOST_TEST(atod("  +12.5") == 12.5);
+  BOOST_TEST(atod("5.") == 5.0);
+  BOOST_TEST(atod(".25") == 0.25);
+  BOOST_TEST(atod("1e3") == 1000.0);
+  BOOST_TEST(atod("1.5E-3") == 0.0015);
+  BOOST_TEST(atod("0e999999999") == 0.0);
+  BOOST_TEST(atod("1.0000000001") == 1.0000000001);
+  BOOST_TEST(atod("101.1234567891") == 101.1234567891);
+  BOOST_TEST(atod("0.1") == 0.1);
+  BOOST_TEST(atod("9007199254740993") == 9007199254740992.0);
+  BOOST_TEST(atod("9007199254740993.0000000001") == 9007199254740994.0);
+  BOOST_TEST(atod("2.2250738585072014e-308") == 2.2250738585072014e-308);
+  BOOST_TEST(atod("1.7976931348623157e308") == 1.7976931348623157e308);
+  BOOST_TEST(atod(std::string("12.5\0junk", 9)) == 12.5);
+
+  double d = 7;
+  for(const char* s: {"", " ", "-", ".", "-.", "1..2", "1.2.3", "1e", "1e+", "e5", "1.5x", "0x10", "inf", "nan", "1e400"})
+    BOOST_TEST(!substring_atod(s, strlen(s), d), s);
+  BOOST_TEST(d == 7.0);
+
+  // random prices and random bit patterns round trip to the same double as strtod
+  std::mt19937_64 rng(11);
+  for(int i = 0; i < 200000; ++i) {
+    std::string s;
+    if(i % 2) {
+      s = fmt::format("{}.{:0{}}", rng() % 100000, rng() % 10000000000, 1 + rng() % 10);
+    } else {
+      double v;
+      const uint64_t bits = (rng() & ~(uint64_t(0x7ff) << 52)) | (uint64_t(rng() % 2046) << 52);
+      memcpy(&v, &bits, sizeof(v));
+      s = fmt::format("{:.{}e}", v, rng() % 20);
+    }
+    double parsed = 0;
+    BOOST_TEST(substring_atod(s.data(), s.size(), parsed), s);
+    BOOST_TEST(parsed == std::strtod(s.c_str(), nullptr), s);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(convert_doubles_bulk) {
+  // fields "1.25", "x", "-3e2", "", "0.1"
+  const std::string buf = "1.25x-3e20.1";
+  const uint32_t offsets[] = { 0, 4, 5, 9, 9, 12 };
+  double out[5];
+  uint64_t bad[1];
+  BOOST_TEST(convert_doubles(buf.data(), offsets, 5, out, bad) == 2u);
+  BOOST_TEST(bad[0] == 0b01010u);
+  BOOST_TEST(out[0] == 1.25);
+  BOOST_TEST(out[1] == 0.0);
+  BOOST_TEST(out[2] == -300.0);
+  BOOST_TEST(out[4] == 0.1);
+}
+
+BOOST_AUTO_TEST_CASE(substring_atofixed_scales) {
+  auto fixed4 = [](const std::string& s, int64_t& n) { return substring_atofixed<4>(s.data(), s.size(), n); };
+  int64_t n = 0;
+  BOOST_TEST((fixed4("123.4567", n) && n == 1234567));
+  BOOST_TEST((fixed4("  -0.5", n) && n == -5000));
+  BOOST_TEST((fixed4("+7", n) && n == 70000));
+  BOOST_TEST((fixed4("7.", n) && n == 70000));
+  BOOST_TEST((fixed4(".0001", n) && n == 1));
+  BOOST_TEST((fixed4("1.23450000000000000000", n) && n == 12345));
+  BOOST_TEST((fixed4("000000000000000000000000012.5", n) && n == 125000));
+  BOOST_TEST((fixed4("922337203685477.5807", n) && n == std::numeric_limits<int64_t>::max()));
+  BOOST_TEST((fixed4("-922337203685477.5808", n) && n == std::numeric_limits<int64_t>::min()));
+
+  n = 42;
+  for(const char* s: {"", "-", ".", "1.23456", "922337203685477.5808", "-922337203685477.5809",
+                      "99999999999999999999", "1e3", "1.2.3", "12a"})
+    BOOST_TEST(!fixed4(s, n), s);
+  BOOST_TEST(n == 42);
+
+  // random fields at every runtime scale against 128-bit arithmetic,
+  // including the ones that overflow
+  auto pow10 = [](unsigned e) {
+    __int128 p = 1;
+    while(e--)
+      p *= 10;
+    return p;
+  };
+  std::mt19937_64 rng(12);
+  for(int i = 0; i < 100000; ++i) {
+    const unsigned scale = rng() % (max_fixed_scale + 1);
+    const unsigned n_frac = rng() % (scale + 1);
+    const uint64_t whole = rng() >> (rng() % 64);
+    const uint64_t frac = rng() % static_cast<uint64_t>(pow10(n_frac));
+    const std::string s = n_frac ? fmt::format("{}.{:0{}}", whole, frac, n_frac) : std::to_string(whole);
+    const __int128 expected = whole * pow10(scale) + frac * pow10(scale - n_frac);
+    int64_t fixed = 0;
+    const bool ok = substring_atofixed(s.data(), s.size(), scale, fixed);
+    BOOST_TEST_CONTEXT(s << " scale " << scale) {
+      if(expected > std::numeric_limits<int64_t>::max()) {
+        BOOST_TEST(!ok);
+      } else {
+        BOOST_TEST(ok);
+        BOOST_TEST(fixed == static_cast<int64_t>(expected));
+      }
+    }
+  }
+
+  BOOST_TEST(!substring_atofixed("1", 1, max_fixed_scale + 1, n));
+  BOOST_TEST((substring_atofixed("9.223372036854775807", 20, 18, n) && n == std::numeric_limits<int64_t>::max()));
+  BOOST_TEST(!substring_atofixed("10", 2, 18, n));
+}
+
+BOOST_AUTO_TEST_CASE(convert_fixed_bulk) {
+  // fields "1.25", "x", "-3", "", "0.12345"
+  const std::string buf = "1.25x-30.12345";
+  const uint32_t offsets[] = { 0, 4, 5, 7, 7, 14 };
+  int64_t out[5];
+  uint64_t bad[1];
+  BOOST_TEST(convert_fixed(buf.data(), offsets, 5, 2, out, bad) == 3u);
+  BOOST_TEST(bad[0] == 0b11010u);
+  BOOST_TEST(out[0] == 125);
+  BOOST_TEST(out[2] == -300);
+  BOOST_TEST(out[4] == 0);
+  BOOST_TEST(convert_fixed(buf.data(), offsets, 5, 5, out, bad) == 2u);
+  BOOST_TEST(out[4] == 12345);
+}
+
+BOOST_AUTO_TEST_CASE(divider_matches_division) {
+  std::mt19937_64 rng(17);
+  std::vector<uint64_t> divisors = { 1, 2, 3, 5, 7, 10, 60, 1000, 1000000, 60000000, 86400000000,
+                                     (uint64_t(1) << 63), (uint64_t(1) << 63) + 1, ~uint64_t(0), ~uint64_t(0) - 1 };
+  for(int i = 0; i < 200; ++i)
+    divisors.push_back(rng() >> (rng() % 64) | 1);
+  std::vector<uint64_t> numerators = { 0, 1, 59, 60, 61, ~uint64_t(0), ~uint64_t(0) - 1, uint64_t(1) << 63 };
+  for(int i = 0; i < 200; ++i)
+    numerators.push_back(rng() >> (rng() % 64));
+
+  for(uint64_t d: divisors) {
+    const Divider div(d);
+    BOOST_TEST_CONTEXT("divisor " << d) {
+      BOOST_TEST(div.divisor() == d);
+      for(uint64_t n: numerators)
+        BOOST_TEST(div.divide(n) == n / d, "n " << n);
+      for(uint64_t k: { uint64_t(1), uint64_t(2), uint64_t(1000) }) {
+        if(d <= ~uint64_t(0) / k) {
+          BOOST_TEST(div.divide(d * k) == k);
+          BOOST_TEST(div.divide(d * k - 1) == k - 1);
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()